@@ -0,0 +1,124 @@
+#include "blockSection.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+
+namespace editor::chunk {
+
+
+    /// entries never straddle two u64's, so only power of two widths are used.
+    static u32 getBitsPerEntry(const size_t paletteSize) {
+        if (paletteSize <= 1) { return 0; }
+        if (paletteSize <= 2) { return 1; }
+        if (paletteSize <= 4) { return 2; }
+        if (paletteSize <= 16) { return 4; }
+        if (paletteSize <= 256) { return 8; }
+        return 16;
+    }
+
+
+    void BlockSection::pack(const u16* theBlocks, c_u32 theSectionIndex) {
+        u16 blocks[BLOCK_COUNT];
+        for (u32 x = 0; x < 16; x++) {
+            for (u32 z = 0; z < 16; z++) {
+                std::memcpy(&blocks[x << 8 | z << 4],
+                            &theBlocks[x * 4096 + z * 256 + theSectionIndex * 16], 16 * sizeof(u16));
+            }
+        }
+
+        u16 sorted[BLOCK_COUNT];
+        std::memcpy(sorted, blocks, sizeof(blocks));
+        std::sort(sorted, sorted + BLOCK_COUNT);
+        c_auto sortedEnd = std::unique(sorted, sorted + BLOCK_COUNT);
+        myPalette.assign(sorted, sortedEnd);
+
+        myBitsPerEntry = getBitsPerEntry(myPalette.size());
+        if (myBitsPerEntry == 0) {
+            std::vector<u64>().swap(myIndices);
+            return;
+        }
+
+        c_u32 perWord = 64 / myBitsPerEntry;
+        myIndices.assign(BLOCK_COUNT / perWord, 0);
+        for (u32 index = 0; index < BLOCK_COUNT; index++) {
+            c_u64 paletteIndex = std::lower_bound(myPalette.begin(), myPalette.end(), blocks[index])
+                                 - myPalette.begin();
+            myIndices[index / perWord] |= paletteIndex << (index % perWord * myBitsPerEntry);
+        }
+    }
+
+
+    void BlockSection::unpack(u16* theBlocks, c_u32 theSectionIndex) const {
+        for (u32 x = 0; x < 16; x++) {
+            for (u32 z = 0; z < 16; z++) {
+                u16* column = &theBlocks[x * 4096 + z * 256 + theSectionIndex * 16];
+                if (myBitsPerEntry == 0) {
+                    std::fill_n(column, 16, myPalette[0]);
+                    continue;
+                }
+                for (u32 y = 0; y < 16; y++) {
+                    column[y] = get(x << 8 | z << 4 | y);
+                }
+            }
+        }
+    }
+
+
+    u16 BlockSection::get(c_u32 theIndex) const {
+        if (myBitsPerEntry == 0) {
+            return myPalette[0];
+        }
+        c_u32 perWord = 64 / myBitsPerEntry;
+        c_u64 mask = (1ULL << myBitsPerEntry) - 1;
+        return myPalette[myIndices[theIndex / perWord] >> (theIndex % perWord * myBitsPerEntry) & mask];
+    }
+
+
+    void BlockSection::set(c_u32 theIndex, c_u16 theBlock) {
+        c_auto found = std::find(myPalette.begin(), myPalette.end(), theBlock);
+        c_u64 paletteIndex = found - myPalette.begin();
+        if (found == myPalette.end()) {
+            myPalette.push_back(theBlock);
+            if (c_u32 bitsNeeded = getBitsPerEntry(myPalette.size()); bitsNeeded != myBitsPerEntry) {
+                repack(bitsNeeded);
+            }
+        }
+        if (myBitsPerEntry == 0) {
+            return;
+        }
+
+        c_u32 perWord = 64 / myBitsPerEntry;
+        c_u32 shift = theIndex % perWord * myBitsPerEntry;
+        c_u64 mask = (1ULL << myBitsPerEntry) - 1;
+        u64& word = myIndices[theIndex / perWord];
+        word = (word & ~(mask << shift)) | paletteIndex << shift;
+    }
+
+
+    /// Re-encodes the palette indices with a wider entry.
+    void BlockSection::repack(c_u32 theBitsPerEntry) {
+        u16 indices[BLOCK_COUNT] = {};
+        if (myBitsPerEntry != 0) {
+            c_u32 perWord = 64 / myBitsPerEntry;
+            c_u64 mask = (1ULL << myBitsPerEntry) - 1;
+            for (u32 index = 0; index < BLOCK_COUNT; index++) {
+                indices[index] = myIndices[index / perWord] >> (index % perWord * myBitsPerEntry) & mask;
+            }
+        }
+
+        myBitsPerEntry = theBitsPerEntry;
+        c_u32 perWord = 64 / myBitsPerEntry;
+        myIndices.assign(BLOCK_COUNT / perWord, 0);
+        for (u32 index = 0; index < BLOCK_COUNT; index++) {
+            myIndices[index / perWord] |= static_cast<u64>(indices[index]) << (index % perWord * myBitsPerEntry);
+        }
+    }
+
+
+    size_t BlockSection::getMemoryUsage() const {
+        return sizeof(BlockSection) + myPalette.capacity() * sizeof(u16) + myIndices.capacity() * sizeof(u64);
+    }
+
+
+}
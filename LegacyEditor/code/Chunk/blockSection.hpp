@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vector>
+
+#include "lce/processor.hpp"
+
+
+namespace editor::chunk {
+
+
+    /**
+     * One 16x16x16 section of a chunk's newBlocks, stored as a palette of the
+     * blocks in it and packed indices into that palette.
+     * \n\n
+     * A section made of a single block (usually air) only stores that block.
+     * Local indices are (y & 15) | z << 4 | x << 8, the same order as newBlocks.
+     */
+    class BlockSection {
+        u16_vec myPalette;
+        std::vector<u64> myIndices;
+        u32 myBitsPerEntry = 0;
+
+        void repack(u32 theBitsPerEntry);
+
+    public:
+        static constexpr u32 BLOCK_COUNT = 4096;
+
+        BlockSection() : myPalette(1, 0) {}
+
+        /// Reads section "theSectionIndex" out of a 65536 block newBlocks array.
+        void pack(const u16* theBlocks, u32 theSectionIndex);
+
+        /// Writes the section back into a 65536 block newBlocks array.
+        void unpack(u16* theBlocks, u32 theSectionIndex) const;
+
+        ND u16 get(u32 theIndex) const;
+        void set(u32 theIndex, u16 theBlock);
+
+        ND bool isUniform() const { return myBitsPerEntry == 0; }
+        ND size_t getMemoryUsage() const;
+
+        /// (y & 15) | z << 4 | x << 8 from a newBlocks offset.
+        static u32 toLocalIndex(c_u32 offset) { return (offset & 15) | (offset >> 8) << 4; }
+    };
+
+
+}
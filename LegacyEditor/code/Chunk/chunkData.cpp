@@ -1,26 +1,35 @@
 #include "chunkData.hpp"
 
 #include "LegacyEditor/utils/NBT.hpp"
+#include "LegacyEditor/utils/NBTLazy.hpp"
 #include "lce/blocks/block_ids.hpp"
 
 
 namespace editor::chunk {
 
 
-    ChunkData::~ChunkData() {
-        if (NBTData != nullptr) {
-            NBTData->NbtFree();
-            delete NBTData;
-            NBTData = nullptr;
+    /// A tree read into an arena is freed all at once by deleting the arena.
+    static void freeNBTData(ChunkData& theChunk) {
+        if (theChunk.NBTData != nullptr && !theChunk.NBTData->inArena) {
+            theChunk.NBTData->NbtFree();
+            delete theChunk.NBTData;
         }
+        theChunk.NBTData = nullptr;
+        delete theChunk.NBTDataArena;
+        theChunk.NBTDataArena = nullptr;
+        delete theChunk.NBTDataLazy;
+        theChunk.NBTDataLazy = nullptr;
+    }
+
+
+    ChunkData::~ChunkData() {
+        freeNBTData(*this);
     }
 
 
     void ChunkData::defaultNBT() {
-        if (NBTData != nullptr) {
-            NBTData->toType<NBTTagCompound>()->deleteAll();
-            delete NBTData;
-        }
+        freeNBTData(*this);
+        isDirty = true;
 
         NBTData = new NBTBase(new NBTTagCompound(), TAG_COMPOUND);
         auto* chunkRootNbtData = static_cast<NBTTagCompound*>(NBTData->data);
@@ -33,6 +42,50 @@ namespace editor::chunk {
     }
 
 
+    bool ChunkData::hasChanged() const {
+        return isDirty || (NBTDataLazy != nullptr && NBTDataLazy->isModified());
+    }
+
+
+    NBTBase* ChunkData::getNBTData() {
+        isDirty = true;
+        return const_cast<NBTBase*>(viewNBTData());
+    }
+
+
+    const NBTBase* ChunkData::viewNBTData() {
+        if (NBTData == nullptr && NBTDataLazy != nullptr) {
+            // a lazy compound that was edited has to be written again once it is a tree
+            isDirty |= NBTDataLazy->isModified();
+            NBTDataArena = new NBTArena(NBTArena::getInitialSize(NBTDataLazy->getEncodedSize()));
+            NBTData = NBTDataLazy->toTree(NBTDataArena);
+            delete NBTDataLazy;
+            NBTDataLazy = nullptr;
+        }
+        return NBTData;
+    }
+
+
+    void ChunkData::writeNBTData(DataManager& theOutput) const {
+        if (NBTData != nullptr) {
+            NBT::writeTag(NBTData, theOutput);
+        } else if (NBTDataLazy != nullptr) {
+            NBTDataLazy->write(theOutput);
+        }
+    }
+
+
+    u64 ChunkData::getNBTSize() const {
+        if (NBTData != nullptr) {
+            return NBT::getTagSize(NBTData);
+        }
+        if (NBTDataLazy != nullptr) {
+            return NBTDataLazy->getWriteSize();
+        }
+        return 0;
+    }
+
+
     MU ND std::string ChunkData::getCoords() const {
         return "(" + std::to_string(chunkX) + ", " + std::to_string(chunkZ) + ")";
     }
@@ -58,6 +111,7 @@ namespace editor::chunk {
             }
         }
         lastVersion = 12;
+        isDirty = true;
         u8_vec().swap(oldBlocks);
     }
 
@@ -82,6 +136,7 @@ namespace editor::chunk {
             }
         }
         lastVersion = 12;
+        isDirty = true;
         u8_vec().swap(oldBlocks);
     }
 
@@ -91,6 +146,9 @@ namespace editor::chunk {
      *
      */
     MU void ChunkData::convert114ToAquatic() {
+        if (isCompact) {
+            expand();
+        }
 
         // remove 1.14 blocks here...
         for (int i = 0; i < 65536; i++) {
@@ -101,36 +159,57 @@ namespace editor::chunk {
         }
 
         lastVersion = 12;
+        isDirty = true;
 
         // This for now, until nbt can be cleaned up
         defaultNBT();
     }
 
 
+    MU u16_vec& ChunkData::editBlocks() {
+        expand();
+        isDirty = true;
+        return newBlocks;
+    }
+
+
+    MU u8_vec& ChunkData::editSkyLight() {
+        isDirty = true;
+        return skyLight;
+    }
+
+
+    MU u8_vec& ChunkData::editBlockLight() {
+        isDirty = true;
+        return blockLight;
+    }
+
+
     MU void ChunkData::placeBlock(
                        c_int xIn, c_int yIn, c_int zIn,
                        c_u16 block, c_u16 data, c_bool waterlogged, c_bool isSubmerged) {
+        isDirty = true;
         switch (lastVersion) {
             case 10: {
-                int offset = (yIn % 128) + xIn * 128 + zIn * 128 * 16;
+                int offset = (yIn % 128) + zIn * 128 + xIn * 128 * 16;
                 offset += 32768 * (yIn > 127);
                 oldBlocks[offset] = block;
                 if (offset % 2 == 0) {
-                    blockData[offset] = (blockData[offset] & 0x0F) | data << 4;
+                    blockData[offset / 2] = (blockData[offset / 2] & 0xF0) | data;
                 } else {
-                    blockData[offset] = (blockData[offset] & 0xF0) | data;
+                    blockData[offset / 2] = (blockData[offset / 2] & 0x0F) | data << 4;
                 }
                 break;
             }
             case 8:
             case 9:
             case 11: {
-                c_int offset = yIn * 256 + zIn * 16 + xIn;
+                c_int offset = yIn * 256 + xIn * 16 + zIn;
                 oldBlocks[offset] = block;
                 if (offset % 2 == 0) {
-                    blockData[offset] = (blockData[offset] & 0x0F) | data << 4;
+                    blockData[offset / 2] = (blockData[offset / 2] & 0xF0) | data;
                 } else {
-                    blockData[offset] = (blockData[offset] & 0xF0) | data;
+                    blockData[offset / 2] = (blockData[offset / 2] & 0x0F) | data << 4;
                 }
             }
             break;
@@ -142,8 +221,24 @@ namespace editor::chunk {
                     value |= 0x8000;
                 }
                 if (!isSubmerged) {
-                    newBlocks[offset] = value;
+                    if (isCompact) {
+                        blockSections[yIn >> 4].set(BlockSection::toLocalIndex(offset), value);
+                    } else {
+                        newBlocks[offset] = value;
+                    }
+                    break;
+                }
+
+                hasSubmerged = true;
+                if (isCompact) {
+                    if (submergedSections.empty()) {
+                        submergedSections.resize(16);
+                    }
+                    submergedSections[yIn >> 4].set(BlockSection::toLocalIndex(offset), value);
                 } else {
+                    if (submerged.empty()) {
+                        submerged = u16_vec(65536);
+                    }
                     submerged[offset] = value;
                 }
                 break;
@@ -166,33 +261,36 @@ namespace editor::chunk {
     u16 ChunkData::getBlock(c_int xIn, c_int yIn, c_int zIn) {
         switch (lastVersion) {
             case 10: {
-                int offset = (yIn % 128) + xIn * 128 + zIn * 128 * 16;
+                int offset = (yIn % 128) + zIn * 128 + xIn * 128 * 16;
                 offset += 32768 * (yIn > 127);
                 c_u16 blockID = oldBlocks[offset];
                 u16 dataTag;
                 if (offset % 2 == 0) {
-                    dataTag = blockData[offset] & 0x0F;
+                    dataTag = blockData[offset / 2] & 0x0F;
                 } else {
-                    dataTag = (blockData[offset] & 0xF0) >> 4;
+                    dataTag = (blockData[offset / 2] & 0xF0) >> 4;
                 }
                 return blockID << 4 | dataTag;
             }
             case 8:
             case 9:
             case 11: {
-                c_int offset = yIn * 256 + zIn * 16 + xIn;
+                c_int offset = yIn * 256 + xIn * 16 + zIn;
                 c_u16 blockID = oldBlocks[offset];
                 u16 dataTag;
                 if (offset % 2 == 0) {
-                    dataTag = blockData[offset] & 0x0F;
+                    dataTag = blockData[offset / 2] & 0x0F;
                 } else {
-                    dataTag = (blockData[offset] & 0xF0) >> 4;
+                    dataTag = (blockData[offset / 2] & 0xF0) >> 4;
                 }
                 return blockID << 4 | dataTag;
             }
             case 12:
             case 13: {
                 c_int offset = yIn + 256 * zIn + 4096 * xIn;
+                if (isCompact) {
+                    return blockSections[yIn >> 4].get(BlockSection::toLocalIndex(offset));
+                }
                 return newBlocks[offset];
             }
             default:
@@ -201,4 +299,62 @@ namespace editor::chunk {
     }
 
 
+    MU void ChunkData::compact() {
+        if (isCompact || (lastVersion != 12 && lastVersion != 13) || newBlocks.size() != 65536) {
+            return;
+        }
+
+        blockSections.resize(16);
+        for (u32 sectionIndex = 0; sectionIndex < 16; sectionIndex++) {
+            blockSections[sectionIndex].pack(newBlocks.data(), sectionIndex);
+        }
+        u16_vec().swap(newBlocks);
+
+        if (hasSubmerged && submerged.size() == 65536) {
+            submergedSections.resize(16);
+            for (u32 sectionIndex = 0; sectionIndex < 16; sectionIndex++) {
+                submergedSections[sectionIndex].pack(submerged.data(), sectionIndex);
+            }
+        }
+        u16_vec().swap(submerged);
+
+        isCompact = true;
+    }
+
+
+    MU void ChunkData::expand() {
+        if (!isCompact) {
+            return;
+        }
+
+        newBlocks = u16_vec(65536);
+        for (u32 sectionIndex = 0; sectionIndex < 16; sectionIndex++) {
+            blockSections[sectionIndex].unpack(newBlocks.data(), sectionIndex);
+        }
+        std::vector<BlockSection>().swap(blockSections);
+
+        if (!submergedSections.empty()) {
+            submerged = u16_vec(65536);
+            for (u32 sectionIndex = 0; sectionIndex < 16; sectionIndex++) {
+                submergedSections[sectionIndex].unpack(submerged.data(), sectionIndex);
+            }
+        }
+        std::vector<BlockSection>().swap(submergedSections);
+
+        isCompact = false;
+    }
+
+
+    MU ND size_t ChunkData::getBlockMemoryUsage() const {
+        size_t total = newBlocks.capacity() * sizeof(u16) + submerged.capacity() * sizeof(u16);
+        for (const BlockSection& section : blockSections) {
+            total += section.getMemoryUsage();
+        }
+        for (const BlockSection& section : submergedSections) {
+            total += section.getMemoryUsage();
+        }
+        return total;
+    }
+
+
 }
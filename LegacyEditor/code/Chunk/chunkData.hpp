@@ -2,14 +2,32 @@
 
 #include "lce/processor.hpp"
 
+#include "LegacyEditor/code/Chunk/blockSection.hpp"
 #include "LegacyEditor/utils/error_status.hpp"
 
 
+class DataManager;
+class NBTArena;
 class NBTBase;
+class NBTLazyCompound;
 
 namespace editor::chunk {
 
 
+    /**
+     * The parts of a chunk that a read decodes, as a mask; the rest is seeked past.
+     * The coordinates, timestamps and terrainPopulated are always read.
+     */
+    enum READ_PART : u8 {
+        READ_BLOCKS = 1,    // blocks, submerged blocks and (before V12) block data
+        READ_LIGHTS = 2,    // skyLight and blockLight
+        READ_HEIGHTMAP = 4,
+        READ_BIOMES = 8,
+        READ_NBT = 16,
+        READ_ALL = 31,
+    };
+
+
     class ChunkData {
     public:
         // old version
@@ -18,15 +36,29 @@ namespace editor::chunk {
 
         // new version
         u16_vec newBlocks;
+        /// only allocated once a submerged block is read or placed
         u16_vec submerged;
         bool hasSubmerged = false;
 
+        // new version, compacted (see "compact")
+        std::vector<BlockSection> blockSections;
+        std::vector<BlockSection> submergedSections;
+        bool isCompact = false;
+
         // all versions
         u8_vec blockLight;          //
         u8_vec skyLight;            //
         u8_vec heightMap;           //
         u8_vec biomes;              //
+        /// the tree of the NBT, nullptr while it is only indexed in "NBTDataLazy"; see getNBTData
         NBTBase* NBTData = nullptr; //
+        /// the arena "NBTData" was read into, if any; it is freed along with it
+        NBTArena* NBTDataArena = nullptr;
+        /**
+         * What the readers keep of the NBT instead of a tree: its bytes and where each tag is in them.
+         * Tags can be read and set on it directly; an untouched chunk writes the bytes back as they were.
+         */
+        NBTLazyCompound* NBTDataLazy = nullptr;
         i16 terrainPopulated = 0;   //
         i64 lastUpdate = 0;         //
         i64 inhabitedTime = 0;      //
@@ -39,6 +71,14 @@ namespace editor::chunk {
 
         i32 lastVersion = 0;
         bool validChunk = false;
+        /// The parts (READ_PART) decoded by the last read; the others are left empty.
+        u8 readMask = READ_ALL;
+        /**
+         * Set by the modifiers and edit accessors below, and cleared once the chunk is read or written.
+         * A chunk that has not changed is saved as the bytes it was read from (see ChunkManager::writeChunk);
+         * code that edits the fields directly has to set it itself.
+         */
+        bool isDirty = false;
 
         ~ChunkData();
 
@@ -46,12 +86,47 @@ namespace editor::chunk {
 
         void defaultNBT();
 
+        /// Whether the chunk has to be written again: it is dirty, or a tag of "NBTDataLazy" was read or set.
+        ND bool hasChanged() const;
+
+        /**
+         * Returns "NBTData" for editing, reading all of "NBTDataLazy" into it first if the chunk
+         * was read lazily, and marks the chunk dirty.
+         */
+        MU ND NBTBase* getNBTData();
+        /// Like getNBTData, for looking at the NBT only; the chunk is not marked dirty.
+        MU ND const NBTBase* viewNBTData();
+
+        /// Writes "NBTData", or "NBTDataLazy" if it was never read into a tree.
+        void writeNBTData(DataManager& theOutput) const;
+        /// How many bytes writeNBTData stores.
+        ND u64 getNBTSize() const;
+
         // MODIFIERS
 
         MU void convertNBTToAquatic();
         MU void convertOldToAquatic();
         MU void convert114ToAquatic();
 
+        /**
+         * Moves newBlocks and submerged into 16 palette compressed sections, freeing
+         * the flat arrays. Only for versions 12 and 13; getBlock and placeBlock keep
+         * working on the sections, and writing the chunk expands it again.
+         */
+        MU void compact();
+        MU void expand();
+
+        /// Bytes held by the block storage (newBlocks, submerged or their sections).
+        MU ND size_t getBlockMemoryUsage() const;
+
+
+        /// The blocks of a version 12 or 13 chunk for editing in place; expands it first, and marks it dirty.
+        MU ND u16_vec& editBlocks();
+        /// "skyLight" for editing in place, and marks the chunk dirty.
+        MU ND u8_vec& editSkyLight();
+        /// "blockLight" for editing in place, and marks the chunk dirty.
+        MU ND u8_vec& editBlockLight();
+
 
         MU void placeBlock(int xIn, int yIn, int zIn, u16 block, u16 data, bool waterlogged, bool submerged = false);
         MU void placeBlock(int xIn, int yIn, int zIn, u16 block, bool submerged = false);
@@ -0,0 +1,181 @@
+#include "gridEncoder.hpp"
+
+#include <bit>
+#include <cstring>
+
+#include "LegacyEditor/utils/cpuFeatures.hpp"
+
+
+namespace editor::chunk {
+
+    static constexpr u32 GRID_COUNT = 64;
+    static constexpr u32 MAX_PALETTE = 16;
+
+    /*
+     * A grid is stored x, z, y; y is the innermost in the chunk as well,
+     * so each 4 blocks of a grid are one 8 byte load from the chunk.
+     */
+    static constexpr u32 GRID_STRIDE_X = 4096;
+    static constexpr u32 GRID_STRIDE_Z = 256;
+
+
+    // #####################################################
+    // #               Palette
+    // #####################################################
+
+
+    /**
+     * The blocks of a grid in the order they first appear, found through a small open-addressed table.\n
+     * A grid of more than MAX_PALETTE blocks is written in full; the caller stops inserting once isFull,
+     * so at most MAX_PALETTE + 1 are ever added.
+     */
+    class GridPalette {
+        static constexpr u32 SLOT_COUNT = 32;
+
+        u16 mySlotBlocks[SLOT_COUNT];
+        /// palette index + 1 of the block in the slot, 0 if the slot is empty
+        u8 mySlots[SLOT_COUNT] = {};
+
+    public:
+        u16 blocks[MAX_PALETTE + 1];
+        u32 count = 0;
+
+        /// @return the palette index of "block"
+        u32 insert(c_u16 block) {
+            u32 slot = static_cast<u32>(block) * 0x9E3779B1U >> 27U;
+            while (mySlots[slot] != 0) {
+                if (mySlotBlocks[slot] == block) {
+                    return mySlots[slot] - 1U;
+                }
+                slot = (slot + 1) & (SLOT_COUNT - 1);
+            }
+            mySlotBlocks[slot] = block;
+            blocks[count] = block;
+            mySlots[slot] = static_cast<u8>(++count);
+            return count - 1;
+        }
+
+        ND bool isFull() const { return count > MAX_PALETTE; }
+    };
+
+
+    // #####################################################
+    // #               Grid
+    // #####################################################
+
+
+    static void gatherGrid(c_u16* blocks, u16 grid[GRID_COUNT]) {
+        for (u32 x = 0; x < 4; x++) {
+            for (u32 z = 0; z < 4; z++) {
+                std::memcpy(grid + x * 16 + z * 4, blocks + x * GRID_STRIDE_X + z * GRID_STRIDE_Z, 8);
+            }
+        }
+    }
+
+
+    /// Whether every block of the grid is "block" (or 0, if "allowZero" is set).
+    static bool isUniform(c_u16 grid[GRID_COUNT], c_u16 block, c_bool allowZero) {
+#ifdef CPU_X86
+        const __m128i target = _mm_set1_epi16(static_cast<short>(block));
+        const __m128i zero = allowZero ? _mm_setzero_si128() : target;
+        __m128i same = _mm_set1_epi8(-1);
+        for (u32 i = 0; i < GRID_COUNT; i += 8) {
+            const __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(grid + i));
+            same = _mm_and_si128(same, _mm_or_si128(_mm_cmpeq_epi16(values, target), _mm_cmpeq_epi16(values, zero)));
+        }
+        return _mm_movemask_epi8(same) == 0xFFFF;
+#else
+        for (u32 i = 0; i < GRID_COUNT; i++) {
+            if (grid[i] != block && (!allowZero || grid[i] != 0)) {
+                return false;
+            }
+        }
+        return true;
+#endif
+    }
+
+
+    static void writeLittle16(c_u16* values, c_u32 count, u8* out) {
+        if constexpr (std::endian::native == std::endian::little) {
+            std::memcpy(out, values, count * 2);
+        } else {
+            for (u32 i = 0; i < count; i++) {
+                out[i * 2] = static_cast<u8>(values[i]);
+                out[i * 2 + 1] = static_cast<u8>(values[i] >> 8);
+            }
+        }
+    }
+
+
+    static constexpr u64 LOW_BITS = 0x0101010101010101ULL;
+    /// Multiplying 8 bytes of 0 or 1 by this gathers them into the top byte, the first byte in memory as the highest bit.
+    static constexpr u64 GATHER_BITS = std::endian::native == std::endian::little
+                                               ? 0x8040201008040201ULL : 0x0102040810204080ULL;
+
+
+    /**
+     * Writes a 64-bit plane (big endian) per bit of the indices, the first block as the highest bit.
+     * Each row of 8 indices is read as one word, of which every plane takes a byte with a single multiply.
+     */
+    static void writePlanes(c_u8 indices[GRID_COUNT], c_u32 bitCount, u8* out) {
+        for (u32 row = 0; row < 8; row++) {
+            u64 packed;
+            std::memcpy(&packed, indices + row * 8, 8);
+            for (u32 bit = 0; bit < bitCount; bit++) {
+                out[bit * 8 + row] = static_cast<u8>((packed >> bit & LOW_BITS) * GATHER_BITS >> 56U);
+            }
+        }
+    }
+
+
+    u8 GridEncoder::encode(c_u16* blocks, c_u16* submerged, u8* out, u16& uniformBlock) {
+        alignas(16) u16 grid[GRID_COUNT];
+        alignas(16) u16 sbmrgGrid[GRID_COUNT];
+        gatherGrid(blocks, grid);
+        if (submerged != nullptr) {
+            gatherGrid(submerged, sbmrgGrid);
+        }
+
+        if (isUniform(grid, grid[0], false) && (submerged == nullptr || isUniform(sbmrgGrid, grid[0], true))) {
+            uniformBlock = grid[0];
+            return FORMAT_UNO;
+        }
+
+        // neighbouring blocks are mostly the same, so only look up a block when it changes
+        GridPalette palette;
+        alignas(8) u8 indices[GRID_COUNT];
+        u16 lastBlock = grid[0];
+        u32 lastIndex = palette.insert(lastBlock);
+        for (u32 i = 0; i < GRID_COUNT; i++) {
+            if (grid[i] != lastBlock) {
+                lastBlock = grid[i];
+                lastIndex = palette.insert(lastBlock);
+                if (palette.isFull()) {
+                    break;
+                }
+            }
+            indices[i] = static_cast<u8>(lastIndex);
+
+            // an iteration can add two blocks, so the palette is checked after each
+            if (submerged != nullptr && sbmrgGrid[i] != 0 && sbmrgGrid[i] != lastBlock) {
+                palette.insert(sbmrgGrid[i]);
+                if (palette.isFull()) {
+                    break;
+                }
+            }
+        }
+
+        if (palette.isFull()) {
+            writeLittle16(grid, GRID_COUNT, out);
+            return FORMAT_FULL;
+        }
+
+        // unused palette entries are filled with 0xFFFF
+        c_u32 bitCount = std::bit_width(palette.count - 1);
+        c_u32 paletteSize = 1U << bitCount;
+        writeLittle16(palette.blocks, palette.count, out);
+        std::memset(out + palette.count * 2, 0xFF, (paletteSize - palette.count) * 2);
+        writePlanes(indices, bitCount, out + paletteSize * 2);
+        return static_cast<u8>(bitCount * 2);
+    }
+}
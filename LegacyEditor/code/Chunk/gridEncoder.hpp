@@ -0,0 +1,32 @@
+#pragma once
+
+#include "lce/processor.hpp"
+
+
+namespace editor::chunk {
+
+
+    /**
+     * Encodes the 4x4x4 block grids of "Aquatic" chunks (V12 and V13 share the grid formats).\n
+     * A grid is a palette of up to 16 blocks followed by one 64-bit plane per bit of the palette indices;
+     * a single block is stored in the grid header instead, and more than 16 blocks are stored as they are.
+     */
+    class GridEncoder {
+    public:
+        static constexpr u8 FORMAT_UNO = 0x00;
+        static constexpr u8 FORMAT_FULL = 0x0E;
+
+        /// Bytes written for a grid of each format, the same as V12_GRID_SIZES.
+        static constexpr u32 SIZES[16] = {0, 0, 12, 20, 24, 40, 40, 64, 64, 96, 0, 0, 0, 0, 128, 256};
+
+        /**
+         * Encodes the grid whose first block is "blocks", laid out the same as ChunkData::newBlocks.
+         * @param submerged the grid's submerged blocks, or nullptr; these only take up palette entries,
+         *                  their positions are not written
+         * @param out where the grid is written to, at most 128 bytes
+         * @param uniformBlock set to the block of a FORMAT_UNO grid, which goes in the grid header
+         * @return the format of the grid, of which SIZES[format] bytes were written
+         */
+        ND static u8 encode(c_u16* blocks, c_u16* submerged, u8* out, u16& uniformBlock);
+    };
+}
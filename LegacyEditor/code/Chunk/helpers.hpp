@@ -4,6 +4,7 @@
 
 #include "lce/processor.hpp"
 
+#include "LegacyEditor/utils/cpuFeatures.hpp"
 #include "LegacyEditor/utils/dataManager.hpp"
 
 
@@ -16,49 +17,6 @@ namespace editor::chunk {
     }
 
 
-    /**
-     * This checks if the next 1024 bits are all zeros.\n
-     * this is u8[128]
-     * @param ptr
-     * @return true if all bits are zero, else 0.
-     */
-    static bool is0_128_slow(c_u8* ptr) {
-        for (int i = 0; i < 128; ++i) {
-            if (ptr[i] != 0x00) {
-                return false;
-            }
-        }
-        return true;
-    }
-
-
-    static bool is255_128_slow(c_u8* ptr) {
-        for (int i = 0; i < 128; ++i) {
-            if (ptr[i] != 0xFF) {
-                return false;
-            }
-        }
-        return true;
-    }
-
-
-
-    static void readDataBlock(const u8_vec& dataIn, u8_vec& dataOut, int& offset) {
-        static constexpr int DATA_SECTION_SIZE = 128;
-
-        for (int k = 0; k < DATA_SECTION_SIZE; k++) {
-            if (dataIn[k] == DATA_SECTION_SIZE) {
-                memset(&dataOut[offset], 0, DATA_SECTION_SIZE);
-            } else if (dataIn[k] == DATA_SECTION_SIZE + 1) {
-                memset(&dataOut[offset], 255, DATA_SECTION_SIZE);
-            } else {
-                std::memcpy(&dataOut[offset], &dataIn[toIndex(dataIn[k])], DATA_SECTION_SIZE);
-            }
-            offset += DATA_SECTION_SIZE;
-        }
-    }
-
-
     static void readDataBlock(c_u8* dataIn1, u8* dataIn2, u8_vec& dataOut) {
         static constexpr int DATA_SECTION_SIZE = 128;
         int offset = 0;
@@ -101,50 +59,126 @@ namespace editor::chunk {
     }
 
 
-    static void writeDataBlock(DataManager* managerIn, const u8_vec& dataIn)  {
-        static constexpr int GRID_COUNT = 64;
-        static constexpr int DATA_SECTION_SIZE = 128;
+    /// Moves past "SIZE" data blocks, the same as readGetDataBlockVector does.
+    template<int SIZE>
+    static void skipDataBlocks(DataManager* managerIn) {
+        for (int i = 0; i < SIZE; i++) {
+            managerIn->incrementPointer(toIndex(managerIn->readInt32()));
+        }
+    }
+
+
+    /// Reads the height map, terrainPopulated and the biomes, moving past the ones not in "readMask".
+    static void readHeightMapAndBiomes(ChunkData* chunkData, DataManager* managerIn, c_u8 readMask) {
+        if (readMask & READ_HEIGHTMAP) {
+            managerIn->readBytes(256, chunkData->heightMap.data());
+        } else {
+            managerIn->incrementPointer(256);
+        }
+        chunkData->terrainPopulated = static_cast<i16>(managerIn->readInt16());
+        if (readMask & READ_BIOMES) {
+            managerIn->readBytes(256, chunkData->biomes.data());
+        } else {
+            managerIn->incrementPointer(256);
+        }
+    }
 
-        static u32_vec sectionOffsets;
-        sectionOffsets.reserve(GRID_COUNT);
 
-        u32 readOffset = 0;
+    enum DATA_SECTION : u8 {
+        DATA_SECTION_ZERO,
+        DATA_SECTION_FULL,
+        DATA_SECTION_MIXED,
+    };
 
-        // it does it twice, after the first interval, readOffset should be 32767
-        for (int index = 0; index < 2; index++) {
+
+    /**
+     * Sorts each 128 byte section of "dataIn" into all 0x00, all 0xFF or mixed, in a single pass.
+     * @param kinds receives a DATA_SECTION per section
+     */
+    static void classifyDataSections(c_u8* dataIn, c_u32 sectionCount, u8* kinds) {
+        static constexpr u32 DATA_SECTION_SIZE = 128;
+
+        for (u32 section = 0; section < sectionCount; section++) {
+            c_u8* ptr = dataIn + section * DATA_SECTION_SIZE;
+#ifdef CPU_X86
+            __m128i anySet = _mm_setzero_si128();
+            __m128i allSet = _mm_set1_epi8(-1);
+            for (u32 i = 0; i < DATA_SECTION_SIZE; i += 16) {
+                const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr + i));
+                anySet = _mm_or_si128(anySet, bytes);
+                allSet = _mm_and_si128(allSet, bytes);
+            }
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(anySet, _mm_setzero_si128())) == 0xFFFF) {
+                kinds[section] = DATA_SECTION_ZERO;
+            } else if (_mm_movemask_epi8(_mm_cmpeq_epi8(allSet, _mm_set1_epi8(-1))) == 0xFFFF) {
+                kinds[section] = DATA_SECTION_FULL;
+            } else {
+                kinds[section] = DATA_SECTION_MIXED;
+            }
+#else
+            u64 anySet = 0;
+            u64 allSet = ~0ULL;
+            for (u32 i = 0; i < DATA_SECTION_SIZE; i += 8) {
+                u64 word;
+                std::memcpy(&word, ptr + i, 8);
+                anySet |= word;
+                allSet &= word;
+            }
+            kinds[section] = anySet == 0 ? DATA_SECTION_ZERO
+                           : allSet == ~0ULL ? DATA_SECTION_FULL : DATA_SECTION_MIXED;
+#endif
+        }
+    }
+
+
+    /// Whether the 128 bytes at "ptr" are all 0x00, e.g. an empty grid header.
+    MU static bool isZeroSection(c_u8* ptr) {
+        u8 kind;
+        classifyDataSections(ptr, 1, &kind);
+        return kind == DATA_SECTION_ZERO;
+    }
+
+
+    /**
+     * Writes 32768 bytes of light / data nibbles as two halves, each a header of 128 section ids
+     * followed by the sections that are not all 0x00 or all 0xFF.\n
+     * Keeps no state between calls, so chunks can be written from several threads.
+     */
+    static void writeDataBlock(DataManager* managerIn, const u8_vec& dataIn)  {
+        static constexpr u32 DATA_SECTION_SIZE = 128;
+        static constexpr u32 SECTION_COUNT = 256;
+
+        u8 kinds[SECTION_COUNT];
+        classifyDataSections(dataIn.data(), SECTION_COUNT, kinds);
+
+        // it does it twice, each time for 128 sections
+        for (u32 half = 0; half < SECTION_COUNT; half += DATA_SECTION_SIZE) {
 
             c_u32 start = managerIn->getPosition();
             managerIn->writeInt32(0);
-            sectionOffsets.clear();
 
             // Write headers
             u32 sectionOffsetSize = 0;
-            c_u8* ptr = dataIn.data() + readOffset;
-            for (int i = 0; i < DATA_SECTION_SIZE; i++) {
-                if (is0_128_slow(ptr)) {
-                    managerIn->writeInt8(DATA_SECTION_SIZE);
-                } else if (is255_128_slow(ptr)) {
-                    managerIn->writeInt8(DATA_SECTION_SIZE + 1);
-                } else {
-                    sectionOffsets.push_back(readOffset);
-                    managerIn->writeInt8(sectionOffsetSize++);
+            for (u32 i = half; i < half + DATA_SECTION_SIZE; i++) {
+                switch (kinds[i]) {
+                    case DATA_SECTION_ZERO: managerIn->writeInt8(DATA_SECTION_SIZE); break;
+                    case DATA_SECTION_FULL: managerIn->writeInt8(DATA_SECTION_SIZE + 1); break;
+                    default: managerIn->writeInt8(sectionOffsetSize++); break;
                 }
-                ptr += DATA_SECTION_SIZE;
-                readOffset += DATA_SECTION_SIZE;
             }
 
             // Write light data sections
-            for (c_u32 offset : sectionOffsets) {
-                managerIn->writeBytes(&dataIn[offset], DATA_SECTION_SIZE);
+            for (u32 i = half; i < half + DATA_SECTION_SIZE; i++) {
+                if (kinds[i] == DATA_SECTION_MIXED) {
+                    managerIn->writeBytes(&dataIn[i * DATA_SECTION_SIZE], DATA_SECTION_SIZE);
+                }
             }
 
             // Calculate and write the size
             c_u32 end = managerIn->getPosition();
             c_u32 size = (end - start - 4 - 128) / 128; // -4 to exclude size header
             managerIn->writeInt32AtOffset(start, size);
-        } // end of for loop
-
-
+        }
     }
 
 
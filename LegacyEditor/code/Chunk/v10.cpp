@@ -57,6 +57,8 @@ namespace editor::chunk {
         delete chunkNBT;
         delete nbt;
 
+        // the chunk is one NBT tag, so all of it is read anyway
+        chunkData->readMask = READ_ALL;
         chunkData->validChunk = true;
 
     }
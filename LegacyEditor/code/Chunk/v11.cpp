@@ -2,7 +2,7 @@
 
 #include <cstring>
 
-#include "LegacyEditor/utils/NBT.hpp"
+#include "LegacyEditor/utils/NBTLazy.hpp"
 #include "LegacyEditor/code/Chunk/chunkData.hpp"
 #include "LegacyEditor/code/Chunk/helpers.hpp"
 
@@ -13,13 +13,13 @@
 namespace editor::chunk {
 
 
-    void ChunkV11::allocChunk() const {
-        chunkData->oldBlocks = u8_vec(65536);
-        chunkData->blockData = u8_vec(32768);
-        chunkData->skyLight = u8_vec(32768);
-        chunkData->blockLight = u8_vec(32768);
-        chunkData->heightMap = u8_vec(256);
-        chunkData->biomes = u8_vec(256);
+    void ChunkV11::allocChunk(c_u8 readMask) const {
+        chunkData->oldBlocks = (readMask & READ_BLOCKS) != 0 ? u8_vec(65536) : u8_vec();
+        chunkData->blockData = (readMask & READ_BLOCKS) != 0 ? u8_vec(32768) : u8_vec();
+        chunkData->skyLight = (readMask & READ_LIGHTS) != 0 ? u8_vec(32768) : u8_vec();
+        chunkData->blockLight = (readMask & READ_LIGHTS) != 0 ? u8_vec(32768) : u8_vec();
+        chunkData->heightMap = (readMask & READ_HEIGHTMAP) != 0 ? u8_vec(256) : u8_vec();
+        chunkData->biomes = (readMask & READ_BIOMES) != 0 ? u8_vec(256) : u8_vec();
     }
 
 
@@ -28,8 +28,8 @@ namespace editor::chunk {
     // #####################################################
 
 
-    void ChunkV11::readChunk() const {
-        allocChunk();
+    void ChunkV11::readChunk(c_u8 readMask) const {
+        allocChunk(readMask);
 
         chunkData->chunkX = static_cast<i32>(dataManager->readInt32());
         chunkData->chunkZ = static_cast<i32>(dataManager->readInt32());
@@ -40,21 +40,38 @@ namespace editor::chunk {
             chunkData->inhabitedTime = static_cast<i64>(dataManager->readInt64());
         }
 
-        readBlockData();
+        if (readMask & READ_BLOCKS) {
+            readBlockData();
+        } else {
+            skipBlockData();
+        }
+
+        if (readMask & READ_BLOCKS) {
+            c_auto dataArray = readGetDataBlockVector<2>(chunkData, dataManager);
+            readDataBlock(dataArray[0], dataArray[1], chunkData->blockData);
+        } else {
+            skipDataBlocks<2>(dataManager);
+        }
 
-        c_auto dataArray = readGetDataBlockVector<6>(chunkData, dataManager);
-        readDataBlock(dataArray[0], dataArray[1], chunkData->blockData);
-        readDataBlock(dataArray[2], dataArray[3], chunkData->skyLight);
-        readDataBlock(dataArray[4], dataArray[5], chunkData->blockLight);
+        if (readMask & READ_LIGHTS) {
+            c_auto dataArray = readGetDataBlockVector<4>(chunkData, dataManager);
+            readDataBlock(dataArray[0], dataArray[1], chunkData->skyLight);
+            readDataBlock(dataArray[2], dataArray[3], chunkData->blockLight);
+        } else {
+            skipDataBlocks<4>(dataManager);
+        }
 
-        dataManager->readBytes(256, chunkData->heightMap.data());
-        chunkData->terrainPopulated = static_cast<i16>(dataManager->readInt16());
-        dataManager->readBytes(256, chunkData->biomes.data());
+        readHeightMapAndBiomes(chunkData, dataManager, readMask);
 
-        if (*dataManager->ptr == 0x0A) {
-            chunkData->NBTData = NBT::readTag(*dataManager);
+        // only indexed, the tags are read once something asks for them (see ChunkData::getNBTData)
+        if ((readMask & READ_NBT) != 0 && *dataManager->ptr == 0x0A) {
+            chunkData->NBTDataLazy = new NBTLazyCompound();
+            if (chunkData->NBTDataLazy->read(*dataManager) != SUCCESS) {
+                printf("chunk %s has corrupt NBT, it is left empty\n", chunkData->getCoords().c_str());
+            }
         }
 
+        chunkData->readMask = readMask;
         chunkData->validChunk = true;
     }
 
@@ -123,6 +140,17 @@ namespace editor::chunk {
 
 
 
+    /// Each half of the blocks starts with its size, grid header included.
+    void ChunkV11::skipBlockData() const {
+        for (int half = 0; half < 2; half++) {
+            c_i32 blockLength = static_cast<i32>(dataManager->readInt32());
+            if (blockLength >= GRID_HEADER_SIZE) {
+                dataManager->incrementPointer(blockLength);
+            }
+        }
+    }
+
+
     void ChunkV11::readBlockData() const {
 
         for (int putBlockOffset = 0; putBlockOffset < 65536; putBlockOffset += 32768) {
@@ -243,11 +271,6 @@ namespace editor::chunk {
         dataManager->writeBytes(chunkData->heightMap.data(), 256);
         dataManager->writeInt16(chunkData->terrainPopulated);
         dataManager->writeBytes(chunkData->biomes.data(), 256);
-
-
-        if (chunkData->NBTData != nullptr) {
-            NBT::writeTag(chunkData->NBTData, *dataManager);
-        }
     }
 
 
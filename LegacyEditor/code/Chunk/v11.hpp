@@ -2,14 +2,14 @@
 
 #include "lce/processor.hpp"
 
+#include "LegacyEditor/code/Chunk/chunkData.hpp"
+
 
 class DataManager;
 
 
 namespace editor::chunk {
 
-    class ChunkData;
-
     enum V11_GRID_STATE : u8 {
         V11_1_BIT = 0,
         V11_2_BIT = 1,
@@ -27,6 +27,7 @@ namespace editor::chunk {
         // Read
 
         MU void readBlockData() const;
+        void skipBlockData() const;
         template<size_t BitsPerBlock>
         MU static bool readGrid(u8 const* buffer, u8 grid[GRID_SIZE]);
 
@@ -46,8 +47,10 @@ namespace editor::chunk {
         ChunkV11(ChunkData* chunkDataIn, DataManager* managerIn) :
             chunkData(chunkDataIn), dataManager(managerIn) {}
 
-        MU void allocChunk() const;
-        MU void readChunk() const;
+        MU void allocChunk(u8 readMask = READ_ALL) const;
+        /// Reads the parts of the chunk in "readMask" (see READ_PART), seeking past the others.
+        MU void readChunk(u8 readMask = READ_ALL) const;
+        /// Writes everything but the NBT, which ChunkManager::writeChunk puts after it.
         MU void writeChunk();
     };
 
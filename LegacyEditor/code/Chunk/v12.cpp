@@ -1,23 +1,32 @@
 #include "v12.hpp"
 
-#include <cstring>
 #include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
 
+#include "LegacyEditor/code/Chunk/gridEncoder.hpp"
 #include "LegacyEditor/code/Chunk/helpers.hpp"
-#include "LegacyEditor/utils/NBT.hpp"
+#include "LegacyEditor/utils/NBTLazy.hpp"
 #include "LegacyEditor/utils/dataManager.hpp"
+#include "LegacyEditor/utils/cpuFeatures.hpp"
+#include "LegacyEditor/utils/endianDataManager.hpp"
 
 
 namespace editor::chunk {
 
-    void ChunkV12::allocChunk() const {
+    void ChunkV12::allocChunk(c_u8 readMask) const {
         chunkData->DataGroupCount = 0;
-        chunkData->newBlocks = u16_vec(65536);
-        chunkData->submerged = u16_vec(65536);
-        chunkData->skyLight = u8_vec(32768);
-        chunkData->blockLight = u8_vec(32768);
-        chunkData->heightMap = u8_vec(256);
-        chunkData->biomes = u8_vec(256);
+        chunkData->newBlocks = (readMask & READ_BLOCKS) != 0 ? u16_vec(65536) : u16_vec();
+        u16_vec().swap(chunkData->submerged);
+        chunkData->hasSubmerged = false;
+        std::vector<BlockSection>().swap(chunkData->blockSections);
+        std::vector<BlockSection>().swap(chunkData->submergedSections);
+        chunkData->isCompact = false;
+        chunkData->skyLight = (readMask & READ_LIGHTS) != 0 ? u8_vec(32768) : u8_vec();
+        chunkData->blockLight = (readMask & READ_LIGHTS) != 0 ? u8_vec(32768) : u8_vec();
+        chunkData->heightMap = (readMask & READ_HEIGHTMAP) != 0 ? u8_vec(256) : u8_vec();
+        chunkData->biomes = (readMask & READ_BIOMES) != 0 ? u8_vec(256) : u8_vec();
     }
 
     // #####################################################
@@ -25,59 +34,208 @@ namespace editor::chunk {
     // #####################################################
 
 
-    void ChunkV12::readChunk() const {
-        allocChunk();
+    void ChunkV12::readChunk(c_u8 readMask) const {
+        allocChunk(readMask);
 
         chunkData->chunkX = static_cast<i32>(dataManager->readInt32());
         chunkData->chunkZ = static_cast<i32>(dataManager->readInt32());
         chunkData->lastUpdate = static_cast<i64>(dataManager->readInt64());
         chunkData->inhabitedTime = static_cast<i64>(dataManager->readInt64());
 
-        readBlockData();
+        if (readMask & READ_BLOCKS) {
+            readBlockData();
+        } else {
+            skipBlockData();
+        }
 
-        {
-        c_auto dataArray = readGetDataBlockVector<4>(chunkData, dataManager);
-        readDataBlock(dataArray[0], dataArray[1], chunkData->skyLight);
-        readDataBlock(dataArray[2], dataArray[3], chunkData->blockLight);
+        if (readMask & READ_LIGHTS) {
+            c_auto dataArray = readGetDataBlockVector<4>(chunkData, dataManager);
+            readDataBlock(dataArray[0], dataArray[1], chunkData->skyLight);
+            readDataBlock(dataArray[2], dataArray[3], chunkData->blockLight);
+        } else {
+            skipDataBlocks<4>(dataManager);
         }
 
-        dataManager->readBytes(256, chunkData->heightMap.data());
-        chunkData->terrainPopulated = static_cast<i16>(dataManager->readInt16());
-        dataManager->readBytes(256, chunkData->biomes.data());
+        readHeightMapAndBiomes(chunkData, dataManager, readMask);
 
-        if (*dataManager->ptr == 0xA) {
-            chunkData->NBTData = NBT::readTag(*dataManager);
+        // only indexed, the tags are read once something asks for them (see ChunkData::getNBTData)
+        if ((readMask & READ_NBT) != 0 && *dataManager->ptr == 0xA) {
+            chunkData->NBTDataLazy = new NBTLazyCompound();
+            if (chunkData->NBTDataLazy->read(*dataManager) != SUCCESS) {
+                printf("chunk %s has corrupt NBT, it is left empty\n", chunkData->getCoords().c_str());
+            }
         }
 
+        chunkData->readMask = readMask;
         chunkData->validChunk = true;
     }
 
 
-    static void placeBlocks(u16_vec& writeVec, c_u8* grid, c_int writeOffset) {
-        int readOffset = 0;
-        for (int xIter = 0; xIter < 4; xIter++) {
-            for (int zIter = 0; zIter < 4; zIter++) {
-                for (int yIter = 0; yIter < 4; yIter++) {
-                    c_int currentOffset = yIter + zIter * 256 + xIter * 4096;
-                    c_u8 num1 = grid[readOffset++];
-                    c_u8 num2 = grid[readOffset++];
-                    writeVec[currentOffset + writeOffset] = static_cast<u16>(num1)
-                        | static_cast<u16>(num2) << 8U;
+    // #####################################################
+    // #               Grid Decoding
+    // #####################################################
+
+
+    /**
+     * The 8 bits of a byte spread out into 8 bytes of 0 or 1, the most significant
+     * bit landing in the lowest address; the order that a grid stores its blocks in.
+     */
+    static constexpr auto BIT_SPREAD = [] {
+        std::array<u64, 256> table{};
+        for (u32 value = 0; value < 256; value++) {
+            for (u32 bit = 0; bit < 8; bit++) {
+                c_u32 shift = std::endian::native == std::endian::little ? bit * 8 : (7 - bit) * 8;
+                table[value] |= static_cast<u64>(value >> (7 - bit) & 1U) << shift;
+            }
+        }
+        return table;
+    }();
+
+
+    /// Gathers the palette index of each of the 64 blocks from "BitsPerBlock" 64-bit planes, 8 blocks at a time.
+    template<u32 BitsPerBlock>
+    static void unpackIndices(c_u8* planes, u8 indices[64]) {
+        for (u32 row = 0; row < 8; row++) {
+            u64 packed = 0;
+            for (u32 bit = 0; bit < BitsPerBlock; bit++) {
+                packed |= BIT_SPREAD[planes[bit * 8 + row]] << bit;
+            }
+            std::memcpy(indices + row * 8, &packed, 8);
+        }
+    }
+
+
+    /*
+     * A grid is 4x4x4 blocks stored x, z, y; y is the innermost in the chunk as well,
+     * so each 4 blocks of a grid are one 8 byte store into the chunk.
+     */
+    static constexpr u32 GRID_STRIDE_X = 4096;
+    static constexpr u32 GRID_STRIDE_Z = 256;
+
+
+    static void placeIndicesScalar(u16* blocks, c_u8 paletteBytes[32], c_u8 indices[64]) {
+        u16 palette[16];
+        for (u32 i = 0; i < 16; i++) {
+            palette[i] = static_cast<u16>(paletteBytes[i * 2] | paletteBytes[i * 2 + 1] << 8);
+        }
+        for (u32 x = 0; x < 4; x++) {
+            for (u32 z = 0; z < 4; z++) {
+                u16* column = blocks + x * GRID_STRIDE_X + z * GRID_STRIDE_Z;
+                c_u8* index = indices + x * 16 + z * 4;
+                column[0] = palette[index[0]];
+                column[1] = palette[index[1]];
+                column[2] = palette[index[2]];
+                column[3] = palette[index[3]];
+            }
+        }
+    }
+
+
+#ifdef CPU_X86
+
+    /// The palette has at most 16 entries, so its low and high bytes each fit in one shuffle table.
+    CPU_TARGET_SSSE3 static void placeIndicesSSSE3(u16* blocks, c_u8 paletteBytes[32], c_u8 indices[64]) {
+        const __m128i byteMask = _mm_set1_epi16(0x00FF);
+        const __m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(paletteBytes));
+        const __m128i second = _mm_loadu_si128(reinterpret_cast<const __m128i*>(paletteBytes + 16));
+        const __m128i lowTable = _mm_packus_epi16(_mm_and_si128(first, byteMask), _mm_and_si128(second, byteMask));
+        const __m128i highTable = _mm_packus_epi16(_mm_srli_epi16(first, 8), _mm_srli_epi16(second, 8));
+
+        for (u32 x = 0; x < 4; x++) {
+            const __m128i index = _mm_loadu_si128(reinterpret_cast<const __m128i*>(indices + x * 16));
+            const __m128i low = _mm_shuffle_epi8(lowTable, index);
+            const __m128i high = _mm_shuffle_epi8(highTable, index);
+            const __m128i z01 = _mm_unpacklo_epi8(low, high);
+            const __m128i z23 = _mm_unpackhi_epi8(low, high);
+
+            u16* column = blocks + x * GRID_STRIDE_X;
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(column), z01);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(column + GRID_STRIDE_Z), _mm_unpackhi_epi64(z01, z01));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(column + GRID_STRIDE_Z * 2), z23);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(column + GRID_STRIDE_Z * 3), _mm_unpackhi_epi64(z23, z23));
+        }
+    }
+
+
+#endif
+
+
+    /// Writes the palette entry of each of the 64 "indices" to where its block goes in the chunk.
+    static void placeIndices(u16* blocks, c_u8 paletteBytes[32], c_u8 indices[64]) {
+#ifdef CPU_X86
+        if (cpu::hasSSSE3()) {
+            placeIndicesSSSE3(blocks, paletteBytes, indices);
+            return;
+        }
+#endif
+        placeIndicesScalar(blocks, paletteBytes, indices);
+    }
+
+
+    static void placeSingle(u16* blocks, c_u16 block) {
+        for (u32 x = 0; x < 4; x++) {
+            for (u32 z = 0; z < 4; z++) {
+                std::fill_n(blocks + x * GRID_STRIDE_X + z * GRID_STRIDE_Z, 4, block);
+            }
+        }
+    }
+
+
+    /// The grid holds each block as it is, 2 bytes (low first) per block.
+    static void placeFull(u16* blocks, c_u8* buffer) {
+        for (u32 x = 0; x < 4; x++) {
+            for (u32 z = 0; z < 4; z++) {
+                u16* column = blocks + x * GRID_STRIDE_X + z * GRID_STRIDE_Z;
+                c_u8* grid = buffer + (x * 16 + z * 4) * 2;
+                if constexpr (std::endian::native == std::endian::little) {
+                    std::memcpy(column, grid, 8);
+                } else {
+                    for (u32 y = 0; y < 4; y++) {
+                        column[y] = static_cast<u16>(grid[y * 2] | grid[y * 2 + 1] << 8);
+                    }
                 }
             }
         }
     }
 
 
+    /**
+     * Decodes a palette grid straight into the chunk: the palette, then a plane per bit
+     * of the block indices, then (if "submerged" is given) a plane per bit of the submerged indices.
+     */
+    template<u32 BitsPerBlock>
+    static void readGrid(c_u8* buffer, u16* blocks, u16* submerged) {
+        static constexpr u32 PALETTE_SIZE = (1U << BitsPerBlock) * 2;
 
-    void ChunkV12::readBlockData() const {
+        alignas(16) u8 paletteBytes[32] = {};
+        std::memcpy(paletteBytes, buffer, PALETTE_SIZE);
+
+        alignas(16) u8 indices[64];
+        unpackIndices<BitsPerBlock>(buffer + PALETTE_SIZE, indices);
+        placeIndices(blocks, paletteBytes, indices);
+
+        if (submerged != nullptr) {
+            unpackIndices<BitsPerBlock>(buffer + PALETTE_SIZE + BitsPerBlock * 8, indices);
+            placeIndices(submerged, paletteBytes, indices);
+        }
+    }
+
+
+    /// The section jump table is followed by the blocks, which end at the highest section address.
+    void ChunkV12::skipBlockData() const {
         c_u32 maxSectionAddress = dataManager->readInt16() << 8U;
+        // 26 chunk header + 50 section header
+        dataManager->seek(76U + maxSectionAddress);
+    }
+
+
+    void ChunkV12::readBlockData() const {
+        BigDataManager header(*dataManager);
+        c_u32 maxSectionAddress = header.readInt16() << 8U;
 
         u16_vec sectionJumpTable(16);
-        for (int i = 0; i < 16; i++) {
-            c_u16 address = dataManager->readInt16();
-            sectionJumpTable[i] = address;
-        }
+        header.readArray(sectionJumpTable.data(), 16);
+        header.sync(*dataManager);
 
         // size: 16
         c_u8* sizeOfSubChunks = dataManager->ptr;
@@ -97,22 +255,14 @@ namespace editor::chunk {
             if (sizeOfSubChunks[section] == 0U) {
                 continue;
             }
-            // TODO: replace with telling cpu to cache that address, and use a ptr?
             // size: 128 bytes
             c_u8* sectionHeader = dataManager->ptr;
             dataManager->incrementPointer(128);
-#ifdef DEBUG
-            u16 gridFormats[64] = {};
-            u16 gridOffsets[64] = {};
-            u32 gridFormatIndex = 0;
-            u32 gridOffsetIndex = 0;
-#endif
+
             for (int gridX = 0; gridX < 4; gridX++) {
                 for (int gridZ = 0; gridZ < 4; gridZ++) {
                     for (int gridY = 0; gridY < 4; gridY++) {
                         c_int gridIndex = gridX * 16 + gridZ * 4 + gridY;
-                        u8 blockGrid[GRID_SIZE] = {};
-                        u8 sbmrgGrid[GRID_SIZE] = {};
 
                         c_u8 num1 = sectionHeader[gridIndex * 2];
                         c_u8 num2 = sectionHeader[gridIndex * 2 + 1];
@@ -124,10 +274,7 @@ namespace editor::chunk {
                         c_u16 gridPosition = 0xcc + address + offset;
 
                         c_int offsetInBlockWrite = (section * 16 + gridY * 4) + gridZ * 1024 + gridX * 16384;
-#ifdef DEBUG
-                        gridFormats[gridFormatIndex++] = format;
-                        gridOffsets[gridOffsetIndex++] = gridPosition - 26;
-#endif
+
                         // ensure not reading past the memory buffer
                         if EXPECT_FALSE (gridPosition + V12_GRID_SIZES[format] >= dataManager->size && format != 0) {
                             return;
@@ -135,58 +282,49 @@ namespace editor::chunk {
 
                         u8* bufferPtr = dataManager->data + gridPosition;
                         dataManager->ptr = bufferPtr + V12_GRID_SIZES[format] + 128;
-                        bool success = true;
+
+                        u16* blocks = chunkData->newBlocks.data() + offsetInBlockWrite;
+                        u16* submerged = nullptr;
+                        c_bool isSubmerged = (format & 1U) != 0
+                                          && (format <= V12_4_BIT_SUBMERGED || format == V12_8_FULL_SUBMERGED);
+                        if (isSubmerged) {
+                            chunkData->hasSubmerged = true;
+                            if (chunkData->submerged.empty()) {
+                                chunkData->submerged = u16_vec(65536);
+                            }
+                            submerged = chunkData->submerged.data() + offsetInBlockWrite;
+                        }
+
                         switch(format) {
                             case V12_0_UNO:
-                                for (int i = 0; i < 128; i += 2) {
-                                    blockGrid[i] = num1;
-                                    blockGrid[i + 1] = num2;
-                                }
+                                placeSingle(blocks, static_cast<u16>(num1 | num2 << 8U));
                                 break;
                             case V12_1_BIT:
-                                success = readGrid<1>(bufferPtr, blockGrid);
-                                break;
                             case V12_1_BIT_SUBMERGED:
-                                success = readGridSubmerged<1>(bufferPtr, blockGrid, sbmrgGrid);
+                                readGrid<1>(bufferPtr, blocks, submerged);
                                 break;
                             case V12_2_BIT:
-                                success = readGrid<2>(bufferPtr, blockGrid);
-                                break;
                             case V12_2_BIT_SUBMERGED:
-                                success = readGridSubmerged<2>(bufferPtr, blockGrid, sbmrgGrid);
+                                readGrid<2>(bufferPtr, blocks, submerged);
                                 break;
                             case V12_3_BIT:
-                                success = readGrid<3>(bufferPtr, blockGrid);
-                                break;
                             case V12_3_BIT_SUBMERGED:
-                                success = readGridSubmerged<3>(bufferPtr, blockGrid, sbmrgGrid);
+                                readGrid<3>(bufferPtr, blocks, submerged);
                                 break;
                             case V12_4_BIT:
-                                success = readGrid<4>(bufferPtr, blockGrid);
-                                break;
                             case V12_4_BIT_SUBMERGED:
-                                success = readGridSubmerged<4>(bufferPtr, blockGrid, sbmrgGrid);
+                                readGrid<4>(bufferPtr, blocks, submerged);
                                 break;
                             case V12_8_FULL:
-                                fillAllBlocks<GRID_SIZE>(bufferPtr, blockGrid);
+                                placeFull(blocks, bufferPtr);
                                 break;
                             case V12_8_FULL_SUBMERGED:
-                                fillAllBlocks<GRID_SIZE>(bufferPtr, blockGrid);
-                                fillAllBlocks<GRID_SIZE>(bufferPtr + 128, sbmrgGrid);
+                                placeFull(blocks, bufferPtr);
+                                placeFull(submerged, bufferPtr + 128);
                                 break;
                             default: // this should never occur
                                 return;
                         }
-
-                        if EXPECT_FALSE (!success) {
-                            return;
-                        }
-
-                        placeBlocks(chunkData->newBlocks, blockGrid, offsetInBlockWrite);
-                        if ((format & 1U) != 0) {
-                            chunkData->hasSubmerged = true;
-                            placeBlocks(chunkData->submerged, sbmrgGrid, offsetInBlockWrite);
-                        }
                     }
                 }
             }
@@ -195,110 +333,6 @@ namespace editor::chunk {
     }
 
 
-    /**
-     * only parse the palette + positions.
-     * DOES NOT PARSE LIQUID DATA
-     * @tparam BitsPerBlock
-     * @param buffer
-     * @param grid
-     * @return
-     */
-    template<size_t BitsPerBlock>
-    bool ChunkV12::readGrid(c_u8* buffer, u8 grid[GRID_SIZE]) const {
-        c_int size = (1U << BitsPerBlock) * 2;
-        u16_vec palette(size);
-        std::copy_n(buffer, size, palette.begin());
-
-        int index = 0;
-        while (index < 64) {
-            u8 vBlocks[BitsPerBlock];
-
-            c_int row = index / 8;
-            c_int column = index % 8;
-
-            for (u32 j = 0; j < BitsPerBlock; j++) {
-                vBlocks[j] = buffer[size + row + j * 8];
-            }
-
-            u8 mask = 128U >> column;
-            u16 idx = 0;
-
-            for (u32 k = 0; k < BitsPerBlock; k++) {
-                idx |= ((vBlocks[k] & mask) >> (7 - column)) << k;
-            }
-
-            if EXPECT_FALSE (idx >= size) {
-                return false;
-            }
-
-            c_int gridIndex = index * 2;
-            c_int paletteIndex = idx * 2;
-
-            grid[gridIndex + 0] = palette[paletteIndex + 0];
-            grid[gridIndex + 1] = palette[paletteIndex + 1];
-
-            index++;
-        }
-        return true;
-    }
-
-
-
-    /**
-     * parses the palette + positions + liquid data.
-     *
-     * @tparam BitsPerBlock
-     * @param buffer
-     * @param blockGrid
-     * @param SbmrgGrid
-     * @return
-     */
-    template<size_t BitsPerBlock>
-    bool ChunkV12::readGridSubmerged(u8 const* buffer,
-        u8 blockGrid[GRID_SIZE], u8 SbmrgGrid[GRID_SIZE]) const {
-        c_int size = (1U << BitsPerBlock) * 2;
-        u16_vec palette(size);
-        std::copy_n(buffer, size, palette.begin());
-
-        for (int i = 0; i < 8; i++) {
-            u8 vBlocks[BitsPerBlock];
-            u8 vWaters[BitsPerBlock];
-
-            // this loads the pieces into a buffer
-            for (u32 j = 0; j < BitsPerBlock; j++) {
-                c_int offset = size + i + j * 8;
-                vBlocks[j] = buffer[offset];
-                vWaters[j] = buffer[offset + BitsPerBlock * 8];
-            }
-
-            for (int j = 0; j < 8; j++) {
-                u8 mask = 0b10000000U >> j;
-                u16 idxBlock = 0;
-                u16 idxSbmrg = 0;
-                for (u32 k = 0; k < BitsPerBlock; k++) {
-                    idxBlock |= (vBlocks[k] & mask) >> (7 - j) << k;
-                    idxSbmrg |= (vWaters[k] & mask) >> (7 - j) << k;
-                }
-
-                if EXPECT_FALSE (idxBlock >= size || idxSbmrg >= size) {
-                    return false;
-                }
-
-                c_int gridIndex = (i * 8 + j) * 2;
-                c_int paletteIndexBlock = idxBlock * 2;
-                c_int paletteIndexSbmrg = idxSbmrg * 2;
-                blockGrid[gridIndex + 0] = palette[paletteIndexBlock + 0];
-                blockGrid[gridIndex + 1] = palette[paletteIndexBlock + 1];
-                auto sub1 = palette[paletteIndexSbmrg + 0];
-                auto sub2 = palette[paletteIndexSbmrg + 1];
-                SbmrgGrid[gridIndex + 0] = sub1;
-                SbmrgGrid[gridIndex + 1] = sub2;
-            }
-        }
-        return true;
-    }
-
-
     // #####################################################
     // #               Write Section
     // #####################################################
@@ -318,37 +352,24 @@ namespace editor::chunk {
         dataManager->writeBytes(chunkData->heightMap.data(), 256);
         dataManager->writeInt16(chunkData->terrainPopulated);
         dataManager->writeBytes(chunkData->biomes.data(), 256);
-
-        if (chunkData->NBTData != nullptr) {
-            NBT::writeTag(chunkData->NBTData, *dataManager);
-        }
-
     }
 
 
     void ChunkV12::writeBlockData() const {
+        if (chunkData->isCompact) {
+            chunkData->expand();
+        }
         if (chunkData->newBlocks.size() != 65536) {
             chunkData->newBlocks = u16_vec(65536);
         }
-        if (chunkData->submerged.size() != 65536) {
-            chunkData->submerged = u16_vec(65536);
-        }
+        // a chunk without submerged blocks never allocates them
+        c_u16* submergedBlocks = chunkData->submerged.size() == 65536 ? chunkData->submerged.data() : nullptr;
 
 
-        u16_vec blockVector;
-        u16_vec blockLocations;
-        u16_vec sbmgdLocations; // new
-        u8 blockMap[MAP_SIZE] = {};
-
         u16 gridHeader[GRID_COUNT];
         u16 sectJumpTable[SECTION_COUNT] = {};
         u8 sectSizeTable[SECTION_COUNT] = {};
 
-
-        blockVector.reserve(GRID_COUNT);
-        blockLocations.reserve(GRID_COUNT);
-        sbmgdLocations.reserve(GRID_COUNT); // new
-
         // header ptr offsets from start
         constexpr u32 H_BEGIN           =           26;
         constexpr u32 H_SECT_JUMP_TABLE = H_BEGIN +  2; // step 2: i16 * 16 section jump table
@@ -374,100 +395,20 @@ namespace editor::chunk {
             for (u32 gridX = 0; gridX < 65536; gridX += 16384) {
                 for (u32 gridZ = 0; gridZ < 4096; gridZ += 1024) {
                     for (u32 gridY = 0; gridY < 16; gridY += 4) {
-                        blockVector.clear();
-                        blockLocations.clear();
-                        sbmgdLocations.clear();
-
-                        // iterate over the blocks in the 4x4x4 subsection of the chunk, called a grid
-                        MU bool noSubmerged = true;
+                        // TODO: handle new code for writing submerged, for now they only take up palette entries
                         c_u32 offsetInBlock = sectionIndex * 16 + gridY + gridZ + gridX;
-                        for (u32 blockX = 0; blockX < 16384; blockX += 4096) {
-                            for (u32 blockZ = 0; blockZ < 1024; blockZ += 256) {
-                                for (u32 blockY = 0; blockY < 4; blockY++) {
-
-                                    c_u32 blockIndex = offsetInBlock + blockY + blockZ + blockX;
-
-                                    u16 block = chunkData->newBlocks[blockIndex];
-                                    if (blockMap[block]) {
-                                        blockLocations.push_back(blockMap[block] - 1);
-                                    } else {
-                                        blockMap[block] = blockVector.size() + 1;
-                                        u16 location = blockVector.size();
-                                        blockVector.push_back(block);
-                                        blockLocations.push_back(location);
-                                    }
-
-                                    u16 subBlock = chunkData->submerged[blockIndex];
-                                    if (subBlock != 0) {
-                                        noSubmerged = false;
-                                        if (blockMap[subBlock] != 0) {
-                                            sbmgdLocations.push_back(blockMap[subBlock] - 1);
-                                        } else {
-                                            blockMap[subBlock] = blockVector.size() + 1;
-                                            u16 location = blockVector.size();
-                                            blockVector.push_back(subBlock);
-                                            sbmgdLocations.push_back(location);
-                                        }
-                                    }
-
-
-
-                                }
-                            }
-                        }
-
-                        // TODO: handle new code for writing submerged
-
-                        u16 gridID;
-                        u16 gridFormat;
-                        if (true /*noSubmerged*/) {
-                            switch (blockVector.size()) {
-                                case  1: gridFormat = V12_0_UNO; gridID = blockVector[0]; blockMap[blockVector[0]] = 0; goto SWITCH_END;
-                                case  2: gridFormat = V12_1_BIT; writeGrid<1,  2, 0>(blockVector, blockLocations, blockMap); break;
-
-                                case  3: gridFormat = V12_2_BIT; writeGrid<2,  3, 1>(blockVector, blockLocations, blockMap); break;
-                                case  4: gridFormat = V12_2_BIT; writeGrid<2,  4, 0>(blockVector, blockLocations, blockMap); break;
-
-                                case  5: gridFormat = V12_3_BIT; writeGrid<3,  5, 3>(blockVector, blockLocations, blockMap); break;
-                                case  6: gridFormat = V12_3_BIT; writeGrid<3,  6, 2>(blockVector, blockLocations, blockMap); break;
-                                case  7: gridFormat = V12_3_BIT; writeGrid<3,  7, 1>(blockVector, blockLocations, blockMap); break;
-                                case  8: gridFormat = V12_3_BIT; writeGrid<3,  8, 0>(blockVector, blockLocations, blockMap); break;
-
-                                case  9: gridFormat = V12_4_BIT; writeGrid<4,  9, 7>(blockVector, blockLocations, blockMap); break;
-                                case 10: gridFormat = V12_4_BIT; writeGrid<4, 10, 6>(blockVector, blockLocations, blockMap); break;
-                                case 11: gridFormat = V12_4_BIT; writeGrid<4, 11, 5>(blockVector, blockLocations, blockMap); break;
-                                case 12: gridFormat = V12_4_BIT; writeGrid<4, 12, 4>(blockVector, blockLocations, blockMap); break;
-                                case 13: gridFormat = V12_4_BIT; writeGrid<4, 13, 3>(blockVector, blockLocations, blockMap); break;
-                                case 14: gridFormat = V12_4_BIT; writeGrid<4, 14, 2>(blockVector, blockLocations, blockMap); break;
-                                case 15: gridFormat = V12_4_BIT; writeGrid<4, 15, 1>(blockVector, blockLocations, blockMap); break;
-                                case 16: gridFormat = V12_4_BIT; writeGrid<4, 16, 0>(blockVector, blockLocations, blockMap); break;
-
-                                default: gridFormat = V12_8_FULL; writeWithMaxBlocks(blockVector, blockLocations, blockMap); break;
-                            }
+                        u16 uniformBlock = 0;
+                        c_u8 gridFormat = GridEncoder::encode(
+                                chunkData->newBlocks.data() + offsetInBlock,
+                                submergedBlocks != nullptr ? submergedBlocks + offsetInBlock : nullptr,
+                                dataManager->ptr, uniformBlock);
+
+                        if (gridFormat == V12_0_UNO) {
+                            gridHeader[gridIndex++] = uniformBlock;
                         } else {
-                            switch (blockVector.size()) {
-                                case  2: gridFormat = V12_1_BIT_SUBMERGED; writeGridSubmerged<1,  2, 0>(blockVector, blockLocations, sbmgdLocations, blockMap); break;
-                                case  3: gridFormat = V12_2_BIT_SUBMERGED; writeGridSubmerged<2,  3, 1>(blockVector, blockLocations, sbmgdLocations, blockMap); break;
-                                case  4: gridFormat = V12_2_BIT_SUBMERGED; writeGridSubmerged<2,  4, 0>(blockVector, blockLocations, sbmgdLocations, blockMap); break;
-                                case  5: gridFormat = V12_3_BIT_SUBMERGED; writeGridSubmerged<3,  5, 3>(blockVector, blockLocations, sbmgdLocations, blockMap); break;
-                                case  6: gridFormat = V12_3_BIT_SUBMERGED; writeGridSubmerged<3,  6, 2>(blockVector, blockLocations, sbmgdLocations, blockMap); break;
-                                case  7: gridFormat = V12_3_BIT_SUBMERGED; writeGridSubmerged<3,  7, 1>(blockVector, blockLocations, sbmgdLocations, blockMap); break;
-                                case  8: gridFormat = V12_3_BIT_SUBMERGED; writeGridSubmerged<3,  8, 0>(blockVector, blockLocations, sbmgdLocations, blockMap); break;
-                                case  9: gridFormat = V12_4_BIT_SUBMERGED; writeGridSubmerged<4,  9, 7>(blockVector, blockLocations, sbmgdLocations, blockMap); break;
-                                case 10: gridFormat = V12_4_BIT_SUBMERGED; writeGridSubmerged<4, 10, 6>(blockVector, blockLocations, sbmgdLocations, blockMap); break;
-                                case 11: gridFormat = V12_4_BIT_SUBMERGED; writeGridSubmerged<4, 11, 5>(blockVector, blockLocations, sbmgdLocations, blockMap); break;
-                                case 12: gridFormat = V12_4_BIT_SUBMERGED; writeGridSubmerged<4, 12, 4>(blockVector, blockLocations, sbmgdLocations, blockMap); break;
-                                case 13: gridFormat = V12_4_BIT_SUBMERGED; writeGridSubmerged<4, 13, 3>(blockVector, blockLocations, sbmgdLocations, blockMap); break;
-                                case 14: gridFormat = V12_4_BIT_SUBMERGED; writeGridSubmerged<4, 14, 2>(blockVector, blockLocations, sbmgdLocations, blockMap); break;
-                                case 15: gridFormat = V12_4_BIT_SUBMERGED; writeGridSubmerged<4, 15, 1>(blockVector, blockLocations, sbmgdLocations, blockMap); break;
-                                case 16: gridFormat = V12_4_BIT_SUBMERGED; writeGridSubmerged<4, 16, 0>(blockVector, blockLocations, sbmgdLocations, blockMap); break;
-                                default: gridFormat = V12_8_FULL_SUBMERGED; writeWithMaxBlocks(blockVector, blockLocations, blockMap);
-                                                                            writeWithMaxBlocks(blockVector, sbmgdLocations, blockMap); break;
-                            }
+                            gridHeader[gridIndex++] = sectionSize / 4 | gridFormat << 12U;
+                            dataManager->incrementPointer(V12_GRID_SIZES[gridFormat]);
                         }
-                        gridID = sectionSize / 4 | gridFormat << 12U;
-                    SWITCH_END:;
-                        gridHeader[gridIndex++] = gridID;
                         sectionSize += V12_GRID_SIZES[gridFormat];
 
                     }
@@ -475,29 +416,28 @@ namespace editor::chunk {
                 }
             }
 
-            // write grid header in subsection
-            dataManager->setLittleEndian();
-            for (size_t index = 0; index < GRID_COUNT; index++) {
-                dataManager->writeInt16AtOffset(CURRENT_SECTION_START + 2 * index, gridHeader[index]);
-            }
-            dataManager->setBigEndian();
+            // write grid header in subsection, which is little endian
+            LittleDataManager(dataManager->data + CURRENT_SECTION_START, GRID_SIZE).writeArray(gridHeader, GRID_COUNT);
 
             // write section size to section size table
-            if (is0_128_slow(dataManager->data + CURRENT_SECTION_START)) {
+            if (isZeroSection(dataManager->data + CURRENT_SECTION_START)) {
                 last_section_size = 0;
                 dataManager->ptr -= GRID_SIZE;
             } else {
                 last_section_size = (GRID_SIZE + sectionSize + 255) / 256;
                 last_section_jump += last_section_size;
+                // the buffer is not cleared beforehand, so zero the rest of the last 256 bytes
+                c_u32 sectionEnd = CURRENT_SECTION_START + GRID_SIZE + sectionSize;
+                std::memset(dataManager->data + sectionEnd, 0, last_section_size * 256 - GRID_SIZE - sectionSize);
             }
             sectSizeTable[sectionIndex] = last_section_size;
         }
 
         // at root header, write section jump and size tables
-        for (size_t sectionIndex = 0; sectionIndex < SECTION_COUNT; sectionIndex++) {
-            dataManager->writeInt16AtOffset(H_SECT_JUMP_TABLE + 2 * sectionIndex, sectJumpTable[sectionIndex]);
-            dataManager->writeInt8AtOffset(H_SECT_SIZE_TABLE + sectionIndex, sectSizeTable[sectionIndex]);
-        }
+        static_assert(H_SECT_SIZE_TABLE == H_SECT_JUMP_TABLE + 2 * SECTION_COUNT);
+        BigDataManager header(dataManager->data + H_SECT_JUMP_TABLE, H_SECT_START - H_SECT_JUMP_TABLE);
+        header.writeArray(sectJumpTable, SECTION_COUNT);
+        header.writeBytes(sectSizeTable, SECTION_COUNT);
 
         c_u32 final_val = last_section_jump * 256;
 
@@ -506,128 +446,4 @@ namespace editor::chunk {
         dataManager->seek(H_SECT_START + final_val);
     }
 
-
-    /**
-     * Used to writeGameData only the palette and positions.\n
-     * It does not writeGameData liquid data
-     * 2: 1 |  2 | [_4] palette, [_8] positions
-     * 4: 2 |  4 | [_8] palette, [16] positions
-     * 6: 3 |  8 | [16] palette, [24] positions
-     * 8: 4 | 16 | [32] palette, [32] positions
-     * @tparam BitsPerBlock
-     */
-    template<size_t BitsPerBlock, size_t BlockCount, size_t EmptyCount>
-    void ChunkV12::writeGrid(u16_vec& blockVector,
-        u16_vec& blockLocations, u8 blockMap[MAP_SIZE]) const {
-
-        // write the palette data
-        dataManager->setLittleEndian();
-        // #pragma unroll
-        for (size_t blockIndex = 0; blockIndex < BlockCount; blockIndex++) {
-            dataManager->writeInt16(blockVector[blockIndex]);
-        }
-        dataManager->setBigEndian();
-
-        // fill rest of empty palette with 0xFF's
-        // TODO: IDK if this is actually necessary
-        if constexpr (EmptyCount != 0) {
-            // #pragma unroll EmptyCount
-            for (size_t rest = 0; rest < EmptyCount; rest++) {
-                dataManager->writeInt16(0xFFFF);
-            }
-        }
-
-        //  write the position data
-        //  so, write the first bit of each position, as a single u64,
-        //  then the second, third etc. N times, where N is BitsPerBlock
-        for (size_t bitIndex = 0; bitIndex < BitsPerBlock; bitIndex++) {
-            u64 position = 0;
-            for (size_t locIndex = 0; locIndex < GRID_COUNT; locIndex++) {
-                c_u64 pos = blockLocations[locIndex];
-                position |= (pos >> bitIndex & 1U) << (GRID_COUNT - locIndex - 1);
-            }
-            dataManager->writeInt64(position);
-        }
-
-        // clear the table
-        for (size_t i = 0; i < BlockCount; ++i) {
-            blockMap[blockVector[i]] = 0;
-        }
-
-    }
-
-
-    /// make this copy all u16 blocks from the grid location or whatnot
-    /// used to writeGameData full block data, instead of using palette.
-    void ChunkV12::writeWithMaxBlocks(const u16_vec& blockVector,
-        const u16_vec& blockLocations, u8 blockMap[MAP_SIZE]) const {
-        dataManager->setLittleEndian();
-        for (size_t i = 0; i < GRID_COUNT; i++) {
-            c_u16 blockPos = blockLocations[i];
-            dataManager->writeInt16(blockVector[blockPos]);
-        }
-        dataManager->setBigEndian();
-
-        for (c_u16 block : blockVector) {
-            blockMap[block] = 0;
-        }
-    }
-
-    /**
-     * Used to writeGameData only the palette and both block and sbmgd positions.\n
-     * 2: 1 |  2 | [_4] palette, [_8] positions
-     * 4: 2 |  4 | [_8] palette, [16] positions
-     * 6: 3 |  8 | [16] palette, [24] positions
-     * 8: 4 | 16 | [32] palette, [32] positions
-     * @tparam BitsPerBlock
-     */
-    template<size_t BitsPerBlock, size_t BlockCount, size_t EmptyCount>
-    void ChunkV12::writeGridSubmerged(u16_vec& blockVector, u16_vec& blockLocations,
-        const u16_vec& sbmrgLocations, u8 blockMap[MAP_SIZE]) const {
-
-        // write the palette data
-        dataManager->setLittleEndian();
-        for (size_t blockIndex = 0; blockIndex < BlockCount; blockIndex++) {
-            dataManager->writeInt16(blockVector[blockIndex]);
-        }
-        dataManager->setBigEndian();
-        // fill rest of empty palette with 0xFF's
-        // TODO: IDK if this is actually necessary
-        for (size_t rest = 0; rest < EmptyCount; rest++) {
-            dataManager->writeInt16(0xFFFF);
-        }
-
-        //  write the position data
-        //  so, write the first bit of each position, as a single u64,
-        //  then the second, third etc. N times, where N is BitsPerBlock
-        for (size_t bitIndex = 0; bitIndex < BitsPerBlock; bitIndex++) {
-            u64 position = 0;
-            for (size_t locIndex = 0; locIndex < GRID_COUNT; locIndex++) {
-                c_u64 pos = blockLocations[locIndex];
-                position |= (pos >> bitIndex & 1U) << (GRID_COUNT - locIndex - 1);
-            }
-            dataManager->writeInt64(position);
-        }
-
-        //  write the sbmgd data
-        //  so, write the first bit of each position, as a single u64,
-        //  then the second, third etc. N times, where N is BitsPerBlock
-        for (size_t bitIndex = 0; bitIndex < BitsPerBlock; bitIndex++) {
-            u64 position = 0;
-            for (size_t locIndex = 0; locIndex < GRID_COUNT; locIndex++) {
-                c_u64 pos = sbmrgLocations[locIndex];
-                position |= (pos >> bitIndex & 1U) << (GRID_COUNT - locIndex - 1);
-            }
-            dataManager->writeInt64(position);
-        }
-
-        // clear the table
-        for (size_t i = 0; i < BlockCount; ++i) {
-            blockMap[blockVector[i]] = 0;
-        }
-
-
-    }
-
 }
-
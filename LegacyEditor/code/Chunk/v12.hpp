@@ -53,35 +53,27 @@ namespace editor::chunk {
         static constexpr int SECTION_COUNT = 16;
         static constexpr int GRID_COUNT = 64;
         static constexpr int GRID_SIZE = 128;
-        static constexpr int MAP_SIZE = 65536;
 
         // Read Section
 
+        /// Decodes every grid straight into newBlocks / submerged, see readGrid in v12.cpp.
         void readBlockData() const;
-        template<size_t BitsPerBlock>
-        bool readGrid(c_u8* buffer, u8 grid[GRID_SIZE]) const;
-        template<size_t BitsPerBlock>
-        bool readGridSubmerged(u8 const* buffer, u8 blockGrid[GRID_SIZE], u8 SbmrgGrid[GRID_SIZE]) const;
+        void skipBlockData() const;
 
         // Write Section
 
+        /// Encodes every grid with GridEncoder.
         void writeBlockData() const;
 
-        template<size_t BitsPerBlock, size_t BlockCount, size_t EmptyCount>
-        void writeGrid(u16_vec& blockVector, u16_vec& blockLocations, u8 blockMap[MAP_SIZE]) const;
-        void writeWithMaxBlocks(const u16_vec& blockVector, const u16_vec& blockLocations, u8 blockMap[MAP_SIZE]) const;
-
-        template<size_t BitsPerBlock, size_t BlockCount, size_t EmptyCount>
-        void writeGridSubmerged(u16_vec& blockVector, u16_vec& blockLocations,
-                                const u16_vec& sbmrgLocations, u8 blockMap[MAP_SIZE]) const;
-
     public:
         ChunkData* chunkData = nullptr;
         DataManager* dataManager = nullptr;
 
         ChunkV12(ChunkData* chunkDataIn, DataManager* managerIn) : chunkData(chunkDataIn), dataManager(managerIn) {}
-        MU void allocChunk() const;
-        MU void readChunk() const;
+        MU void allocChunk(u8 readMask = READ_ALL) const;
+        /// Reads the parts of the chunk in "readMask" (see READ_PART), seeking past the others.
+        MU void readChunk(u8 readMask = READ_ALL) const;
+        /// Writes everything but the NBT, which ChunkManager::writeChunk puts after it.
         MU void writeChunk() const;
 
     };
@@ -3,21 +3,27 @@
 #include <cstring>
 #include <algorithm>
 
+#include "LegacyEditor/code/Chunk/gridEncoder.hpp"
 #include "LegacyEditor/code/Chunk/helpers.hpp"
-#include "LegacyEditor/utils/NBT.hpp"
+#include "LegacyEditor/utils/NBTLazy.hpp"
 #include "LegacyEditor/utils/dataManager.hpp"
+#include "LegacyEditor/utils/endianDataManager.hpp"
 
 
 namespace editor::chunk {
 
-    void ChunkV13::allocChunk() const {
+    void ChunkV13::allocChunk(c_u8 readMask) const {
         chunkData->DataGroupCount = 0;
-        chunkData->newBlocks = u16_vec(65536);
-        chunkData->submerged = u16_vec(65536);
-        chunkData->skyLight = u8_vec(32768);
-        chunkData->blockLight = u8_vec(32768);
-        chunkData->heightMap = u8_vec(256);
-        chunkData->biomes = u8_vec(256);
+        chunkData->newBlocks = (readMask & READ_BLOCKS) != 0 ? u16_vec(65536) : u16_vec();
+        u16_vec().swap(chunkData->submerged);
+        chunkData->hasSubmerged = false;
+        std::vector<BlockSection>().swap(chunkData->blockSections);
+        std::vector<BlockSection>().swap(chunkData->submergedSections);
+        chunkData->isCompact = false;
+        chunkData->skyLight = (readMask & READ_LIGHTS) != 0 ? u8_vec(32768) : u8_vec();
+        chunkData->blockLight = (readMask & READ_LIGHTS) != 0 ? u8_vec(32768) : u8_vec();
+        chunkData->heightMap = (readMask & READ_HEIGHTMAP) != 0 ? u8_vec(256) : u8_vec();
+        chunkData->biomes = (readMask & READ_BIOMES) != 0 ? u8_vec(256) : u8_vec();
     }
 
     // #####################################################
@@ -25,8 +31,8 @@ namespace editor::chunk {
     // #####################################################
 
 
-    void ChunkV13::readChunk() {
-        allocChunk();
+    void ChunkV13::readChunk(c_u8 readMask) {
+        allocChunk(readMask);
 
         maxGridAmount = dataManager->readInt16();
         chunkData->chunkX = static_cast<i32>(dataManager->readInt32());
@@ -34,22 +40,31 @@ namespace editor::chunk {
         chunkData->lastUpdate = static_cast<i64>(dataManager->readInt64());
         chunkData->inhabitedTime = static_cast<i64>(dataManager->readInt64());
 
-        readBlockData();
+        if (readMask & READ_BLOCKS) {
+            readBlockData();
+        } else {
+            skipBlockData();
+        }
 
-        {
-        c_auto dataArray = readGetDataBlockVector<4>(chunkData, dataManager);
-        readDataBlock(dataArray[0], dataArray[1], chunkData->skyLight);
-        readDataBlock(dataArray[2], dataArray[3], chunkData->blockLight);
+        if (readMask & READ_LIGHTS) {
+            c_auto dataArray = readGetDataBlockVector<4>(chunkData, dataManager);
+            readDataBlock(dataArray[0], dataArray[1], chunkData->skyLight);
+            readDataBlock(dataArray[2], dataArray[3], chunkData->blockLight);
+        } else {
+            skipDataBlocks<4>(dataManager);
         }
 
-        dataManager->readBytes(256, chunkData->heightMap.data());
-        chunkData->terrainPopulated = static_cast<i16>(dataManager->readInt16());
-        dataManager->readBytes(256, chunkData->biomes.data());
+        readHeightMapAndBiomes(chunkData, dataManager, readMask);
 
-        if (*dataManager->ptr == 0x0A) {
-            chunkData->NBTData = NBT::readTag(*dataManager);
+        // only indexed, the tags are read once something asks for them (see ChunkData::getNBTData)
+        if ((readMask & READ_NBT) != 0 && *dataManager->ptr == 0x0A) {
+            chunkData->NBTDataLazy = new NBTLazyCompound();
+            if (chunkData->NBTDataLazy->read(*dataManager) != SUCCESS) {
+                printf("chunk %s has corrupt NBT, it is left empty\n", chunkData->getCoords().c_str());
+            }
         }
 
+        chunkData->readMask = readMask;
         chunkData->validChunk = true;
     }
 
@@ -78,13 +93,20 @@ namespace editor::chunk {
 
 
 
-    void ChunkV13::readBlockData() const {
+    /// The section jump table is followed by the blocks, which end at the highest section address.
+    void ChunkV13::skipBlockData() const {
         c_u32 maxSectionAddress = dataManager->readInt16() << 8;
+        dataManager->seek(DATA_HEADER_SIZE + SECTION_HEADER_SIZE + maxSectionAddress);
+    }
+
+
+    void ChunkV13::readBlockData() const {
+        BigDataManager header(*dataManager);
+        c_u32 maxSectionAddress = header.readInt16() << 8;
 
         u16_vec sectionJumpTable(16);
-        for (u32 i = 0; i < 16; i++) {
-            sectionJumpTable[i] = dataManager->readInt16();
-        }
+        header.readArray(sectionJumpTable.data(), 16);
+        header.sync(*dataManager);
 
         // size: 16
         c_u8* sizeOfSubChunks = dataManager->ptr;
@@ -167,6 +189,9 @@ namespace editor::chunk {
                 placeBlocks(chunkData->newBlocks, blockGrid, offsetInBlockWrite);
                 if ((format & 1) != 0) {
                     chunkData->hasSubmerged = true;
+                    if (chunkData->submerged.empty()) {
+                        chunkData->submerged = u16_vec(65536);
+                    }
                     placeBlocks(chunkData->submerged, sbmrgGrid, offsetInBlockWrite);
                 }
             }
@@ -291,24 +316,16 @@ namespace editor::chunk {
         dataManager->writeBytes(chunkData->heightMap.data(), 256);
         dataManager->writeInt16(chunkData->terrainPopulated);
         dataManager->writeBytes(chunkData->biomes.data(), 256);
-
-        if (chunkData->NBTData != nullptr) {
-            NBT::writeTag(chunkData->NBTData, *dataManager);
-        }
-
     }
 
     void ChunkV13::writeBlockData() const {
+        if (chunkData->isCompact) {
+            chunkData->expand();
+        }
 
-        u16_vec blockVector;
-        u16_vec blockLocations;
         u16 gridHeader[GRID_COUNT];
         u16 sectJumpTable[SECTION_COUNT] = {};
         u8 sectSizeTable[SECTION_COUNT] = {};
-        u8 blockMap[MAP_SIZE] = {0};
-
-        blockVector.reserve(GRID_COUNT);
-        blockLocations.reserve(GRID_COUNT);
 
         // header ptr offsets from start
         // TODO: these will need to be tweaked!
@@ -333,78 +350,31 @@ namespace editor::chunk {
 
             dataManager->ptr = dataManager->data + H_SECT_START + CURRENT_INC_SECT_JUMP + GRID_SIZE;
 
-            u32 blockX, blockY, blockZ;
-
             for (u32 gridX = 0; gridX < 65536; gridX += 16384) {
             for (u32 gridZ = 0; gridZ < 4096; gridZ += 1024) {
             for (u32 gridY = 0; gridY < 16; gridY += 4) {
-                blockVector.clear(); blockLocations.clear();
-
-                // iterate over the blocks in the 4x4x4 subsection of the chunk, called a grid
                 c_u32 offsetInBlock = sectionIndex * 16 + gridY + gridZ + gridX;
-                for (blockX = 0; blockX < 16384; blockX += 4096) {
-                for (blockZ = 0; blockZ < 1024; blockZ += 256) {
-                for (blockY = 0; blockY < 4; blockY++) {
-
-                    c_u32 blockIndex = offsetInBlock + blockY + blockZ + blockX;
-
-                    if (u16 block = chunkData->newBlocks[blockIndex]; blockMap[block]) {
-                        blockLocations.push_back(blockMap[block] - 1);
-                    } else {
-                        blockMap[block] = blockVector.size() + 1;
-                        u16 location = blockVector.size();
-                        blockVector.push_back(block);
-                        blockLocations.push_back(location);
-                    }
-
-                }
-                }
+                u16 uniformBlock = 0;
+                c_u8 gridFormat = GridEncoder::encode(
+                        chunkData->newBlocks.data() + offsetInBlock, nullptr, dataManager->ptr, uniformBlock);
+
+                if (gridFormat == V13_0_UNO) {
+                    gridHeader[gridIndex++] = uniformBlock;
+                } else {
+                    gridHeader[gridIndex++] = sectionSize / 4 | gridFormat << 12;
+                    dataManager->incrementPointer(V13_GRID_SIZES[gridFormat]);
                 }
-
-                u16 gridID;
-                u16 gridFormat;
-                switch (blockVector.size()) {
-                    case  1: gridFormat = V13_0_UNO; gridID = blockVector[0]; blockMap[blockVector[0]] = 0; goto SWITCH_END;
-
-                    case  2: gridFormat = V13_1_BIT; writeGrid<1,  2, 0>(blockVector, blockLocations, blockMap); break;
-
-                    case  3: gridFormat = V13_2_BIT; writeGrid<2,  3, 1>(blockVector, blockLocations, blockMap); break;
-                    case  4: gridFormat = V13_2_BIT; writeGrid<2,  4, 0>(blockVector, blockLocations, blockMap); break;
-
-                    case  5: gridFormat = V13_3_BIT; writeGrid<3,  5, 3>(blockVector, blockLocations, blockMap); break;
-                    case  6: gridFormat = V13_3_BIT; writeGrid<3,  6, 2>(blockVector, blockLocations, blockMap); break;
-                    case  7: gridFormat = V13_3_BIT; writeGrid<3,  7, 1>(blockVector, blockLocations, blockMap); break;
-                    case  8: gridFormat = V13_3_BIT; writeGrid<3,  8, 0>(blockVector, blockLocations, blockMap); break;
-
-                    case  9: gridFormat = V13_4_BIT; writeGrid<4,  9, 7>(blockVector, blockLocations, blockMap); break;
-                    case 10: gridFormat = V13_4_BIT; writeGrid<4, 10, 6>(blockVector, blockLocations, blockMap); break;
-                    case 11: gridFormat = V13_4_BIT; writeGrid<4, 11, 5>(blockVector, blockLocations, blockMap); break;
-                    case 12: gridFormat = V13_4_BIT; writeGrid<4, 12, 4>(blockVector, blockLocations, blockMap); break;
-                    case 13: gridFormat = V13_4_BIT; writeGrid<4, 13, 3>(blockVector, blockLocations, blockMap); break;
-                    case 14: gridFormat = V13_4_BIT; writeGrid<4, 14, 2>(blockVector, blockLocations, blockMap); break;
-                    case 15: gridFormat = V13_4_BIT; writeGrid<4, 15, 1>(blockVector, blockLocations, blockMap); break;
-                    case 16: gridFormat = V13_4_BIT; writeGrid<4, 16, 0>(blockVector, blockLocations, blockMap); break;
-
-                    default: gridFormat = V13_8_FULL; writeWithMaxBlocks(blockVector, blockLocations, blockMap); break;
-                }
-                gridID = sectionSize / 4 | gridFormat << 12;
-            SWITCH_END:;
-                gridHeader[gridIndex++] = gridID;
                 sectionSize += V13_GRID_SIZES[gridFormat];
 
             }
             }
             }
 
-            // write grid header in subsection
-            dataManager->setLittleEndian();
-            for (size_t index = 0; index < GRID_COUNT; index++) {
-                dataManager->writeInt16AtOffset(CURRENT_SECTION_START + 2 * index, gridHeader[index]);
-            }
-            dataManager->setBigEndian();
+            // write grid header in subsection, which is little endian
+            LittleDataManager(dataManager->data + CURRENT_SECTION_START, GRID_SIZE).writeArray(gridHeader, GRID_COUNT);
 
             // write section size to section size table
-            if (is0_128_slow(dataManager->data + CURRENT_SECTION_START)) {
+            if (isZeroSection(dataManager->data + CURRENT_SECTION_START)) {
                 last_section_size = 0;
                 dataManager->ptr -= GRID_SIZE;
             } else {
@@ -415,10 +385,10 @@ namespace editor::chunk {
         }
 
         // at root header, write section jump and size tables
-        for (size_t sectionIndex = 0; sectionIndex < SECTION_COUNT; sectionIndex++) {
-            dataManager->writeInt16AtOffset(H_SECT_JUMP_TABLE + 2 * sectionIndex, sectJumpTable[sectionIndex]);
-            dataManager->writeInt8AtOffset(H_SECT_SIZE_TABLE + sectionIndex, sectSizeTable[sectionIndex]);
-        }
+        static_assert(H_SECT_SIZE_TABLE == H_SECT_JUMP_TABLE + 2 * SECTION_COUNT);
+        BigDataManager header(dataManager->data + H_SECT_JUMP_TABLE, H_SECT_START - H_SECT_JUMP_TABLE);
+        header.writeArray(sectJumpTable, SECTION_COUNT);
+        header.writeBytes(sectSizeTable, SECTION_COUNT);
 
         c_u32 final_val = last_section_jump * 256;
 
@@ -427,66 +397,4 @@ namespace editor::chunk {
         dataManager->seek(H_SECT_START + final_val);
     }
 
-
-    /**
-     * Used to writeGameData only the palette and positions.\n
-     * It does not writeGameData liquid data
-     * 2: 1 |  2 | [_4] palette, [_8] positions
-     * 4: 2 |  4 | [_8] palette, [16] positions
-     * 6: 3 |  8 | [16] palette, [24] positions
-     * 8: 4 | 16 | [32] palette, [32] positions
-     * @tparam BitsPerBlock
-     */
-    template<size_t BitsPerBlock, size_t BlockCount, size_t EmptyCount>
-    void ChunkV13::writeGrid(u16_vec& blockVector, u16_vec& blockLocations, u8 blockMap[MAP_SIZE]) const {
-
-        // write the block data
-        dataManager->setLittleEndian();
-        for (size_t blockIndex = 0; blockIndex < BlockCount; blockIndex++) {
-            dataManager->writeInt16(blockVector[blockIndex]);
-        }
-        dataManager->setBigEndian();
-
-        // fill rest of empty palette with 0xFF's
-        // TODO: IDK if this is actually necessary
-        for (size_t rest = 0; rest < EmptyCount; rest++) {
-            dataManager->writeInt16(0xFFFF);
-        }
-
-        //  write the position data
-        //  so, write the first bit of each position, as a single u64,
-        //  then the second, third etc. N times, where N is BitsPerBlock
-        for (size_t bitIndex = 0; bitIndex < BitsPerBlock; bitIndex++) {
-            u64 position = 0;
-            for (size_t locIndex = 0; locIndex < GRID_COUNT; locIndex++) {
-                c_u64 pos = blockLocations[locIndex];
-                position |= (pos >> bitIndex & 1) << (GRID_COUNT - locIndex - 1);
-            }
-            dataManager->writeInt64(position);
-        }
-
-        // clear the table
-        for (size_t i = 0; i < BlockCount; ++i) {
-            blockMap[blockVector[i]] = 0;
-        }
-
-    }
-
-
-    /// make this copy all u16 blocks from the grid location or whatnot
-    /// used to writeGameData full block data, instead of using palette.
-    void ChunkV13::writeWithMaxBlocks(const u16_vec& blockVector, const u16_vec& blockLocations, u8 blockMap[MAP_SIZE]) const {
-        dataManager->setLittleEndian();
-        for (size_t i = 0; i < GRID_COUNT; i++) {
-            c_u16 blockPos = blockLocations[i];
-            dataManager->writeInt16(blockVector[blockPos]);
-        }
-        dataManager->setBigEndian();
-
-        for (c_u16 block : blockVector) {
-            blockMap[block] = 0;
-        }
-    }
-
 }
-
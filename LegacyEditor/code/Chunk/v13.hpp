@@ -42,11 +42,11 @@ namespace editor::chunk {
         static constexpr u32 SECTION_COUNT = 16;
         static constexpr u32 GRID_COUNT = 64;
         static constexpr u32 GRID_SIZE = 128;
-        static constexpr u32 MAP_SIZE = 65536;
 
         // Read Section
 
         void readBlockData() const;
+        void skipBlockData() const;
         template<size_t BitsPerBlock>
         bool readGrid(c_u8* buffer, u8 grid[128]) const;
         template<size_t BitsPerBlock>
@@ -54,10 +54,8 @@ namespace editor::chunk {
 
         // Write Section
 
+        /// Encodes every grid with GridEncoder.
         void writeBlockData() const;
-        template<size_t BitsPerBlock, size_t BlockCount, size_t EmptyCount>
-        void writeGrid(u16_vec& blockVector, u16_vec& blockLocations, u8 blockMap[MAP_SIZE]) const;
-        void writeWithMaxBlocks(const u16_vec& blockVector, const u16_vec& blockLocations, u8 blockMap[MAP_SIZE]) const;
 
     public:
         ChunkData* chunkData = nullptr;
@@ -65,8 +63,10 @@ namespace editor::chunk {
         u16 maxGridAmount = 0;
 
         ChunkV13(ChunkData* chunkDataIn, DataManager* managerIn) : chunkData(chunkDataIn), dataManager(managerIn) {}
-        MU void allocChunk() const;
-        MU void readChunk();
+        MU void allocChunk(u8 readMask = READ_ALL) const;
+        /// Reads the parts of the chunk in "readMask" (see READ_PART), seeking past the others.
+        MU void readChunk(u8 readMask = READ_ALL);
+        /// Writes everything but the NBT, which ChunkManager::writeChunk puts after it.
         MU void writeChunk() const;
 
     };
@@ -1,8 +1,11 @@
 #include "ConsoleParser.hpp"
 
 
-int ConsoleParser::readListing(const Data &dataIn) {
-    DataManager managerIn(dataIn, consoleIsBigEndian(myConsole));
+int ConsoleParser::readListing(Data &dataIn) {
+    myListingPtr->myAllFiles.clear();
+    myListingPtr->mySourceData.steal(dataIn);
+    const Data& source = myListingPtr->mySourceData;
+    DataManager managerIn(source, consoleIsBigEndian(myConsole));
 
     c_u32 indexOffset = managerIn.readInt32();
     u32 fileCount = managerIn.readInt32();
@@ -15,8 +18,6 @@ int ConsoleParser::readListing(const Data &dataIn) {
         fileCount /= 136;
     }
 
-    myListingPtr->myAllFiles.clear();
-
     MU u32 totalSize = 0;
     for (u32 fileIndex = 0; fileIndex < fileCount; fileIndex++) {
         managerIn.seek(indexOffset + fileIndex * FOOTER_ENTRY_SIZE);
@@ -31,12 +32,14 @@ int ConsoleParser::readListing(const Data &dataIn) {
         }
         totalSize += fileSize;
 
-        managerIn.seek(index);
-        u8* data = managerIn.readBytes(fileSize);
+        if (static_cast<u64>(index) + fileSize > source.size) {
+            return printf_err(INVALID_SAVE, "file '%s' goes outside the listing\n", fileName.c_str());
+        }
 
         // TODO: make sure all files are set with the correct console
-        myListingPtr->myAllFiles.emplace_back(myConsole, data, fileSize, timestamp);
+        myListingPtr->myAllFiles.emplace_back(myConsole, nullptr, 0, timestamp);
         editor::LCEFile &file = myListingPtr->myAllFiles.back();
+        file.data.view(source.start() + index, fileSize);
 
         if (fileName.ends_with(".mcr")) {
             if (fileName.starts_with("DIM-1")) {
@@ -98,34 +101,33 @@ int ConsoleParser::readListing(const Data &dataIn) {
 }
 
 
-Data ConsoleParser::writeListing(const lce::CONSOLE consoleOut) const {
+static u32 getFooterEntrySize(c_i32 currentVersion) {
+    return currentVersion <= 1 ? 136 : 144;
+}
 
-    // step 1: get the file count and size of all sub-files
-    c_u32 fileCount = myListingPtr->myAllFiles.size();
-    c_i32 currentVersion = myListingPtr->myReadSettings.getCurrentVersion();
 
+u32 ConsoleParser::getListingSize() const {
     u32 fileDataSize = 0;
     for (const editor::LCEFile& file: myListingPtr->myAllFiles) {
         fileDataSize += file.data.getSize();
     }
+    c_u32 footerEntrySize = getFooterEntrySize(myListingPtr->myReadSettings.getCurrentVersion());
+    return FILELISTING_HEADER_SIZE + fileDataSize + footerEntrySize * myListingPtr->myAllFiles.size();
+}
 
-    c_u32 fileInfoOffset = fileDataSize + 12;
-
-    u32 FOOTER_ENTRY_SIZE = 144;
-    if (currentVersion <= 1) {
-        FOOTER_ENTRY_SIZE = 136;
-    }
-
-    // step 2: find total binary size and create its data buffer
-    c_u32 totalFileSize = fileInfoOffset + FOOTER_ENTRY_SIZE * fileCount;
 
-    Data dataOut;
-    dataOut.allocate(totalFileSize);
-    memset(dataOut.data, 0, dataOut.size);
+int ConsoleParser::writeListing(const lce::CONSOLE consoleOut, WriteStream& theStream) const {
+    int status;
 
-    DataManager managerOut(dataOut, consoleIsBigEndian(consoleOut));
+    // step 1: get the file count and size of all sub-files
+    c_u32 fileCount = myListingPtr->myAllFiles.size();
+    c_i32 currentVersion = myListingPtr->myReadSettings.getCurrentVersion();
+    c_u32 FOOTER_ENTRY_SIZE = getFooterEntrySize(currentVersion);
+    c_u32 fileInfoOffset = getListingSize() - FOOTER_ENTRY_SIZE * fileCount;
 
-    // step 3: write start
+    // step 2: write start
+    u8 header[FILELISTING_HEADER_SIZE];
+    DataManager managerOut(header, FILELISTING_HEADER_SIZE, consoleIsBigEndian(consoleOut));
     managerOut.writeInt32(fileInfoOffset);
     u32 innocuousVariableName = fileCount;
     if (currentVersion <= 1) {
@@ -134,31 +136,40 @@ Data ConsoleParser::writeListing(const lce::CONSOLE consoleOut) const {
     managerOut.writeInt32(innocuousVariableName);
     managerOut.writeInt16(myListingPtr->myReadSettings.getOldestVersion());
     managerOut.writeInt16(currentVersion);
+    if (status = theStream.write(header, FILELISTING_HEADER_SIZE); status != SUCCESS) {
+        return status;
+    }
 
-    // step 4: write each files data
+    // step 3: write each files data, straight from where it is held
     // I am using additionalData as the offset into the file its data is at
     u32 index = FILELISTING_HEADER_SIZE;
     for (editor::LCEFile& fileIter : myListingPtr->myAllFiles) {
         fileIter.additionalData = index;
         index += fileIter.data.getSize();
-        managerOut.writeFile(fileIter);
+        if (status = theStream.write(fileIter.data.start(), fileIter.data.getSize()); status != SUCCESS) {
+            return status;
+        }
     }
 
-    // step 5: write file metadata
+    // step 4: write file metadata, one entry at a time
+    u8 footerEntry[144];
     for (const editor::LCEFile& fileIter: myListingPtr->myAllFiles) {
-        // printf("%2u. (@%7u)[%7u] - %s\n", count + 1, fileIter
-        // .additionalData, fileIter.size, fileIter.name.c_str());
+        std::memset(footerEntry, 0, FOOTER_ENTRY_SIZE);
+        DataManager entryOut(footerEntry, FOOTER_ENTRY_SIZE, consoleIsBigEndian(consoleOut));
         std::string fileIterName = fileIter.constructFileName(consoleOut,
                                                               myListingPtr->myReadSettings.getHasSepRegions());
-        managerOut.writeWStringFromString(fileIterName, WSTRING_SIZE);
-        managerOut.writeInt32(fileIter.data.getSize());
-        managerOut.writeInt32(fileIter.additionalData);
+        entryOut.writeWStringFromString(fileIterName, WSTRING_SIZE);
+        entryOut.writeInt32(fileIter.data.getSize());
+        entryOut.writeInt32(fileIter.additionalData);
         if (currentVersion > 1) {
-            managerOut.writeInt64(fileIter.timestamp);
+            entryOut.writeInt64(fileIter.timestamp);
+        }
+        if (status = theStream.write(footerEntry, FOOTER_ENTRY_SIZE); status != SUCCESS) {
+            return status;
         }
     }
 
-    return dataOut;
+    return SUCCESS;
 }
 
 
@@ -230,9 +241,12 @@ int ConsoleParser::readExternalFolder(const fs::path& inDirPath) {
         std::string fileNameStr = file.path().filename().string();
 
         // open the file
-        DataManager manager_in;
+        MappedFile fileIn;
+        if (fileIn.open(file.path()) != SUCCESS) {
+            return printf_err(FILE_ERROR, ERROR_4, filePathStr.c_str());
+        }
+        DataManager manager_in(fileIn);
         manager_in.setLittleEndian(); // all of newgen is little endian
-        manager_in.readFromFile(filePathStr);
         c_u32 fileSize = manager_in.readInt32();
 
         Data dat_out;
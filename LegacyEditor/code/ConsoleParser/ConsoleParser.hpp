@@ -3,6 +3,9 @@
 #include "LegacyEditor/code/FileListing/fileListing.hpp"
 #include "LegacyEditor/utils/RLE/rle_nsxps4.hpp"
 #include "LegacyEditor/utils/dataManager.hpp"
+#include "LegacyEditor/utils/deflateBackend.hpp"
+#include "LegacyEditor/utils/timer.hpp"
+#include "LegacyEditor/utils/writeStream.hpp"
 
 #include "headerUnion.hpp"
 
@@ -28,11 +31,19 @@ protected:
     mutable editor::FileListing* myListingPtr;
 
     ND virtual int inflateListing() = 0;
-    ND virtual int deflateListing(const fs::path& gameDataPath, Data& inflatedData, Data& deflatedData) const = 0;
-
-
-    ND int readListing(const Data &dataIn);
-    ND Data writeListing(lce::CONSOLE consoleOut) const;
+    /**
+     * Writes the (compressed) listing to "gameDataPath" through "theFileOut", which is left closed.
+     * @param theLevel the deflate level, for consoles that deflate their listing
+     */
+    ND virtual int deflateListing(const fs::path& gameDataPath, FileWriteStream& theFileOut, int theLevel) const = 0;
+
+
+    /// takes ownership of "dataIn", the files that are read out of it point into it.
+    ND int readListing(Data &dataIn);
+    /// The size of the uncompressed listing that writeListing produces.
+    ND u32 getListingSize() const;
+    /// Streams the header, every file and then the footer into "theStream", without finishing it.
+    ND int writeListing(lce::CONSOLE consoleOut, WriteStream& theStream) const;
 
     void readFileInfo() const;
     // writeFileInfo...
@@ -5,7 +5,6 @@
 
 #include "include/ghc/fs_std.hpp"
 #include "include/sfo/sfo.hpp"
-#include "include/tinf/tinf.h"
 
 #include "LegacyEditor/code/FileListing/fileListing.hpp"
 #include "LegacyEditor/utils/utils.hpp"
@@ -54,48 +53,34 @@ namespace editor {
         /// TODO: figure out if this comment is actually important or not
         /// TODO: check from regionFile chunk what console it is if uncompressed
         int inflateListing() override {
-            Data data;
-            data.setScopeDealloc(true);
-
-            FILE *f_in = fopen(myFilePath.string().c_str(), "rb");
-            if (f_in == nullptr) {
+            MappedFile fileIn;
+            if (fileIn.open(myFilePath) != SUCCESS) {
                 return printf_err(FILE_ERROR, ERROR_4, myFilePath.string().c_str());
             }
-
-            fseek(f_in, 0, SEEK_END);
-            u64 input_size = ftell(f_in);
-            fseek(f_in, 0, SEEK_SET);
-            if (input_size < 12) {
-                fclose(f_in);
+            if (fileIn.getSize() < 12) {
                 return printf_err(FILE_ERROR, ERROR_5);
             }
             HeaderUnion headerUnion{};
-            fread(&headerUnion, 1, 12, f_in);
+            std::memcpy(&headerUnion, fileIn.start(), 12);
 
+            Data data;
+            data.setScopeDealloc(true);
             u32 final_size = headerUnion.getDestSize();
             if(!data.allocate(final_size)) {
-                fclose(f_in);
                 return printf_err(MALLOC_FAILED, ERROR_1, final_size);
             }
 
-            input_size -= 12;
-            Data src;
-            src.setScopeDealloc(true);
-            if(!src.allocate(input_size)) {
-                fclose(f_in);
-                return printf_err(MALLOC_FAILED, ERROR_1, input_size);
+            // inflate straight out of the mapped file
+            int status;
+            {
+                const StageTimer timer(STAGE::INFLATE);
+                status = getDeflateBackend().inflateRaw(data.start(), final_size, fileIn.start() + 12, fileIn.getSize() - 12);
             }
-
-            fseek(f_in, 12, SEEK_SET);
-            fread(src.start(), 1, src.size, f_in);
-            fclose(f_in);
-
-            tinf_uncompress(data.start(), &final_size, src.start(), src.getSize());
-            if (final_size == 0) {
+            if (status != SUCCESS || final_size == 0) {
                 return printf_err(DECOMPRESS, "%s", ERROR_3);
             }
 
-            int status = ConsoleParser::readListing(data);
+            status = ConsoleParser::readListing(data);
             if (status != 0) {
                 return -1;
             }
@@ -158,24 +143,22 @@ namespace editor {
 
             // GAMEDATA
             fs::path gameDataPath = rootPath / "GAMEDATA";
-            Data inflatedData = ConsoleParser::writeListing(myConsole);
-            Data deflatedData;
-            deflatedData.setScopeDealloc(true);
-            status = deflateListing(gameDataPath, inflatedData, deflatedData);
+            FileWriteStream gameDataOut;
+            status = deflateListing(gameDataPath, gameDataOut, theSettings.getCompressionLevel());
             if (status != 0) return printf_err(status,
                 "failed to compress fileListing\n");
             theSettings.setOutFilePath(gameDataPath);
-            printf("gamedata final size: %u\n", deflatedData.size);
+            printf("gamedata final size: %u\n", gameDataOut.getSize());
 
 
             // METADATA
             fs::path metadataPath = rootPath / "METADATA";
-            c_u32 crc1 = crc(deflatedData.data, deflatedData.size);
+            c_u32 crc1 = gameDataOut.getCrc();
             c_u32 crc2 = crc(fileInfoData.data, fileInfoData.size);
             u8 metadata[256] = {0};
             DataManager managerMETADATA(metadata, 256);
             managerMETADATA.writeInt32(3);
-            managerMETADATA.writeInt32(deflatedData.size);
+            managerMETADATA.writeInt32(gameDataOut.getSize());
             managerMETADATA.writeInt32(fileInfoData.size);
             managerMETADATA.writeInt32(crc1);
             managerMETADATA.writeInt32(crc2);
@@ -213,12 +196,7 @@ namespace editor {
         }
 
 
-        ND int deflateListing(MU const fs::path& gameDataPath, MU Data& inflatedData, MU Data& deflatedData) const override {
-
-            MU uLong deflatedSize = compressBound(static_cast<uLong>(inflatedData.size));
-
-
-
+        ND int deflateListing(MU const fs::path& gameDataPath, MU FileWriteStream& theFileOut, MU int theLevel) const override {
 
             return NOT_IMPLEMENTED;
         }
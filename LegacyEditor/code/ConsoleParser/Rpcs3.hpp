@@ -47,33 +47,22 @@ namespace editor {
         }
 
 
+        /**
+         * RPCS3 saves are not compressed, so the file is mapped in
+         * and the listing's files point straight into it.
+         */
         int inflateListing() override {
-            Data data;
-            data.setScopeDealloc(true);
-
-            FILE *f_in = fopen(myFilePath.string().c_str(), "rb");
-            if (f_in == nullptr) {
+            MappedFile& fileIn = myListingPtr->mySourceFile;
+            if (fileIn.open(myFilePath) != SUCCESS) {
                 return printf_err(FILE_ERROR, ERROR_4, myFilePath.string().c_str());
             }
-
-            fseek(f_in, 0, SEEK_END);
-            c_u64 input_size = ftell(f_in);
-            fseek(f_in, 0, SEEK_SET);
-            if (input_size < 12) {
-                fclose(f_in);
+            if (fileIn.getSize() < 12) {
+                fileIn.close();
                 return printf_err(FILE_ERROR, ERROR_5);
             }
-            HeaderUnion headerUnion{};
-            fread(&headerUnion, 1, 12, f_in);
 
-            if(!data.allocate(input_size)) {
-                fclose(f_in);
-                return printf_err(MALLOC_FAILED, ERROR_1, input_size);
-            }
-
-            fseek(f_in, 0, SEEK_SET);
-            fread(data.start(), 1, data.size, f_in);
-            fclose(f_in);
+            Data data;
+            data.view(fileIn.start(), fileIn.getSize());
 
             int status = readListing(data);
             if (status != 0) {
@@ -139,25 +128,22 @@ namespace editor {
 
             // GAMEDATA
             fs::path gameDataPath = rootPath / "GAMEDATA";
-            Data inflatedData = writeListing(myConsole);
-            inflatedData.setScopeDealloc(true);
-            Data deflatedData;
-            deflatedData.setScopeDealloc(true);
-            status = deflateListing(gameDataPath, inflatedData, deflatedData);
+            FileWriteStream gameDataOut;
+            status = deflateListing(gameDataPath, gameDataOut, theSettings.getCompressionLevel());
             if (status != 0) return printf_err(status,
                 "failed to compress fileListing\n");
             theSettings.setOutFilePath(gameDataPath);
-            printf("gamedata final size: %u\n", deflatedData.size);
+            printf("gamedata final size: %u\n", gameDataOut.getSize());
 
 
             // METADATA
             fs::path metadataPath = rootPath / "METADATA";
-            c_u32 crc1 = crc(deflatedData.data, deflatedData.size);
+            c_u32 crc1 = gameDataOut.getCrc();
             c_u32 crc2 = crc(fileInfoData.data, fileInfoData.size);
             u8 metadata[256] = {0};
             DataManager managerMETADATA(metadata, 256);
             managerMETADATA.writeInt32(3);
-            managerMETADATA.writeInt32(deflatedData.size);
+            managerMETADATA.writeInt32(gameDataOut.getSize());
             managerMETADATA.writeInt32(fileInfoData.size);
             managerMETADATA.writeInt32(crc1);
             managerMETADATA.writeInt32(crc2);
@@ -199,11 +185,11 @@ namespace editor {
         }
 
 
-        ND int deflateListing(const fs::path& gameDataPath, Data& inflatedData, MU Data& deflatedData) const override {
-            deflatedData.steal(inflatedData);
-
-            // file operations
-            int status = DataManager(deflatedData).writeToFile(gameDataPath);
+        /// rpcs3 does not compress the listing, it is written out as it is built.
+        ND int deflateListing(const fs::path& gameDataPath, FileWriteStream& theFileOut, MU int theLevel) const override {
+            int status = theFileOut.open(gameDataPath);
+            if (status == SUCCESS) status = writeListing(myConsole, theFileOut);
+            if (status == SUCCESS) status = theFileOut.finish();
             if (status != 0) return printf_err(status,
                 "failed to write savefile to \"%s\"\n",
                 gameDataPath.string().c_str());
@@ -3,7 +3,6 @@
 #include <vector>
 
 #include "include/ghc/fs_std.hpp"
-#include "include/tinf/tinf.h"
 
 #include "LegacyEditor/code/FileListing/fileListing.hpp"
 #include "LegacyEditor/utils/utils.hpp"
@@ -43,43 +42,29 @@ namespace editor {
 
 
         int inflateListing() override {
-            Data data;
-            data.setScopeDealloc(true);
-
-            FILE *f_in = fopen(myFilePath.string().c_str(), "rb");
-            if (f_in == nullptr) {
+            MappedFile fileIn;
+            if (fileIn.open(myFilePath) != SUCCESS) {
                 return printf_err(FILE_ERROR, ERROR_4, myFilePath.string().c_str());
             }
-
-            fseek(f_in, 0, SEEK_END);
-            u64 input_size = ftell(f_in);
-            fseek(f_in, 0, SEEK_SET);
-            if (input_size < 12) {
-                fclose(f_in);
+            if (fileIn.getSize() < 12) {
                 return printf_err(FILE_ERROR, ERROR_5);
             }
             HeaderUnion headerUnion{};
-            fread(&headerUnion, 1, 12, f_in);
+            std::memcpy(&headerUnion, fileIn.start(), 12);
 
+            Data data;
+            data.setScopeDealloc(true);
             u32 final_size = headerUnion.getInt2Swap();
             if(!data.allocate(final_size)) {
-                fclose(f_in);
                 return printf_err(MALLOC_FAILED, ERROR_1, final_size);
             }
 
-            input_size -= 8;
-            Data src;
-            src.setScopeDealloc(true);
-            if(!src.allocate(input_size)) {
-                fclose(f_in);
-                return printf_err(MALLOC_FAILED, ERROR_1, input_size);
+            // inflate straight out of the mapped file
+            int status;
+            {
+                const StageTimer timer(STAGE::INFLATE);
+                status = getDeflateBackend().inflateZlib(data.start(), data.size, fileIn.start() + 8, fileIn.getSize() - 8);
             }
-
-            fseek(f_in, 8, SEEK_SET);
-            fread(src.start(), 1, input_size, f_in);
-            fclose(f_in);
-
-            int status = tinf_zlib_uncompress(data.start(), &data.size, src.start(), input_size);
             if (status != 0) {
                 return DECOMPRESS;
             }
@@ -118,7 +103,7 @@ namespace editor {
         }
 
 
-        ND int deflateListing(MU const fs::path& gameDataPath, MU Data& inflatedData, MU Data& deflatedData) const override {
+        ND int deflateListing(MU const fs::path& gameDataPath, MU FileWriteStream& theFileOut, MU int theLevel) const override {
             return NOT_IMPLEMENTED;
         }
 
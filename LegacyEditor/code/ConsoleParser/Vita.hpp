@@ -44,45 +44,29 @@ namespace editor {
 
 
         int inflateListing() override {
-            Data data;
-            data.setScopeDealloc(true);
-
-            FILE *f_in = fopen(myFilePath.string().c_str(), "rb");
-            if (f_in == nullptr) {
+            MappedFile fileIn;
+            if (fileIn.open(myFilePath) != SUCCESS) {
                 return printf_err(FILE_ERROR, ERROR_4, myFilePath.string().c_str());
             }
-
-            fseek(f_in, 0, SEEK_END);
-            u64 input_size = ftell(f_in);
-            fseek(f_in, 0, SEEK_SET);
-            if (input_size < 12) {
-                fclose(f_in);
+            if (fileIn.getSize() < 12) {
                 return printf_err(FILE_ERROR, ERROR_5);
             }
             HeaderUnion headerUnion{};
-            fread(&headerUnion, 1, 12, f_in);
+            std::memcpy(&headerUnion, fileIn.start(), 12);
 
+            Data data;
+            data.setScopeDealloc(true);
             u32 final_size = headerUnion.getDestSize();
             if(!data.allocate(final_size)) {
-                fclose(f_in);
                 return printf_err(MALLOC_FAILED, ERROR_1, final_size);
             }
 
-            input_size -= 8;
-            Data src;
-            src.setScopeDealloc(true);
-            if(!src.allocate(input_size)) {
-                fclose(f_in);
-                return printf_err(MALLOC_FAILED, ERROR_1, input_size);
+            // decode straight out of the mapped file, the data starts at offset 8
+            {
+                const StageTimer timer(STAGE::RLE);
+                RLEVITA_DECOMPRESS(fileIn.start() + 8, fileIn.getSize() - 8, data.data, data.size);
             }
 
-            // goto offset 8 for the data, read data into src
-            fseek(f_in, 8, SEEK_SET);
-            fread(src.data, 1, input_size, f_in);
-            fclose(f_in);
-
-            RLEVITA_DECOMPRESS(src.data, src.size, data.data, data.size);
-
             int status = ConsoleParser::readListing(data);
             if (status != 0) {
                 return -1;
@@ -109,15 +93,12 @@ namespace editor {
 
             // GAMEDATA
             fs::path gameDataPath = rootPath / "GAMEDATA.bin";
-            Data deflatedData = ConsoleParser::writeListing(myConsole);
-            deflatedData.setScopeDealloc(true);
-            Data inflatedData;
-            inflatedData.setScopeDealloc(true);
-            status = deflateListing(gameDataPath, deflatedData, inflatedData);
+            FileWriteStream gameDataOut;
+            status = deflateListing(gameDataPath, gameDataOut, theSettings.getCompressionLevel());
             if (status != 0) return printf_err(status,
                 "failed to compress fileListing\n");
             theSettings.setOutFilePath(gameDataPath);
-            printf("gamedata final size: %u\n", deflatedData.size);
+            printf("gamedata final size: %u\n", gameDataOut.getSize());
 
 
             // FILE INFO
@@ -134,31 +115,26 @@ namespace editor {
         }
 
 
-        ND int deflateListing(const fs::path& gameDataPath, Data& inflatedData, MU Data& deflatedData) const override {
-            deflatedData.allocate(inflatedData.size + 2);
-
-            deflatedData.size = RLEVITA_COMPRESS(
-                    inflatedData.data, inflatedData.size,
-                    deflatedData.data, deflatedData.size);
-            FILE *f_out = fopen(gameDataPath.string().c_str(), "wb");
-            if (f_out == nullptr) return printf_err(FILE_ERROR,
+        /// The listing is RLE compressed as it is written, so it is never held in memory as a whole.
+        ND int deflateListing(const fs::path& gameDataPath, FileWriteStream& theFileOut, MU int theLevel) const override {
+            if (theFileOut.open(gameDataPath) != SUCCESS) return printf_err(FILE_ERROR,
                 "failed to write savefile to \"%s\"\n",
                 gameDataPath.string().c_str());
 
             // 4-bytes of '0'
             // 4-bytes of total decompressed fileListing size
             // N-bytes fileListing data
-            constexpr int num = 0;
-            fwrite(&num, sizeof(u32), 1, f_out);
-            u32 compSize = inflatedData.size;
+            u32 header[2] = {0, ConsoleParser::getListingSize()};
             if (!isSystemLittleEndian()) {
-                compSize = swapEndian32(compSize);
+                header[1] = swapEndian32(header[1]);
             }
-            fwrite(&compSize, sizeof(u32), 1, f_out);
-            fwrite(deflatedData.data, 1, deflatedData.size, f_out);
-            fclose(f_out);
+            int status = theFileOut.write(reinterpret_cast<c_u8*>(header), sizeof(header));
 
-            return SUCCESS;
+            RLEVitaWriteStream rleOut(theFileOut);
+            if (status == SUCCESS) status = ConsoleParser::writeListing(myConsole, rleOut);
+            if (status == SUCCESS) status = rleOut.finish();
+            if (status == SUCCESS) status = theFileOut.finish();
+            return status;
         }
 
 
@@ -4,7 +4,6 @@
 
 #include "include/ghc/fs_std.hpp"
 #include "include/zlib-1.2.12/zlib.h"
-#include "include/tinf/tinf.h"
 
 #include "LegacyEditor/code/FileListing/fileListing.hpp"
 #include "LegacyEditor/utils/utils.hpp"
@@ -44,51 +43,33 @@ namespace editor {
 
 
         int inflateListing() override {
-            Data data;
-            data.setScopeDealloc(true);
-
-            FILE *f_in = fopen(myFilePath.string().c_str(), "rb");
-            if (f_in == nullptr) {
+            MappedFile fileIn;
+            if (fileIn.open(myFilePath) != SUCCESS) {
                 return printf_err(FILE_ERROR, ERROR_4, myFilePath.string().c_str());
             }
-
-            fseek(f_in, 0, SEEK_END);
-            u64 input_size = ftell(f_in);
-            fseek(f_in, 0, SEEK_SET);
-            if (input_size < 12) {
-                fclose(f_in);
+            if (fileIn.getSize() < 12) {
                 return printf_err(FILE_ERROR, ERROR_5);
             }
             HeaderUnion headerUnion{};
-            fread(&headerUnion, 1, 12, f_in);
+            std::memcpy(&headerUnion, fileIn.start(), 12);
 
+            Data data;
+            data.setScopeDealloc(true);
             u32 final_size = headerUnion.getDestSize();
             if(!data.allocate(final_size)) {
-                fclose(f_in);
                 return printf_err(MALLOC_FAILED, ERROR_1, final_size);
             }
 
-            input_size -= 8;
-            Data src;
-            src.setScopeDealloc(true);
-            if(!src.allocate(input_size * 2)) { // why is the x2 here?
-                fclose(f_in);
-                return printf_err(MALLOC_FAILED, ERROR_1, input_size * 2); // why is the x2 here?
+            // inflate straight out of the mapped file
+            int status;
+            {
+                const StageTimer timer(STAGE::INFLATE);
+                status = getDeflateBackend().inflateZlib(data.start(), data.size, fileIn.start() + 8, fileIn.getSize() - 8);
             }
-
-            fseek(f_in, 8, SEEK_SET);
-            fread(src.start(), 1, input_size, f_in);
-            fclose(f_in);
-
-            int status = tinf_zlib_uncompress(data.start(), &data.size, src.start(), input_size);
             if (status != 0) {
                 return DECOMPRESS;
             }
 
-
-            // std::string loc = R"(C:\Users\jerrin\Desktop\New folder\OUT\WiiU)";
-            // DataManager(data).writeToFile(loc);
-
             status = ConsoleParser::readListing(data);
             if (status != 0) {
                 return -1;
@@ -107,15 +88,12 @@ namespace editor {
 
             // GAMEDATA
             fs::path gameDataPath = rootPath / getCurrentDateTimeString();
-            Data inflatedData = ConsoleParser::writeListing(myConsole);
-            inflatedData.setScopeDealloc(true);
-            Data deflatedData;
-            deflatedData.setScopeDealloc(true);
-            status = deflateListing(gameDataPath, inflatedData, deflatedData);
+            FileWriteStream gameDataOut;
+            status = deflateListing(gameDataPath, gameDataOut, theSettings.getCompressionLevel());
             if (status != 0)
                 return printf_err(status, "failed to compress fileListing\n");
             theSettings.setOutFilePath(gameDataPath);
-            printf("gamedata final size: %u\n", deflatedData.size);
+            printf("gamedata final size: %u\n", gameDataOut.getSize());
 
 
             // FILE INFO
@@ -134,27 +112,24 @@ namespace editor {
         }
 
 
-        ND int deflateListing(const fs::path& gameDataPath, Data& inflatedData, MU Data& deflatedData) const override {
-            deflatedData.allocate(compressBound(inflatedData.size));
-
-            if (compress(deflatedData.data, reinterpret_cast<uLongf*>(&deflatedData.size),
-                         inflatedData.data, inflatedData.size) != Z_OK) {
-                return COMPRESS;
-            }
-
-            // file operations
-            FILE *f_out = fopen(gameDataPath.string().c_str(), "wb");
-            if (f_out == nullptr) return printf_err(FILE_ERROR,
+        /// The listing is deflated as it is written, so it is never held in memory as a whole.
+        ND int deflateListing(const fs::path& gameDataPath, FileWriteStream& theFileOut, c_int theLevel) const override {
+            if (theFileOut.open(gameDataPath) != SUCCESS) return printf_err(FILE_ERROR,
                 "failed to write savefile to \"%s\"\n",
                 gameDataPath.string().c_str());
-            uint64_t sizeToWrite = inflatedData.size;
+
+            // 8-bytes of total decompressed fileListing size
+            // N-bytes zlib compressed fileListing data
+            uint64_t sizeToWrite = ConsoleParser::getListingSize();
             if (isSystemLittleEndian())
                 sizeToWrite = swapEndian64(sizeToWrite);
-            fwrite(&sizeToWrite, 8, 1, f_out);
-            fwrite(deflatedData.data, 1, deflatedData.size, f_out);
-            fclose(f_out);
+            int status = theFileOut.write(reinterpret_cast<c_u8*>(&sizeToWrite), 8);
 
-            return SUCCESS;
+            ZlibWriteStream zlibOut(theFileOut, theLevel);
+            if (status == SUCCESS) status = ConsoleParser::writeListing(myConsole, zlibOut);
+            if (status == SUCCESS) status = zlibOut.finish();
+            if (status == SUCCESS) status = theFileOut.finish();
+            return status;
         }
 
 
@@ -51,7 +51,7 @@ namespace editor {
         }
 
 
-        ND int deflateListing(MU const fs::path& gameDataPath, MU Data& inflatedData, MU Data& deflatedData) const override {
+        ND int deflateListing(MU const fs::path& gameDataPath, MU FileWriteStream& theFileOut, MU int theLevel) const override {
             return NOT_IMPLEMENTED;
         }
 
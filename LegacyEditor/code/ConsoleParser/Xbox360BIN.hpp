@@ -94,9 +94,14 @@ namespace editor {
                 return MALLOC_FAILED;
             }
 
-            data.size = XDecompress(
-                    data.start(), &data.size,
-                    deflatedData.ptr, srcSize);
+            int error;
+            {
+                const StageTimer timer(STAGE::INFLATE);
+                error = XDecompress(data.start(), &data.size, deflatedData.ptr, srcSize);
+            }
+            if (error != 0) {
+                return printf_err(DECOMPRESS, "%s", ERROR_3);
+            }
 
             int status = ConsoleParser::readListing(data);
             if (status != 0) {
@@ -121,7 +126,7 @@ namespace editor {
         }
 
 
-        ND int deflateListing(MU const fs::path& gameDataPath, MU Data& inflatedData, MU Data& deflatedData) const override {
+        ND int deflateListing(MU const fs::path& gameDataPath, MU FileWriteStream& theFileOut, MU int theLevel) const override {
             return NOT_IMPLEMENTED;
         }
 
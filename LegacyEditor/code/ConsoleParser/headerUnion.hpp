@@ -2,6 +2,7 @@
 
 #include "lce/processor.hpp"
 
+#include "LegacyEditor/utils/byteSwap.hpp"
 #include "LegacyEditor/utils/utils.hpp"
 
 
@@ -11,10 +12,8 @@ namespace editor {
      * uses many struct unions to interpret the header for the save file of different consoles.
      */
     class HeaderUnion {
-
-        static bool isSystemLittle() {
-            return isSystemLittleEndian();
-        }
+        static constexpr auto BIG = std::endian::big;
+        static constexpr auto LITTLE = std::endian::little;
 
         union {
             /// header size: 12 bytes
@@ -37,19 +36,19 @@ namespace editor {
         } UNION;
     public:
         /// bytes 0-3
-        ND u32 getInt1() const { return isSystemLittle() ? swapEndian32(UNION.INT_VIEW.int1) : UNION.INT_VIEW.int1; }
+        ND u32 getInt1() const { return byteswap::convert<BIG>(UNION.INT_VIEW.int1); }
         /// bytes 4-7
-        ND u32 getInt2() const { return isSystemLittle() ? swapEndian32(UNION.INT_VIEW.int2) : UNION.INT_VIEW.int2; }
+        ND u32 getInt2() const { return byteswap::convert<BIG>(UNION.INT_VIEW.int2); }
         /// bytes 8-11
-        ND u32 getInt3() const { return isSystemLittle() ? swapEndian32(UNION.INT_VIEW.int3) : UNION.INT_VIEW.int3; }
+        ND u32 getInt3() const { return byteswap::convert<BIG>(UNION.INT_VIEW.int3); }
         /// bytes 8-9
-        ND u32 getShort5() const { return isSystemLittle() ? swapEndian16(UNION.ZLIB.zlib_magic) : UNION.ZLIB.zlib_magic; }
+        ND u32 getShort5() const { return byteswap::convert<BIG>(UNION.ZLIB.zlib_magic); }
         /// bytes 0-7
-        ND u64 getDestSize() const { return isSystemLittle() ? swapEndian64(UNION.ZLIB.dest_size) : UNION.ZLIB.dest_size; }
+        ND u64 getDestSize() const { return byteswap::convert<BIG>(UNION.ZLIB.dest_size); }
         /// bytes 4-7
-        ND u32 getInt2Swap() const { return isSystemLittle() ? UNION.INT_VIEW.int2 : swapEndian32(UNION.INT_VIEW.int2); }
+        ND u32 getInt2Swap() const { return byteswap::convert<LITTLE>(UNION.INT_VIEW.int2); }
         /// bytes 8-11
-        ND u32 getInt3Swap() const { return isSystemLittle() ? UNION.INT_VIEW.int3 : swapEndian32(UNION.INT_VIEW.int3); }
+        ND u32 getInt3Swap() const { return byteswap::convert<LITTLE>(UNION.INT_VIEW.int3); }
     };
 
 }
@@ -104,7 +104,8 @@ namespace editor {
         }
         removeFileTypes({lce::FILETYPE::GRF});
 
-        convertRegions(theWriteSettings.getConsole());
+        convertRegions(theWriteSettings.getConsole(), theWriteSettings.getThreadCount(),
+                       theWriteSettings.getCompressionLevel());
 
         int status = writeSave(theWriteSettings);
         if (status != 0) {
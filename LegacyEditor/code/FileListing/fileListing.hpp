@@ -19,6 +19,7 @@
 #include "LegacyEditor/code/LCEFile/LCEFile.hpp"
 #include "LegacyEditor/code/Region/RegionManager.hpp"
 #include "LegacyEditor/utils/error_status.hpp"
+#include "LegacyEditor/utils/mappedFile.hpp"
 
 
 class ConsoleParser;
@@ -30,8 +31,7 @@ namespace editor {
     public:
         void removeAll() {
             for (LCEFile* file : *this) {
-                delete[] file->data.data;
-                file->data.data = nullptr;
+                file->data.deallocate();
             }
             clear();
         }
@@ -45,6 +45,10 @@ namespace editor {
         StateSettings myReadSettings;
         // this can probably be renamed to "myInternalFiles"
         std::list<LCEFile> myAllFiles;
+        /// the inflated listing, and the save file if it was mapped in. Sub-files point
+        /// into one of these instead of owning a copy, so they live as long as the listing.
+        Data mySourceData;
+        MappedFile mySourceFile;
 
         // these can probably be stored in a std::list called external files
         FileInfo fileInfo{};
@@ -84,7 +88,8 @@ namespace editor {
 
         /// Region Helpers
 
-        MU void convertRegions(lce::CONSOLE consoleOut);
+        MU void convertRegions(lce::CONSOLE consoleOut, u32 threadCount = 1,
+                               int level = DEFAULT_COMPRESSION_LEVEL);
         MU void pruneRegions();
         MU void replaceRegionOW(size_t regionIndex, editor::RegionManager& region, lce::CONSOLE consoleOut);
 
@@ -1,12 +1,13 @@
 #include "fileListing.hpp"
 
-#include <iostream>
 #include <algorithm>
+#include <iostream>
 
 #include "include/ghc/fs_std.hpp"
 
 
 #include "LegacyEditor/code/Region/RegionManager.hpp"
+#include "LegacyEditor/code/threaded.hpp"
 #include "LegacyEditor/utils/NBT.hpp"
 
 
@@ -80,6 +81,8 @@ namespace editor {
 
         for (auto it = myAllFiles.begin(); it != myAllFiles.end(); ) {
             if (it->fileType == fileType) {
+                // the files may outlive this listing's source buffer
+                it->data.makeOwned();
                 collectedFiles.splice(collectedFiles.end(), myAllFiles, it++);
             } else {
                 ++it;
@@ -97,6 +100,8 @@ namespace editor {
         }
         clearPointers();
         myAllFiles.clear();
+        mySourceData.deallocate();
+        mySourceFile.close();
         myReadSettings.reset();
     }
 
@@ -155,30 +160,33 @@ namespace editor {
     }
 
 
-    MU void FileListing::convertRegions(const lce::CONSOLE consoleOut) {
-        // int index = 0;
-        // int index2 = 0;
+    /**
+     * Converts every region file to "consoleOut". Region files and the chunks
+     * inside them do not share any state, so both are handed out as tasks to a
+     * pool of "threadCount" threads, and each result is stolen back into its own
+     * file. The output is the same no matter how many threads are used.
+     * @param consoleOut the console to convert the regions to
+     * @param threadCount how many threads to use, "1" converts serially
+     * @param level the deflate level of chunks that are re-compressed, see WriteSettings::setCompressionLevel
+     */
+    MU void FileListing::convertRegions(const lce::CONSOLE consoleOut, c_u32 threadCount, c_int level) {
+        std::vector<LCEFile*> regionFiles;
         for (const FileList* fileList : ptrs.dimFileLists) {
-            // printf("list %d\n", index);
-            // index++;
-            // index2 = 0;
-            for (LCEFile* file : *fileList) {
-                // printf("    file %d\n", index2);
-                // index2++;
-
-
-
-                // don't convert it if it's already the correct console version
-                // if (file->console == consoleOut) {
-                //     continue;
-                // }
-                RegionManager region;
-                region.read(file);
-                region.convertChunks(consoleOut);
-                Data data = region.write(consoleOut);
-                file->data.steal(data);
-            }
+            regionFiles.insert(regionFiles.end(), fileList->begin(), fileList->end());
         }
+
+        ThreadPool pool(threadCount);
+        pool.parallelFor(regionFiles.size(), [&regionFiles, &pool, consoleOut, level](const size_t index) {
+            LCEFile* file = regionFiles[index];
+            // chunks are only re-compressed if the codec changes,
+            // otherwise they are copied into the new region as they are
+            RegionManager region;
+            region.read(file);
+            region.convertChunks(consoleOut, &pool, level);
+            Data data = region.write(consoleOut, level);
+            file->data.steal(data);
+            file->console = consoleOut;
+        });
     }
 
 
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <algorithm>
+#include <thread>
 #include <utility>
 
 #include "include/ghc/fs_std.hpp"
@@ -7,6 +9,8 @@
 #include "lce/enums.hpp"
 #include "lce/processor.hpp"
 
+#include "LegacyEditor/utils/deflateBackend.hpp"
+
 #include "productcodes.hpp"
 
 
@@ -25,6 +29,8 @@ namespace editor {
         lce::CONSOLE myConsole;
         fs::path myInFolderPath;
         fs::path myOutFilePath;
+        u32 myThreadCount = std::max(1U, std::thread::hardware_concurrency());
+        int myCompressionLevel = DEFAULT_COMPRESSION_LEVEL;
 
 
     public:
@@ -67,6 +73,20 @@ namespace editor {
 
         MU void setOutFilePath(const fs::path& theOutFilePath) { myOutFilePath = theOutFilePath; }
 
+        /// how many worker threads are used to convert region files, "1" converts them serially
+        MU ND u32 getThreadCount() const { return myThreadCount; }
+
+        MU void setThreadCount(c_u32 theThreadCount) { myThreadCount = std::max(1U, theThreadCount); }
+
+        /// the deflate level of chunks and listings that are re-compressed, "0" is fastest and "9" is smallest
+        MU ND int getCompressionLevel() const { return myCompressionLevel; }
+
+        /// anything outside of 0-9 picks the default level
+        MU void setCompressionLevel(c_int theLevel) {
+            myCompressionLevel = theLevel >= MIN_COMPRESSION_LEVEL && theLevel <= MAX_COMPRESSION_LEVEL
+                                 ? theLevel : DEFAULT_COMPRESSION_LEVEL;
+        }
+
         MU ND bool areSettingsValid() const {
             if (myConsole == lce::CONSOLE::PS3 && !myProductCodes.isVarSetPS3()) return false;
             if (myConsole == lce::CONSOLE::PS4 && !myProductCodes.isVarSetPS4()) return false;
@@ -42,9 +42,7 @@ namespace editor {
 
     // TODO: why doesn't this delete NBT?
     void LCEFile::deleteData() {
-        delete[] data.data;
-        data.data = nullptr;
-        data.size = 0;
+        data.deallocate();
     }
 
 
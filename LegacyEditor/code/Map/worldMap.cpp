@@ -0,0 +1,558 @@
+#include "worldMap.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "lce/include/picture.hpp"
+
+#include "LegacyEditor/code/FileListing/fileListing.hpp"
+#include "LegacyEditor/code/LCEFile/LCEFile.hpp"
+#include "LegacyEditor/code/Map/mapcolors.hpp"
+#include "LegacyEditor/code/Region/RegionManager.hpp"
+#include "LegacyEditor/code/threaded.hpp"
+#include "LegacyEditor/utils/error_status.hpp"
+
+
+namespace editor::map {
+
+    static constexpr u32 CHANNELS = 4;
+    static constexpr u32 REGION_CHUNKS = 1024;
+    static constexpr u32 CHUNKS_PER_TASK = 16;
+    static constexpr u32 MAX_WATER_DEPTH = 15;
+    static constexpr int NETHER_ROOF = 127;
+
+    /// in the order of FileListing::ptrs.dimFileLists
+    static constexpr const char* DIMENSION_NAMES[3] = {"nether", "overworld", "end"};
+    static constexpr const char* REGION_LIST_NAME = "regions.txt";
+
+    using TileCoord = std::pair<int, int>;
+    /// the signature of every region, see getRegionSignature
+    using RegionList = std::map<TileCoord, u64>;
+
+
+    // #####################################################
+    // #               Block Colors
+    // #####################################################
+
+
+    /// The base colors of mapcolors.hpp, each of which comes in 4 shades.
+    enum BASE_COLOR : u8 {
+        NONE, GRASS, SAND, WOOL, FIRE, ICE, IRON, FOLIAGE, SNOW, CLAY, DIRT, STONE, WATER, WOOD, QUARTZ,
+        ORANGE, MAGENTA, LIGHT_BLUE, YELLOW, LIME, PINK, GRAY, SILVER, CYAN, PURPLE, BLUE, BROWN, GREEN,
+        RED, BLACK, GOLD, DIAMOND, LAPIS, EMERALD, PODZOL, NETHERRACK,
+        TERRACOTTA // 16 of them, in the order of the dye colors
+    };
+
+    static constexpr u8 DYE_COLORS[16] = {
+            SNOW, ORANGE, MAGENTA, LIGHT_BLUE, YELLOW, LIME, PINK, GRAY,
+            SILVER, CYAN, PURPLE, BLUE, BROWN, GREEN, RED, BLACK};
+    static constexpr u8 STONE_COLORS[8] = {STONE, DIRT, DIRT, QUARTZ, QUARTZ, STONE, STONE, STONE};
+    static constexpr u8 WOOD_COLORS[8] = {WOOD, PODZOL, SAND, DIRT, ORANGE, BROWN, WOOD, WOOD};
+
+    /// The base color of every block id up to "Aquatic", the same as Java 1.12; NONE is see-through.
+    static constexpr u8 BLOCK_COLORS[256] = {
+            // 0 - 15
+            NONE, STONE, GRASS, DIRT, STONE, WOOD, FOLIAGE, STONE,
+            WATER, WATER, FIRE, FIRE, SAND, STONE, STONE, STONE,
+            // 16 - 31
+            STONE, WOOD, FOLIAGE, YELLOW, NONE, STONE, LAPIS, STONE,
+            SAND, WOOD, WOOL, NONE, NONE, STONE, WOOL, FOLIAGE,
+            // 32 - 47
+            FOLIAGE, STONE, STONE, WOOL, NONE, FOLIAGE, FOLIAGE, FOLIAGE,
+            FOLIAGE, GOLD, IRON, STONE, STONE, RED, FIRE, WOOD,
+            // 48 - 63
+            STONE, BLACK, NONE, FIRE, STONE, WOOD, WOOD, NONE,
+            STONE, DIAMOND, WOOD, FOLIAGE, DIRT, STONE, STONE, WOOD,
+            // 64 - 79
+            WOOD, NONE, NONE, STONE, WOOD, NONE, STONE, IRON,
+            WOOD, STONE, STONE, NONE, NONE, NONE, SNOW, ICE,
+            // 80 - 95
+            SNOW, FOLIAGE, CLAY, FOLIAGE, WOOD, WOOD, ORANGE, NETHERRACK,
+            BROWN, SAND, NONE, ORANGE, NONE, NONE, NONE, WOOL,
+            // 96 - 111
+            WOOD, CLAY, STONE, DIRT, RED, IRON, NONE, LIME,
+            FOLIAGE, FOLIAGE, FOLIAGE, WOOD, RED, STONE, PURPLE, FOLIAGE,
+            // 112 - 127
+            NETHERRACK, NETHERRACK, NETHERRACK, RED, RED, IRON, STONE, BLACK,
+            GREEN, SAND, BLACK, NONE, NONE, WOOD, WOOD, FOLIAGE,
+            // 128 - 143
+            SAND, STONE, STONE, NONE, NONE, EMERALD, PODZOL, SAND,
+            DIRT, BROWN, DIAMOND, STONE, NONE, FOLIAGE, FOLIAGE, NONE,
+            // 144 - 159
+            NONE, IRON, WOOD, GOLD, IRON, NONE, NONE, WOOD,
+            FIRE, NETHERRACK, STONE, QUARTZ, QUARTZ, NONE, STONE, TERRACOTTA,
+            // 160 - 175
+            NONE, FOLIAGE, WOOD, ORANGE, BROWN, GRASS, NONE, IRON,
+            CYAN, QUARTZ, YELLOW, WOOL, ORANGE, BLACK, ICE, FOLIAGE,
+            // 176 - 191
+            WOOD, WOOD, WOOD, ORANGE, ORANGE, ORANGE, ORANGE, WOOD,
+            WOOD, WOOD, WOOD, WOOD, WOOD, WOOD, WOOD, WOOD,
+            // 192 - 207
+            WOOD, WOOD, WOOD, WOOD, WOOD, WOOD, NONE, PURPLE,
+            PURPLE, MAGENTA, MAGENTA, MAGENTA, MAGENTA, MAGENTA, SAND, FOLIAGE,
+            // 208 - 223
+            DIRT, BLACK, PURPLE, GREEN, ICE, NETHERRACK, RED, NETHERRACK,
+            SAND, NONE, STONE, SNOW, ORANGE, MAGENTA, LIGHT_BLUE, YELLOW,
+            // 224 - 239 (shulker boxes, then glazed terracotta)
+            LIME, PINK, GRAY, SILVER, CYAN, PURPLE, BLUE, BROWN,
+            GREEN, RED, BLACK, SNOW, ORANGE, MAGENTA, LIGHT_BLUE, YELLOW,
+            // 240 - 255
+            LIME, PINK, GRAY, SILVER, CYAN, PURPLE, BLUE, BROWN,
+            GREEN, RED, BLACK, WOOL, WOOL, NONE, NONE, SILVER,
+    };
+
+
+    /// @param theBlock (blockID << 4 | dataTag)
+    static u8 getBlockColor(c_u16 theBlock) {
+        c_u32 blockID = theBlock >> 4 & 0x7FF;
+        c_u32 dataTag = theBlock & 0x0F;
+        // the blocks added by "Aquatic" are not mapped, the block below them is shown instead
+        if (blockID >= 256) {
+            return NONE;
+        }
+        switch (blockID) {
+            case 1:
+                return STONE_COLORS[dataTag & 7];
+            case 3:
+                return dataTag == 2 ? PODZOL : DIRT;
+            case 5:
+            case 125:
+            case 126:
+                return WOOD_COLORS[dataTag & 7];
+            case 12:
+                return dataTag == 1 ? ORANGE : SAND;
+            case 35:
+            case 95:
+            case 171:
+            case 251:
+            case 252:
+                return DYE_COLORS[dataTag];
+            case 159:
+                return TERRACOTTA + dataTag;
+            default:
+                return BLOCK_COLORS[blockID];
+        }
+    }
+
+
+    // #####################################################
+    // #               Regions
+    // #####################################################
+
+
+    /// The block an in-game map would show for a column.
+    struct Column {
+        u8 color = NONE;
+        u8 height = 0;
+        /// how many water blocks are at the top, up to MAX_WATER_DEPTH
+        u8 depth = 0;
+    };
+
+
+    /**
+     * Scans down for the first colored block, from the top of the height map. The height map
+     * only counts blocks that stop light, so the block above it (snow, plants) is checked first.
+     * In the nether the scan starts below the bedrock roof.
+     */
+    static Column findColumn(chunk::ChunkData& theChunk, c_int xIn, c_int zIn, c_bool isNether) {
+        int yIter = 255;
+        if (isNether) {
+            int below = NETHER_ROOF;
+            while (below >= 0 && getBlockColor(theChunk.getBlock(xIn, below, zIn)) != NONE) {
+                below--;
+            }
+            yIter = below >= 0 ? below : NETHER_ROOF;
+        } else if (theChunk.heightMap.size() == 256) {
+            yIter = std::min<int>(theChunk.heightMap[zIn * 16 + xIn], 255);
+        }
+
+        Column column;
+        while (yIter >= 0 && (column.color = getBlockColor(theChunk.getBlock(xIn, yIter, zIn))) == NONE) {
+            yIter--;
+        }
+        if (yIter < 0) {
+            return {};
+        }
+        column.height = static_cast<u8>(yIter);
+
+        if (column.color == WATER) {
+            while (column.depth < MAX_WATER_DEPTH && yIter - column.depth >= 0
+                   && getBlockColor(theChunk.getBlock(xIn, yIter - column.depth, zIn)) == WATER) {
+                column.depth++;
+            }
+        }
+        return column;
+    }
+
+
+    /**
+     * Shades every column the same as an in-game map: by its height against the column north
+     * of it, or by its depth for water, with a checkerboard dither between the shades.
+     * Columns without a block are left clear.
+     */
+    static void shadeTile(const std::vector<Column>& theColumns, c_u32 theTileWidth, const Picture& thePicture) {
+        for (u32 zIter = 0; zIter < theTileWidth; zIter++) {
+            for (u32 xIter = 0; xIter < theTileWidth; xIter++) {
+                c_u32 index = zIter * theTileWidth + xIter;
+                const Column& column = theColumns[index];
+                u8* pixel = thePicture.myData + index * CHANNELS;
+                if (column.color == NONE) {
+                    std::memset(pixel, 0, CHANNELS);
+                    continue;
+                }
+
+                // both in tenths of a shade
+                c_int dither = static_cast<int>((xIter + zIter) & 1);
+                int shade;
+                if (column.color == WATER) {
+                    c_int depth = column.depth + dither * 2;
+                    shade = depth < 5 ? 2 : depth > 9 ? 0 : 1;
+                } else {
+                    const Column& north = zIter > 0 && theColumns[index - theTileWidth].color != NONE
+                                                  ? theColumns[index - theTileWidth] : column;
+                    c_int slope = (column.height - north.height) * 8 + (dither ? 2 : -2);
+                    shade = slope > 6 ? 2 : slope < -6 ? 0 : 1;
+                }
+
+                const RGB rgb = getRGB(column.color * 4 + shade);
+                pixel[0] = rgb.r;
+                pixel[1] = rgb.g;
+                pixel[2] = rgb.b;
+                pixel[3] = 255;
+            }
+        }
+    }
+
+
+    /**
+     * Renders the chunks of "theRegion" into a tile, a pixel per block. Chunks are spread across
+     * the pool; only their blocks and height map are decoded, and each is freed once drawn.
+     */
+    static void renderRegion(RegionManager& theRegion, c_u32 theTileWidth, c_bool isNether,
+                             ThreadPool& thePool, const Picture& thePicture) {
+        c_u32 slotCount = theTileWidth / 16;
+        std::vector<Column> columns(theTileWidth * theTileWidth);
+
+        thePool.parallelFor(REGION_CHUNKS, [&](const size_t index) {
+            ChunkManager& chunk = theRegion.chunks[index];
+            c_u32 slotX = index & 31;
+            c_u32 slotZ = index >> 5;
+            if (chunk.size == 0 || slotX >= slotCount || slotZ >= slotCount) {
+                return;
+            }
+
+            chunk.readChunk(theRegion.myConsole, chunk::READ_BLOCKS | chunk::READ_HEIGHTMAP);
+            if (chunk.chunkData->validChunk) {
+                for (int zIter = 0; zIter < 16; zIter++) {
+                    Column* row = &columns[(slotZ * 16 + zIter) * theTileWidth + slotX * 16];
+                    for (int xIter = 0; xIter < 16; xIter++) {
+                        row[xIter] = findColumn(*chunk.chunkData, xIter, zIter, isNether);
+                    }
+                }
+            }
+
+            chunk.deallocate();
+            delete chunk.chunkData;
+            chunk.chunkData = new chunk::ChunkData();
+        }, CHUNKS_PER_TASK);
+
+        shadeTile(columns, theTileWidth, thePicture);
+    }
+
+
+    /// Changes whenever a chunk of the region is added, removed or saved again.
+    static u64 getRegionSignature(const RegionManager& theRegion) {
+        u64 hash = 0xCBF29CE484222325ULL;
+        auto mix = [&hash](c_u64 value) { hash = (hash ^ value) * 0x100000001B3ULL; };
+        for (u32 index = 0; index < REGION_CHUNKS; index++) {
+            const ChunkManager& chunk = theRegion.chunks[index];
+            if (chunk.size == 0) {
+                continue;
+            }
+            mix(index);
+            mix(chunk.fileData.getTimestamp());
+            mix(chunk.size);
+        }
+        return hash;
+    }
+
+
+    /// The signatures of the last render, only kept if its tiles were as wide.
+    static RegionList readRegionList(const fs::path& thePath, c_u32 theTileWidth) {
+        RegionList regions;
+        FILE* file = fopen(thePath.string().c_str(), "r");
+        if (file == nullptr) {
+            return regions;
+        }
+
+        u32 tileWidth = 0;
+        if (fscanf(file, "tile %u", &tileWidth) == 1 && tileWidth == theTileWidth) {
+            int regionX, regionZ;
+            unsigned long long signature;
+            while (fscanf(file, "%d %d %llx", &regionX, &regionZ, &signature) == 3) {
+                regions[{regionX, regionZ}] = signature;
+            }
+        }
+        fclose(file);
+        return regions;
+    }
+
+
+    static int writeRegionList(const fs::path& thePath, const RegionList& theRegions, c_u32 theTileWidth) {
+        FILE* file = fopen(thePath.string().c_str(), "w");
+        if (file == nullptr) {
+            return printf_err(FILE_ERROR, "failed to write '%s'\n", thePath.string().c_str());
+        }
+
+        fprintf(file, "tile %u\n", theTileWidth);
+        for (const auto& [tile, signature] : theRegions) {
+            fprintf(file, "%d %d %016llx\n", tile.first, tile.second, static_cast<unsigned long long>(signature));
+        }
+        fclose(file);
+        return SUCCESS;
+    }
+
+
+    // #####################################################
+    // #               Zoom Levels
+    // #####################################################
+
+
+    static fs::path getTilePath(const fs::path& theDimDir, c_u32 theZoom, const TileCoord& theTile) {
+        return theDimDir / std::to_string(theZoom)
+               / (std::to_string(theTile.first) + "_" + std::to_string(theTile.second) + ".png");
+    }
+
+
+    /// How many tiles wide and deep "theTiles" span, less one.
+    static TileCoord getExtent(const std::set<TileCoord>& theTiles) {
+        int minX = theTiles.begin()->first, maxX = minX;
+        int minZ = theTiles.begin()->second, maxZ = minZ;
+        for (const auto& [tileX, tileZ] : theTiles) {
+            minX = std::min(minX, tileX);
+            maxX = std::max(maxX, tileX);
+            minZ = std::min(minZ, tileZ);
+            maxZ = std::max(maxZ, tileZ);
+        }
+        return {maxX - minX, maxZ - minZ};
+    }
+
+
+    /**
+     * Joins the tiles of zoom "theZoom - 1" below "theTile" at half their scale. A pixel is
+     * the average of the drawn pixels it covers, and stays clear if none of them are drawn.
+     * @return false if none of those tiles exist
+     */
+    static bool renderParent(const fs::path& theDimDir, c_u32 theZoom, const TileCoord& theTile,
+                             c_u32 theTileWidth, const Picture& thePicture) {
+        c_u32 half = theTileWidth / 2;
+        std::memset(thePicture.myData, 0, theTileWidth * theTileWidth * CHANNELS);
+
+        bool hasChild = false;
+        for (u32 child = 0; child < 4; child++) {
+            c_u32 offsetX = child & 1;
+            c_u32 offsetZ = child >> 1;
+            const TileCoord childTile = {theTile.first * 2 + static_cast<int>(offsetX),
+                                         theTile.second * 2 + static_cast<int>(offsetZ)};
+            const fs::path childPath = getTilePath(theDimDir, theZoom - 1, childTile);
+            if (!fs::exists(childPath)) {
+                continue;
+            }
+
+            Picture childPicture;
+            if (!childPicture.loadFromFile(childPath.string().c_str())
+                || static_cast<u32>(childPicture.myWidth) != theTileWidth
+                || static_cast<u32>(childPicture.myHeight) != theTileWidth
+                || static_cast<u32>(childPicture.myChannels) != CHANNELS) {
+                continue;
+            }
+            hasChild = true;
+
+            for (u32 zIter = 0; zIter < half; zIter++) {
+                u8* out = thePicture.myData + ((offsetZ * half + zIter) * theTileWidth + offsetX * half) * CHANNELS;
+                for (u32 xIter = 0; xIter < half; xIter++, out += CHANNELS) {
+                    u32 sum[3] = {};
+                    u32 count = 0;
+                    for (u32 pixel = 0; pixel < 4; pixel++) {
+                        c_u32 inX = xIter * 2 + (pixel & 1);
+                        c_u32 inZ = zIter * 2 + (pixel >> 1);
+                        c_u8* in = childPicture.myData + (inZ * theTileWidth + inX) * CHANNELS;
+                        if (in[3] == 0) {
+                            continue;
+                        }
+                        sum[0] += in[0];
+                        sum[1] += in[1];
+                        sum[2] += in[2];
+                        count++;
+                    }
+                    if (count != 0) {
+                        out[0] = static_cast<u8>(sum[0] / count);
+                        out[1] = static_cast<u8>(sum[1] / count);
+                        out[2] = static_cast<u8>(sum[2] / count);
+                        out[3] = 255;
+                    }
+                }
+            }
+        }
+        return hasChild;
+    }
+
+
+    /**
+     * Renders the regions that changed into zoom 0, then the tiles above them, zoom by zoom.
+     * Tiles of regions that are gone are removed; tiles that are missing are rendered again.
+     */
+    static int renderDimension(const FileList& theFiles, const fs::path& theDimDir, c_bool isNether,
+                               ThreadPool& thePool, WorldMapStats& theStats) {
+        if (theFiles.empty()) {
+            return SUCCESS;
+        }
+
+        // a region holds 32x32 chunks, or only 16x16 in newer saves
+        c_u32 tileWidth = 16U << RegionManager::findRegionShift(theFiles);
+
+        std::error_code error;
+        fs::create_directories(theDimDir / "0", error);
+        if (error) {
+            return printf_err(FILE_ERROR, "failed to create folder '%s'\n", theDimDir.string().c_str());
+        }
+
+        const fs::path listPath = theDimDir / REGION_LIST_NAME;
+        const RegionList lastRegions = readRegionList(listPath, tileWidth);
+
+        enum REGION_STATE : u8 { UNREADABLE, SKIPPED, RENDERED };
+        std::vector<TileCoord> regionTiles(theFiles.size());
+        std::vector<u64> signatures(theFiles.size());
+        std::vector<u8> states(theFiles.size(), UNREADABLE);
+
+        thePool.parallelFor(theFiles.size(), [&](const size_t index) {
+            const LCEFile* file = theFiles[index];
+            const TileCoord tile = {file->getRegionX(), file->getRegionZ()};
+            regionTiles[index] = tile;
+
+            RegionManager region;
+            if (region.read(file) != SUCCESS) {
+                return;
+            }
+            signatures[index] = getRegionSignature(region);
+
+            const fs::path tilePath = getTilePath(theDimDir, 0, tile);
+            c_auto last = lastRegions.find(tile);
+            if (last != lastRegions.end() && last->second == signatures[index] && fs::exists(tilePath)) {
+                states[index] = SKIPPED;
+                return;
+            }
+
+            const Picture picture(tileWidth, tileWidth, CHANNELS);
+            renderRegion(region, tileWidth, isNether, thePool, picture);
+            picture.saveWithName(tilePath.string());
+            states[index] = RENDERED;
+        });
+
+        RegionList regions;
+        std::set<TileCoord> changedTiles;
+        for (size_t index = 0; index < theFiles.size(); index++) {
+            if (states[index] == UNREADABLE) {
+                continue;
+            }
+            regions[regionTiles[index]] = signatures[index];
+            if (states[index] == RENDERED) {
+                changedTiles.insert(regionTiles[index]);
+                theStats.renderedRegions++;
+                theStats.writtenTiles++;
+            } else {
+                theStats.skippedRegions++;
+            }
+        }
+        for (const auto& [tile, signature] : lastRegions) {
+            if (!regions.contains(tile)) {
+                fs::remove(getTilePath(theDimDir, 0, tile), error);
+                changedTiles.insert(tile);
+            }
+        }
+
+        std::set<TileCoord> levelTiles;
+        for (const auto& [tile, signature] : regions) {
+            levelTiles.insert(tile);
+        }
+
+        u32 zoom = 0;
+        while (levelTiles.size() > 1) {
+            std::set<TileCoord> parentTiles;
+            for (const auto& [tileX, tileZ] : levelTiles) {
+                parentTiles.insert({tileX >> 1, tileZ >> 1});
+            }
+            // two tiles either side of 0 never join, that is as far out as it goes
+            if (getExtent(parentTiles) == getExtent(levelTiles)) {
+                break;
+            }
+            zoom++;
+
+            fs::create_directories(theDimDir / std::to_string(zoom), error);
+            if (error) {
+                return printf_err(FILE_ERROR, "failed to create folder '%s'\n", theDimDir.string().c_str());
+            }
+
+            std::set<TileCoord> changedParents;
+            for (const auto& [tileX, tileZ] : changedTiles) {
+                changedParents.insert({tileX >> 1, tileZ >> 1});
+            }
+            for (const TileCoord& tile : parentTiles) {
+                if (!fs::exists(getTilePath(theDimDir, zoom, tile))) {
+                    changedParents.insert(tile);
+                }
+            }
+
+            const std::vector<TileCoord> work(changedParents.begin(), changedParents.end());
+            std::atomic<u32> writtenTiles = 0;
+            thePool.parallelFor(work.size(), [&](const size_t index) {
+                const fs::path tilePath = getTilePath(theDimDir, zoom, work[index]);
+                const Picture picture(tileWidth, tileWidth, CHANNELS);
+                if (renderParent(theDimDir, zoom, work[index], tileWidth, picture)) {
+                    picture.saveWithName(tilePath.string());
+                    ++writtenTiles;
+                } else {
+                    std::error_code removeError;
+                    fs::remove(tilePath, removeError);
+                }
+            });
+            theStats.writtenTiles += writtenTiles;
+
+            levelTiles = std::move(parentTiles);
+            changedTiles = std::move(changedParents);
+        }
+
+        // zooms left over from when the dimension was larger
+        for (u32 extra = zoom + 1; fs::exists(theDimDir / std::to_string(extra)); extra++) {
+            fs::remove_all(theDimDir / std::to_string(extra), error);
+        }
+
+        return writeRegionList(listPath, regions, tileWidth);
+    }
+
+
+    MU ND int renderWorldMap(const FileListing& theListing, const fs::path& theOutDir,
+                             c_u32 theThreadCount, WorldMapStats* theStats) {
+        WorldMapStats stats;
+        ThreadPool pool(theThreadCount);
+        for (u32 dimension = 0; dimension < 3; dimension++) {
+            c_int status = renderDimension(*theListing.ptrs.dimFileLists[dimension],
+                                           theOutDir / DIMENSION_NAMES[dimension],
+                                           dimension == 0, pool, stats);
+            if (status != SUCCESS) {
+                return status;
+            }
+        }
+
+        if (theStats != nullptr) {
+            *theStats = stats;
+        }
+        return SUCCESS;
+    }
+}
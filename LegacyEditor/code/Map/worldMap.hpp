@@ -0,0 +1,40 @@
+#pragma once
+
+#include "include/ghc/fs_std.hpp"
+
+#include "lce/processor.hpp"
+
+
+namespace editor {
+
+    class FileListing;
+
+    namespace map {
+
+
+        /// What a call to renderWorldMap did.
+        struct WorldMapStats {
+            u32 renderedRegions = 0;
+            /// regions whose chunk timestamps had not changed since the last render
+            u32 skippedRegions = 0;
+            u32 writtenTiles = 0;
+        };
+
+
+        /**
+         * Renders every dimension of "theListing" from the top down, colored the same as an in-game map,
+         * into a pyramid of PNG tiles: "<theOutDir>/<dimension>/<zoom>/<x>_<z>.png".
+         * \n\n
+         * Zoom 0 has a tile per region file at one pixel per block. Each further zoom joins 2x2 tiles
+         * of the one below at half the scale, up to the first zoom that does not have fewer tiles.
+         * \n\n
+         * The chunk timestamps of every region are kept in "<theOutDir>/<dimension>/regions.txt";
+         * only regions that changed since then are rendered again, along with the tiles above them.
+         * @param theThreadCount how many threads render regions, and the chunks inside them
+         * @param theStats filled in with what was rendered, if given
+         * @return SUCCESS, or FILE_ERROR if a folder or region list could not be written
+         */
+        MU ND int renderWorldMap(const FileListing& theListing, const fs::path& theOutDir,
+                                 u32 theThreadCount = 1, WorldMapStats* theStats = nullptr);
+    }
+}
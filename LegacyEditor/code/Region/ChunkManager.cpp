@@ -2,12 +2,14 @@
 
 #include <cstring>
 
-#include "include/tinf/tinf.h"
-#include "include/zlib-1.2.12/zlib.h"
-
 #include "lce/processor.hpp"
 
+#include "LegacyEditor/utils/bufferPool.hpp"
+#include "LegacyEditor/utils/dataManager.hpp"
+#include "LegacyEditor/utils/deflateBackend.hpp"
+#include "LegacyEditor/utils/NBTReader.hpp"
 #include "LegacyEditor/utils/RLE/rle.hpp"
+#include "LegacyEditor/utils/timer.hpp"
 #include "LegacyEditor/utils/XBOX_LZX/XDecompress.hpp"
 
 #include "LegacyEditor/code/Chunk/v10.hpp"
@@ -32,6 +34,7 @@ namespace editor {
 
     ChunkManager::ChunkManager() {
         chunkData = new chunk::ChunkData();
+        myOriginal.setScopeDealloc(true);
     }
 
 
@@ -40,6 +43,36 @@ namespace editor {
     }
 
 
+    MU ND ChunkManager::CODEC ChunkManager::getCodec(const lce::CONSOLE console) {
+        switch (console) {
+            case lce::CONSOLE::XBOX360:
+                return CODEC::XMEM;
+            case lce::CONSOLE::PS3:
+            case lce::CONSOLE::RPCS3:
+                return CODEC::DEFLATE;
+            case lce::CONSOLE::SWITCH:
+            case lce::CONSOLE::WIIU:
+            case lce::CONSOLE::VITA:
+            case lce::CONSOLE::PS4:
+                return CODEC::ZLIB;
+            default:
+                return CODEC::UNKNOWN;
+        }
+    }
+
+
+    MU ND bool ChunkManager::canCompress(const lce::CONSOLE console) {
+        c_auto codec = getCodec(console);
+        return codec == CODEC::DEFLATE || codec == CODEC::ZLIB;
+    }
+
+
+    MU ND bool ChunkManager::canPassThrough(const lce::CONSOLE consoleIn, const lce::CONSOLE consoleOut) {
+        c_auto codecIn = getCodec(consoleIn);
+        return codecIn != CODEC::UNKNOWN && codecIn == getCodec(consoleOut);
+    }
+
+
     int ChunkManager::checkVersion() const {
         if (this->data == nullptr) {
             return -1;
@@ -51,11 +84,12 @@ namespace editor {
     }
 
 
-    MU void ChunkManager::readChunk(MU const lce::CONSOLE inConsole) {
+    MU void ChunkManager::readChunk(MU const lce::CONSOLE inConsole, c_u8 readMask) {
         // cannot read chunk if there is no data
         if (size == 0) {
             return;
         }
+        const StageTimer timer(STAGE::CHUNK_PARSE);
         // if the file is compressed, decompress it first
         if (fileData.getCompressedFlag()) {
             ensureDecompress(inConsole);
@@ -63,6 +97,7 @@ namespace editor {
         // read the chunk
         DataManager managerIn(data, size);
         chunkData->lastVersion = managerIn.readInt16();
+        chunkData->isDirty = false;
 
         switch(chunkData->lastVersion) {
             case V_NBT:
@@ -70,26 +105,82 @@ namespace editor {
                 chunk::ChunkV10(chunkData, &managerIn).readChunk();
                 break;
             case V_8: case V_9: case V_11:
-                chunk::ChunkV11(chunkData, &managerIn).readChunk();
+                chunk::ChunkV11(chunkData, &managerIn).readChunk(readMask);
                 break;
             case V_12:
-                chunk::ChunkV12(chunkData, &managerIn).readChunk();
+                chunk::ChunkV12(chunkData, &managerIn).readChunk(readMask);
                 break;
             case V_13:
-                chunk::ChunkV13(chunkData, &managerIn).readChunk();
+                chunk::ChunkV13(chunkData, &managerIn).readChunk(readMask);
                 break;
             default:;
         }
     }
 
 
-    MU void ChunkManager::writeChunk(MU lce::CONSOLE outConsole) {
-        Data outBuffer;
-        outBuffer.allocate(CHUNK_BUFFER_SIZE);
-        memset(outBuffer.data, 0, CHUNK_BUFFER_SIZE);
-        DataManager managerOut(outBuffer);
+    MU int ChunkManager::visitNBT(MU const lce::CONSOLE inConsole, NBTVisitor& theVisitor) {
+        if (size == 0) {
+            return SUCCESS;
+        }
+        if (fileData.getCompressedFlag()) {
+            ensureDecompress(inConsole);
+        }
+        if (size < 2) {
+            return INVALID_SAVE;
+        }
+        DataManager managerIn(data, size);
+
+        // the rest of the chunk is seeked past into a scratch chunk, which decodes nothing
+        chunk::ChunkData scratch;
+        switch (managerIn.readInt16()) {
+            case V_NBT:
+                managerIn.seekStart();
+                break;
+            case V_8: case V_9: case V_11:
+                chunk::ChunkV11(&scratch, &managerIn).readChunk(0);
+                break;
+            case V_12:
+                chunk::ChunkV12(&scratch, &managerIn).readChunk(0);
+                break;
+            case V_13:
+                chunk::ChunkV13(&scratch, &managerIn).readChunk(0);
+                break;
+            default:
+                return SUCCESS;
+        }
+
+        if (managerIn.getPosition() >= size || *managerIn.ptr != TAG_COMPOUND) {
+            return SUCCESS;
+        }
+        return NBTReader::read(managerIn, theVisitor);
+    }
 
 
+    MU int ChunkManager::writeChunk(MU lce::CONSOLE outConsole) {
+        // a chunk that was not edited would come out the same, so it keeps the data it was read from
+        if (!chunkData->hasChanged()) {
+            return SUCCESS;
+        }
+        // an edited chunk is never put back as it was read
+        myOriginal.deallocate();
+        // the parts that were not read would be written as empty
+        if (chunkData->readMask != chunk::READ_ALL) {
+            return printf_err(INVALID_ARGUMENT, "ChunkManager::writeChunk: chunk %s was edited "
+                              "but only partly read\n", chunkData->getCoords().c_str());
+        }
+        const StageTimer timer(STAGE::CHUNK_WRITE);
+        const BufferPool::Buffer outBuffer(CHUNK_BUFFER_SIZE);
+        if (outBuffer.data() == nullptr) {
+            return printf_err(MALLOC_FAILED, "Failed to allocate %u bytes for writing chunk\n", CHUNK_BUFFER_SIZE);
+        }
+        // the V11 writer seeks past bytes that it expects to be zero, the others write every byte
+        if (chunkData->lastVersion != V_NBT && chunkData->lastVersion != V_12) {
+            memset(outBuffer.data(), 0, CHUNK_BUFFER_SIZE);
+        }
+        DataManager managerOut(outBuffer.data(), CHUNK_BUFFER_SIZE);
+
+
+        u64 nbtSize = 0;
         switch (chunkData->lastVersion) {
             case V_NBT:
                 chunk::ChunkV10(chunkData, &managerOut).writeChunk();
@@ -99,10 +190,12 @@ namespace editor {
             case V_11:
                 managerOut.writeInt16(chunkData->lastVersion);
                 chunk::ChunkV11(chunkData, &managerOut).writeChunk();
+                nbtSize = chunkData->getNBTSize();
                 break;
             case V_12:
                 managerOut.writeInt16(chunkData->lastVersion);
                 chunk::ChunkV12(chunkData, &managerOut).writeChunk();
+                nbtSize = chunkData->getNBTSize();
                 break;
             case V_13:
                 printf("ChunkManager::writeChunk v13 forbidden\n");
@@ -110,65 +203,98 @@ namespace editor {
             default:;
         }
 
+        // the NBT is sized first, so the chunk is allocated once at its final size
+        // and the NBT is written straight into it instead of going through "outBuffer"
+        c_u32 headSize = managerOut.getPosition();
+        if (headSize + nbtSize > CHUNK_BUFFER_SIZE) {
+            return printf_err(INVALID_ARGUMENT, "ChunkManager::writeChunk: chunk %s is too large to write\n",
+                              chunkData->getCoords().c_str());
+        }
         Data outData;
-        outData.allocate(managerOut.getPosition());
-        std::memcpy(outData.data, outBuffer.data, outData.size);
-        outBuffer.deallocate();
+        if (!outData.allocate(headSize + static_cast<u32>(nbtSize))) {
+            return printf_err(MALLOC_FAILED, "Failed to allocate %u bytes for writing chunk\n",
+                              headSize + static_cast<u32>(nbtSize));
+        }
+        std::memcpy(outData.data, outBuffer.data(), headSize);
+        DataManager nbtOut(outData.data + headSize, static_cast<u32>(nbtSize));
+        chunkData->writeNBTData(nbtOut);
 
         deallocate();
         data = outData.data;
         size = outData.size;
 
         fileData.setDecSize(size);
+        chunkData->isDirty = false;
+        return SUCCESS;
     }
 
 
     // TODO: rewrite to return status
-    int ChunkManager::ensureDecompress(lce::CONSOLE consoleIn, bool skipRLE) {
+    int ChunkManager::ensureDecompress(lce::CONSOLE consoleIn, bool skipRLE, lce::CONSOLE consoleOut) {
         if (fileData.getCompressedFlag() == 0U
             || data == nullptr
             || size == 0) {
             return SUCCESS;
         }
 
+        // keep the compressed bytes for ensureCompressed, reading them through a view
+        myOriginalFileData = fileData;
+        myOriginalConsole = consoleIn;
+        myOriginal.steal(*this);
+        view(myOriginal.data, myOriginal.size);
+
         u32 dec_size = fileData.getDecSize();
+        c_bool decodeRLE = fileData.getRLEFlag() == 1U && !skipRLE;
+
+        // the inflated data only has to outlive the RLE pass, so it goes in a reused buffer
+        BufferPool::Buffer rleBuffer;
         Data decompData;
-        decompData.allocate(fileData.getDecSize());
+        if (decodeRLE) {
+            rleBuffer = BufferPool::Buffer(dec_size);
+            decompData.view(rleBuffer.data(), dec_size);
+        } else {
+            decompData.allocate(dec_size);
+        }
 
 
         int result = SUCCESS;
-        switch (consoleIn) {
-            case lce::CONSOLE::XBOX360: {
-                u8 *ptr = data;
-                result = XDecompress(
-                        decompData.start(), &decompData.size, ptr, size);
-                break;
-            }
-            case lce::CONSOLE::RPCS3:
-            case lce::CONSOLE::PS3: {
-                result = tinf_uncompress(
-                        decompData.start(), &decompData.size, data, size);
-                break;
+        {
+            const StageTimer timer(STAGE::INFLATE);
+            switch (consoleIn) {
+                case lce::CONSOLE::XBOX360: {
+                    u8 *ptr = data;
+                    result = XDecompress(
+                            decompData.start(), &decompData.size, ptr, size);
+                    break;
+                }
+                case lce::CONSOLE::RPCS3:
+                case lce::CONSOLE::PS3: {
+                    result = getDeflateBackend().inflateRaw(
+                            decompData.start(), decompData.size, data, size);
+                    break;
+                }
+                case lce::CONSOLE::SWITCH:
+                case lce::CONSOLE::WIIU:
+                case lce::CONSOLE::VITA:
+                case lce::CONSOLE::PS4:
+                    result = getDeflateBackend().inflateZlib(
+                            decompData.start(), decompData.size, data, size);
+                    break;
+                default:
+                    break;
             }
-            case lce::CONSOLE::SWITCH:
-            case lce::CONSOLE::WIIU:
-            case lce::CONSOLE::VITA:
-            case lce::CONSOLE::PS4:
-                result = tinf_zlib_uncompress(
-                        decompData.start(), &decompData.size, data, size);
-                break;
-            default:
-                break;
         }
 
         fileData.setCompressedFlag(0U);
 
 
-        if (fileData.getRLEFlag() == 1U && !skipRLE) {
+        if (decodeRLE) {
+            const StageTimer timer(STAGE::RLE);
             deallocate();
             allocate(fileData.getRLESize());
+            u32 rleSize = size;
             RLE_decompress(decompData.start(),
-                decompData.size, start(), dec_size);
+                decompData.size, start(), rleSize);
 
             fileData.setRLEFlag(0U);
             decompData.deallocate();
@@ -178,85 +304,83 @@ namespace editor {
             if (!skipRLE) { size = dec_size; }
         }
 
+        // they could never be put back as they are, so they are not kept
+        if (!canPassThrough(consoleIn, consoleOut == lce::CONSOLE::NONE ? consoleIn : consoleOut)) {
+            myOriginal.deallocate();
+        }
+
         return result;
     }
 
 
     // TODO: rewrite to return status
-    int ChunkManager::ensureCompressed(const lce::CONSOLE console, bool skipRLE) {
+    int ChunkManager::ensureCompressed(const lce::CONSOLE console, bool skipRLE, c_int level) {
         if (fileData.getCompressedFlag() != 0U
             || console == lce::CONSOLE::NONE
             || data == nullptr
             || size == 0) {
             return SUCCESS;
         }
+
+        // an unedited chunk is put back as it was read, if "console" stores chunks the same way
+        if (myOriginal.data != nullptr
+            && !chunkData->hasChanged()
+            && canPassThrough(myOriginalConsole, console)) {
+            c_u32 timestamp = fileData.getTimestamp();
+            steal(myOriginal);
+            fileData = myOriginalFileData;
+            fileData.setTimestamp(timestamp);
+            return SUCCESS;
+        }
+        // checked before anything is changed, so a chunk that cannot be compressed is left as it is
+        if (getCodec(console) == CODEC::XMEM) {
+            // XCompress(comp_ptr, comp_size, data_ptr, data_size);
+            return printf_err(NOT_IMPLEMENTED, "trying to write xbox360 chunk with "
+                              "ChunkManager::ensureCompressed, not supported yet\n");
+        }
+        if (!canCompress(console)) {
+            return printf_err(INVALID_CONSOLE, "ChunkManager::ensureCompressed: unknown console\n");
+        }
+        myOriginal.deallocate();
+
         fileData.setCompressedFlag(1U);
         fileData.setDecSize(size);
 
+        // RLE and deflate both go through reused buffers, only the result is allocated
+        c_u8* input = data;
+        u32 inputSize = size;
+        BufferPool::Buffer rleBuffer;
         if (fileData.getRLEFlag() == 0U && !skipRLE) {
-            Data rleBuffer;
-            rleBuffer.allocate(size);
-            RLE_compress(data, size, rleBuffer.data, rleBuffer.size);
-            steal(rleBuffer);
-
-            fileData.setRLESize(size);
+            const StageTimer timer(STAGE::RLE);
+            // a lone 255 takes two bytes, so this is the worst case
+            rleBuffer = BufferPool::Buffer(size * 2);
+            inputSize = rleBuffer.capacity();
+            RLE_compress(data, size, rleBuffer.data(), inputSize);
+            input = rleBuffer.data();
+
+            fileData.setRLESize(inputSize);
             fileData.setRLEFlag(1);
         }
 
-        // allocate memory and recompress
-        int status = INVALID_CONSOLE;
-        switch (console) {
-            case lce::CONSOLE::XBOX360:
-                printf("trying to write xbox360 chunk with ChunkManager::ensureCompressed, "
-                       "not supported yet\n");
-                // TODO: leaks memory
-                // XCompress(comp_ptr, comp_size, data_ptr, data_size);
-                break;
-
-            case lce::CONSOLE::PS3:
-            case lce::CONSOLE::RPCS3: {
-                auto *comp_ptr = new u8[size];
-                uLongf comp_size = size;
-                status = compress(comp_ptr, &comp_size, data, size);
-                deallocate();
-                if (status != 0) {
-                    printf("error has occurred compressing chunk\n");
-                    return MALLOC_FAILED;
-                }
-                // copy it over, and remove ZLIB header
-                data = new u8[comp_size - 2];
-                size = comp_size - 2;
-                std::memcpy(data, comp_ptr + 2, size);
-                // zero out ending integrity check, as the console does
-                // std::memset(data + comp_size - 6, 0, 4);
-                delete[] comp_ptr;
-                comp_size = 0;
-                break;
-            }
-
-            case lce::CONSOLE::SWITCH:
-            case lce::CONSOLE::PS4:
-            case lce::CONSOLE::WIIU:
-            case lce::CONSOLE::VITA: {
-                auto* comp_ptr = new u8[size];
-                uLongf comp_size = size;
-
-                status = compress(comp_ptr, &comp_size, data, size);
-                deallocate();
-                if (status != 0) {
-                    printf("error has occurred compressing chunk\n");
-                    return MALLOC_FAILED;
-                }
-                data = comp_ptr;
-                size = comp_size;
-                comp_size = 0;
-                break;
-            }
-            default:
-                break;
+        const StageTimer timer(STAGE::DEFLATE);
+        const DeflateBackend& backend = getDeflateBackend();
+        BufferPool::Buffer compBuffer(backend.getDeflateBound(inputSize));
+        u32 comp_size = compBuffer.capacity();
+        if (backend.deflateZlib(compBuffer.data(), comp_size, input, inputSize, level) != SUCCESS) {
+            deallocate();
+            printf("error has occurred compressing chunk\n");
+            return MALLOC_FAILED;
         }
-
-        return status;
+        // PS3 chunks are stored without the 2 byte ZLIB header
+        c_u32 headerSize = getCodec(console) == CODEC::DEFLATE ? 2 : 0;
+        // zero out ending integrity check, as the console does
+        // std::memset(data + comp_size - 6, 0, 4);
+
+        Data result;
+        result.allocate(comp_size - headerSize);
+        std::memcpy(result.data, compBuffer.data() + headerSize, result.size);
+        steal(result);
+        return SUCCESS;
     }
 
 
@@ -3,11 +3,14 @@
 #include "lce/enums.hpp"
 
 #include "LegacyEditor/utils/data.hpp"
+#include "LegacyEditor/utils/deflateBackend.hpp"
 #include "LegacyEditor/utils/error_status.hpp"
 
 #include "LegacyEditor/code/Chunk/chunkData.hpp"
 
 
+class NBTVisitor;
+
 namespace editor {
     // namespace chunk {
     //     class ChunkData;
@@ -17,6 +20,14 @@ namespace editor {
         static constexpr u32 CHUNK_BUFFER_SIZE = 0xFFFFFF; // 4,194,303
 
     public:
+        /// How a console compresses its chunks, after RLE.
+        enum class CODEC : u8 {
+            UNKNOWN,
+            XMEM,       // XBOX360
+            DEFLATE,    // PS3, RPCS3: zlib without its 2 byte header
+            ZLIB,       // PS4, VITA, WIIU, SWITCH
+        };
+
         struct FileData {
         private:
 
@@ -54,6 +65,13 @@ namespace editor {
             MU ND u64 getCompressedFlag() const { return anon.isCompressed; }
         };
 
+    private:
+        /// The compressed bytes the chunk was decompressed from, while they can still be put back; see ensureCompressed.
+        Data myOriginal;
+        FileData myOriginalFileData;
+        lce::CONSOLE myOriginalConsole = lce::CONSOLE::NONE;
+
+    public:
         FileData fileData;
         chunk::ChunkData* chunkData = nullptr;
 
@@ -78,11 +96,52 @@ namespace editor {
 
         MU ND int checkVersion() const;
 
-        int ensureDecompress(lce::CONSOLE consoleIn, bool skipRLE = false);
-        int ensureCompressed(lce::CONSOLE console, bool skipRLE = false);
-
-        MU void readChunk(lce::CONSOLE inConsole);
-        MU void writeChunk(lce::CONSOLE outConsole);
+        MU ND static CODEC getCodec(lce::CONSOLE console);
+
+        /// Whether ensureCompressed can compress chunks for "console"; XMEM cannot be written yet.
+        MU ND static bool canCompress(lce::CONSOLE console);
+
+        /**
+         * Chunks of consoles that share a codec are stored the same way, so they can be
+         * copied between them still compressed; only the region header changes.
+         */
+        MU ND static bool canPassThrough(lce::CONSOLE consoleIn, lce::CONSOLE consoleOut);
+
+        /**
+         * @param consoleOut the console the chunk will be compressed for, NONE if it is "consoleIn";
+         *                   the compressed bytes are only kept if ensureCompressed can put them back for it
+         */
+        int ensureDecompress(lce::CONSOLE consoleIn, bool skipRLE = false,
+                             lce::CONSOLE consoleOut = lce::CONSOLE::NONE);
+        /**
+         * @param level the deflate level, see DeflateBackend::deflateZlib
+         * @return SUCCESS; NOT_IMPLEMENTED for XBOX360, INVALID_CONSOLE for a console with no
+         *         known codec, the chunk is then left decompressed
+         */
+        int ensureCompressed(lce::CONSOLE console, bool skipRLE = false,
+                             int level = DEFAULT_COMPRESSION_LEVEL);
+
+        /**
+         * Decodes the chunk into chunkData.
+         * @param readMask the parts to decode (see chunk::READ_PART); the others are seeked past
+         *                 and left empty; writeChunk then refuses to write the chunk if it was edited.
+         *                 Old NBT chunks are always read whole.
+         */
+        MU void readChunk(lce::CONSOLE inConsole, u8 readMask = chunk::READ_ALL);
+
+        /**
+         * Runs "theVisitor" over the chunk's NBT (entities, tile entities and tile ticks) with NBTReader,
+         * without decoding the rest of the chunk. chunkData is left as it is.
+         * Old NBT chunks are one tag, so the whole chunk is visited.
+         * @return SUCCESS, also if the chunk has no NBT; INVALID_SAVE if it is corrupt
+         */
+        MU ND int visitNBT(lce::CONSOLE inConsole, NBTVisitor& theVisitor);
+        /**
+         * Encodes chunkData back into the chunk, if it has changed since it was read.
+         * @return SUCCESS, also if nothing had changed; INVALID_ARGUMENT if it was edited
+         *         but not read with chunk::READ_ALL
+         */
+        MU int writeChunk(lce::CONSOLE outConsole);
 
         void setSizeFromReading(u32 sizeIn);
         ND u32 getSizeForWriting() const;
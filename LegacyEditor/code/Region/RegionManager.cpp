@@ -1,9 +1,11 @@
 #include "RegionManager.hpp"
 
-#include <stdexcept>
+#include <algorithm>
 #include <cstring>
+#include <stdexcept>
 
 #include "LegacyEditor/code/LCEFile/LCEFile.hpp"
+#include "LegacyEditor/code/threaded.hpp"
 #include "LegacyEditor/utils/dataManager.hpp"
 #include "LegacyEditor/utils/error_status.hpp"
 
@@ -34,6 +36,49 @@ namespace editor {
     }
 
 
+    /**
+     * Older saves name each region after (chunk >> 5) and fill all 32x32 slots, while
+     * newer ones place a region every 16 chunks and only fill the first 16x16 slots.
+     * The file names alone do not say which, so one chunk outside of r.0.0 is decoded
+     * and its coordinates are compared against both layouts.
+     * @param theFiles the region files of one dimension
+     * @return how far a chunk coordinate is shifted to get its region, 5 or 4
+     */
+    int RegionManager::findRegionShift(const std::vector<LCEFile*>& theFiles) {
+        for (const LCEFile* file : theFiles) {
+            c_int regionX = file->getRegionX();
+            c_int regionZ = file->getRegionZ();
+            if (regionX == 0 && regionZ == 0) {
+                continue;
+            }
+
+            RegionManager region;
+            if (region.read(file) != SUCCESS) {
+                continue;
+            }
+            for (u32 index = 0; index < 1024; index++) {
+                ChunkManager& chunk = region.chunks[index];
+                if (chunk.size == 0) {
+                    continue;
+                }
+                chunk.readChunk(file->console);
+                if (!chunk.chunkData->validChunk) {
+                    continue;
+                }
+                c_int slotX = static_cast<int>(index & 31);
+                c_int slotZ = static_cast<int>(index >> 5);
+                if (chunk.chunkData->chunkX == regionX * 16 + slotX
+                    && chunk.chunkData->chunkZ == regionZ * 16 + slotZ) {
+                    return 4;
+                }
+                return 5;
+            }
+        }
+        return 5;
+    }
+
+
+
     /**
      * step 1: copying data from file
      * step 2: read timestamps [CHUNK_COUNT]
@@ -98,7 +143,6 @@ namespace editor {
                 printf("Failed to allocate %d bytes for chunk", chunk.size);
                 return STATUS::MALLOC_FAILED;
             }
-            std::memset(chunk.data, 0, chunk.size);
 
             switch (myConsole) {
                 case lce::CONSOLE::PS3:
@@ -120,100 +164,119 @@ namespace editor {
     }
 
 
-    void RegionManager::convertChunks(lce::CONSOLE consoleIn) {
-        MU int index = 0;
-        for (auto& chunk: chunks) {
-            if (chunk.size == 0) continue;
+    /**
+     * Re-encodes every chunk for "consoleIn". Chunks are independent,
+     * so if a pool is given they are spread across its threads.
+     * Does nothing if both consoles use the same codec, see ChunkManager::canPassThrough.
+     * @param consoleIn the console to convert the chunks to
+     * @param pool the pool to run on, or nullptr to run on this thread
+     * @param level the deflate level the chunks are re-compressed with
+     */
+    void RegionManager::convertChunks(lce::CONSOLE consoleIn, ThreadPool* pool, c_int level) {
+        static constexpr size_t CHUNKS_PER_TASK = 16;
+
+        if (ChunkManager::canPassThrough(myConsole, consoleIn)) {
+            return;
+        }
+
+        auto convertChunk = [this, consoleIn, level](const size_t index) {
+            ChunkManager& chunk = chunks[index];
+            if (chunk.size == 0) return;
 
             MU c_bool shouldSkipRLE = chunk.fileData.getCompressedFlag();
-            chunk.ensureDecompress(myConsole, shouldSkipRLE);
-            chunk.ensureCompressed(consoleIn, shouldSkipRLE);
+            chunk.ensureDecompress(myConsole, shouldSkipRLE, consoleIn);
+            chunk.ensureCompressed(consoleIn, shouldSkipRLE, level);
+        };
 
-            index++;
+        if (pool == nullptr) {
+            for (size_t index = 0; index < SECTOR_INTS; index++) {
+                convertChunk(index);
+            }
+            return;
         }
+        pool->parallelFor(SECTOR_INTS, convertChunk, CHUNKS_PER_TASK);
     }
 
 
     /**
      * step 1: make sure all chunks are compressed correctly
-     * step 2: recalculate sectorCount of each chunk
-     * step 3: calculate chunk offsets for each chunk
-     * step 4: allocate memory and create buffer
-     * step 5: write each chunk offset
-     * step 6: write each chunk timestamp
-     * step 7: seek to each location, write chunk attr's, then chunk data
+     * step 2: lay out the chunks, column by column, after the two header sectors
+     * step 3: allocate the file once, at its final size
+     * step 4: write each chunk offset and timestamp
+     * step 5: write each chunk's attr's and data, and zero the rest of its sectors
+     * \n\n
+     * Every byte is written once, so the buffer is never cleared beforehand.
      * @param consoleIn
+     * @param level the deflate level of chunks that still have to be compressed
      * @return
      */
-    Data RegionManager::write(const lce::CONSOLE consoleIn) {
-        u8 sectors[SECTOR_INTS] = {};
-        u32 locations[SECTOR_INTS] = {};
-
-        // 1: Sectors Block
-        // 2: Locations Block
-        int total_sectors = 2;
-        for (u32 x = 0; x < 32; x++) {
-            for (u32 z = 0; z < 32; z++) {
-                u32 chunkIndex = z * 32 + x;
-                if (ChunkManager& chunk = chunks[chunkIndex]; chunk.size != 0) {
-                    chunk.ensureCompressed(consoleIn);
-                    sectors[chunkIndex] = (chunk.size + CHUNK_HEADER_SIZE) / SECTOR_BYTES + 1;
-                    locations[chunkIndex] = total_sectors;
-                    total_sectors += sectors[chunkIndex];
+    Data RegionManager::write(const lce::CONSOLE consoleIn, c_int level) {
+        c_bool isPS3 = consoleIn == lce::CONSOLE::PS3 || consoleIn == lce::CONSOLE::RPCS3;
+        c_u32 chunkHeaderSize = isPS3 ? 12 : 8;
+
+        // where each chunk goes, and where the last one ends, which is where the file stops
+        struct {
+            u8 sectors[SECTOR_INTS] = {};
+            u32 locations[SECTOR_INTS] = {};
+            u32 size = 0;
+        } layout;
+
+        // 1 + 2: the sectors and locations blocks come first
+        u32 totalSectors = 2;
+        for (u32 x = 0; x < REGION_WIDTH; x++) {
+            for (u32 z = 0; z < REGION_WIDTH; z++) {
+                c_u32 chunkIndex = z * REGION_WIDTH + x;
+                ChunkManager& chunk = chunks[chunkIndex];
+                if (chunk.size == 0) {
+                    continue;
                 }
+                chunk.ensureCompressed(consoleIn, false, level);
+                layout.sectors[chunkIndex] = (chunk.size + CHUNK_HEADER_SIZE) / SECTOR_BYTES + 1;
+                layout.locations[chunkIndex] = totalSectors;
+                totalSectors += layout.sectors[chunkIndex];
+                layout.size = layout.locations[chunkIndex] * SECTOR_BYTES + chunkHeaderSize + chunk.size;
             }
         }
 
-        c_u32 data_size = total_sectors * SECTOR_BYTES;
+        // 3
         Data dataOut;
-        dataOut.allocate(data_size);
+        if (layout.size == 0) {
+            return dataOut;
+        }
+        if (!dataOut.allocate(layout.size)) {
+            printf("Failed to allocate %u bytes for region", layout.size);
+            dataOut.reset();
+            return dataOut;
+        }
         DataManager managerOut(dataOut, consoleIsBigEndian(consoleIn));
-        std::memset(dataOut.data, 0, dataOut.size);
-
-        u32 largestOffset = 0;
-        managerOut.incrementPointer(0x2000);
-        for (u32 x = 0; x < 32; x++) {
-            for (u32 z = 0; z < 32; z++) {
-                u32 chunkIndex = z * 32 + x;
-
-                u32 chunk_header = sectors[chunkIndex] | locations[chunkIndex] << 8;
-                managerOut.writeInt32AtOffset(0x0 + chunkIndex * 4, chunk_header);
-
-                u32 chunk_timestamp = chunks[chunkIndex].fileData.getTimestamp();
-                managerOut.writeInt32AtOffset(0x1000 + chunkIndex * 4, chunk_timestamp);
-
-
-                if (sectors[chunkIndex] == 0) {
-                    managerOut.seek(locations[chunkIndex] * SECTOR_BYTES);
-                    managerOut.incrementPointer(8);
-                    if (consoleIn == lce::CONSOLE::PS3 || consoleIn == lce::CONSOLE::RPCS3) {
-                        managerOut.incrementPointer(4);
-                    }
-
-                } else {
-                    ChunkManager& chunk = chunks[chunkIndex];
-                    managerOut.seek(locations[chunkIndex] * SECTOR_BYTES);
-                    managerOut.writeInt32(chunk.getSizeForWriting());
-                    switch (consoleIn) {
-                        case lce::CONSOLE::PS3:
-                        case lce::CONSOLE::RPCS3:
-                            managerOut.writeInt32(chunk.fileData.getDecSize());
-                            managerOut.writeInt32(chunk.fileData.getRLESize());
-                            break;
-                        default:
-                            managerOut.writeInt32(chunk.fileData.getDecSize());
-                            break;
-                    }
-                    managerOut.writeBytes(chunk.start(), chunk.size);
-                    if (managerOut.getPosition() > largestOffset) {
-                        largestOffset = managerOut.getPosition();
-                    }
-                }
 
+        // 4
+        for (u32 chunkIndex = 0; chunkIndex < SECTOR_INTS; chunkIndex++) {
+            c_u32 chunkHeader = layout.sectors[chunkIndex] | layout.locations[chunkIndex] << 8;
+            managerOut.writeInt32AtOffset(0x0 + chunkIndex * 4, chunkHeader);
+            managerOut.writeInt32AtOffset(0x1000 + chunkIndex * 4, chunks[chunkIndex].fileData.getTimestamp());
+        }
+
+        // 5
+        for (u32 chunkIndex = 0; chunkIndex < SECTOR_INTS; chunkIndex++) {
+            if (layout.sectors[chunkIndex] == 0) {
+                continue;
             }
+            const ChunkManager& chunk = chunks[chunkIndex];
+            c_u32 chunkStart = layout.locations[chunkIndex] * SECTOR_BYTES;
+            managerOut.seek(chunkStart);
+            managerOut.writeInt32(chunk.getSizeForWriting());
+            managerOut.writeInt32(chunk.fileData.getDecSize());
+            if (isPS3) {
+                managerOut.writeInt32(chunk.fileData.getRLESize());
+            }
+            std::memcpy(managerOut.ptr, chunk.start(), chunk.size);
+
+            c_u32 chunkEnd = chunkStart + chunkHeaderSize + chunk.size;
+            c_u32 sectorEnd = std::min(chunkStart + layout.sectors[chunkIndex] * SECTOR_BYTES, layout.size);
+            std::memset(dataOut.data + chunkEnd, 0, sectorEnd - chunkEnd);
         }
 
-        dataOut.size = largestOffset;
         return dataOut;
     }
 }
\ No newline at end of file
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <vector>
+
 #include "lce/processor.hpp"
 
 #include "LegacyEditor/code/Region/ChunkManager.hpp"
@@ -7,6 +9,7 @@
 
 namespace editor {
     class LCEFile;
+    class ThreadPool;
 
     class RegionManager {
         static constexpr u32 REGION_WIDTH = 32;
@@ -29,11 +32,15 @@ namespace editor {
         MU ChunkManager* getChunk(u32 index);
         MU ChunkManager* getNonEmptyChunk();
 
+        /// How far a chunk coordinate is shifted to get the region it is in, 5 or 4 (see the definition).
+        MU ND static int findRegionShift(const std::vector<LCEFile*>& theFiles);
+
         /// READ AND WRITE
 
         int read(const LCEFile* fileIn);
-        MU void convertChunks(lce::CONSOLE consoleIn);
-        Data write(lce::CONSOLE consoleIn);
+        MU void convertChunks(lce::CONSOLE consoleIn, ThreadPool* pool = nullptr,
+                              int level = DEFAULT_COMPRESSION_LEVEL);
+        Data write(lce::CONSOLE consoleIn, int level = DEFAULT_COMPRESSION_LEVEL);
 
     };
 
@@ -1,4 +1,206 @@
 #include "WorldManager.hpp"
 
+#include <algorithm>
+
+#include "LegacyEditor/code/FileListing/fileListing.hpp"
+#include "LegacyEditor/code/LCEFile/LCEFile.hpp"
+
+
 namespace editor {
-} // editor
\ No newline at end of file
+
+
+    static u32 toRegionKey(c_int regionX, c_int regionZ) {
+        return static_cast<u32>(static_cast<u16>(regionX)) << 16 | static_cast<u16>(regionZ);
+    }
+
+
+    WorldManager::WorldManager(FileListing& theListing, const lce::FILETYPE theDimension, const size_t theMaxRegions)
+        : myListing(theListing), myDimension(theDimension), myMaxRegions(std::max<size_t>(1, theMaxRegions)) {}
+
+
+    WorldManager::~WorldManager() {
+        clear();
+    }
+
+
+    FileList& WorldManager::getRegionFiles() const {
+        switch (myDimension) {
+            case lce::FILETYPE::REGION_NETHER:
+                return myListing.ptrs.region_nether;
+            case lce::FILETYPE::REGION_END:
+                return myListing.ptrs.region_end;
+            case lce::FILETYPE::REGION_OVERWORLD:
+            default:
+                return myListing.ptrs.region_overworld;
+        }
+    }
+
+
+    int WorldManager::getRegionShift() {
+        if (myRegionShift == 0) {
+            myRegionShift = RegionManager::findRegionShift(getRegionFiles());
+        }
+        return myRegionShift;
+    }
+
+
+    /**
+     * Finds the region in the cache, or reads it from the listing.
+     * @return nullptr if the listing does not have that region
+     */
+    WorldManager::LoadedRegion* WorldManager::getRegion(c_int regionX, c_int regionZ) {
+        c_u32 key = toRegionKey(regionX, regionZ);
+
+        if (c_auto found = myRegionLookup.find(key); found != myRegionLookup.end()) {
+            myRegions.splice(myRegions.begin(), myRegions, found->second);
+            return found->second->second.get();
+        }
+
+        LCEFile* regionFile = nullptr;
+        for (LCEFile* file : getRegionFiles()) {
+            if (file->getRegionX() == regionX && file->getRegionZ() == regionZ) {
+                regionFile = file;
+                break;
+            }
+        }
+        if (regionFile == nullptr) {
+            return nullptr;
+        }
+
+        // make room by writing back the least recently used region
+        while (myRegions.size() >= myMaxRegions) {
+            auto& [lastKey, lastRegion] = myRegions.back();
+            flushRegion(*lastRegion);
+            myRegionLookup.erase(lastKey);
+            myRegions.pop_back();
+        }
+
+        auto loaded = std::make_unique<LoadedRegion>();
+        loaded->file = regionFile;
+        if (loaded->region.read(regionFile) != SUCCESS) {
+            return nullptr;
+        }
+
+        myRegions.emplace_front(key, std::move(loaded));
+        myRegionLookup[key] = myRegions.begin();
+        return myRegions.front().second.get();
+    }
+
+
+    /**
+     * Decodes the chunk holding the block column (xIn, zIn) if it has not been already.
+     * @return nullptr if the chunk does not exist
+     */
+    chunk::ChunkData* WorldManager::getChunk(c_int xIn, c_int zIn) {
+        c_int chunkX = xIn >> 4;
+        c_int chunkZ = zIn >> 4;
+        c_int shift = getRegionShift();
+
+        LoadedRegion* loaded = getRegion(chunkX >> shift, chunkZ >> shift);
+        if (loaded == nullptr) {
+            return nullptr;
+        }
+
+        c_int slotMask = (1 << shift) - 1;
+        c_u32 chunkIndex = (chunkX & slotMask) + (chunkZ & slotMask) * 32;
+        ChunkManager& chunk = loaded->region.chunks[chunkIndex];
+        if (chunk.size == 0) {
+            return nullptr;
+        }
+
+        if (loaded->chunks.insert(chunkIndex).second) {
+            chunk.readChunk(loaded->file->console);
+        }
+        return chunk.chunkData;
+    }
+
+
+    /**
+     * Re-encodes the edited chunks, puts back the ones that were only read,
+     * and writes the region back to its file if anything was edited.
+     * @return SUCCESS, or the first status a chunk failed with; the file is then left as it was
+     */
+    int WorldManager::flushRegion(LoadedRegion& loaded) const {
+        c_auto console = loaded.file->console;
+
+        int status = SUCCESS;
+        bool isDirty = false;
+        for (c_u32 chunkIndex : loaded.chunks) {
+            ChunkManager& chunk = loaded.region.chunks[chunkIndex];
+            isDirty |= chunk.chunkData->hasChanged();
+            int result = chunk.writeChunk(console);
+            if (result == SUCCESS) {
+                result = chunk.ensureCompressed(console);
+            }
+            if (status == SUCCESS) {
+                status = result;
+            }
+            delete chunk.chunkData;
+            chunk.chunkData = new chunk::ChunkData();
+        }
+        loaded.chunks.clear();
+
+        // a region with a chunk that could not be encoded is not written, the file keeps what it had
+        if (isDirty && status == SUCCESS) {
+            Data data = loaded.region.write(console);
+            loaded.file->data.steal(data);
+        }
+        return status;
+    }
+
+
+    MU u16 WorldManager::getBlock(c_int xIn, c_int yIn, c_int zIn) {
+        if (yIn < 0 || yIn > 255) {
+            return 0;
+        }
+        chunk::ChunkData* chunkData = getChunk(xIn, zIn);
+        if (chunkData == nullptr || !chunkData->validChunk) {
+            return 0;
+        }
+        return chunkData->getBlock(xIn & 15, yIn, zIn & 15);
+    }
+
+
+    MU int WorldManager::setBlock(c_int xIn, c_int yIn, c_int zIn, c_u16 block, c_u16 data, c_bool waterlogged) {
+        if (yIn < 0 || yIn > 255) {
+            return INVALID_ARGUMENT;
+        }
+        // the edited chunk could not be compressed again when it is flushed
+        if (!ChunkManager::canCompress(myListing.myReadSettings.getConsole())) {
+            return NOT_IMPLEMENTED;
+        }
+        chunk::ChunkData* chunkData = getChunk(xIn, zIn);
+        if (chunkData == nullptr || !chunkData->validChunk) {
+            return INVALID_ARGUMENT;
+        }
+
+        // v12 is the only version ChunkManager::writeChunk can fully write back
+        if (chunkData->lastVersion != 12) {
+            return NOT_IMPLEMENTED;
+        }
+
+        chunkData->placeBlock(xIn & 15, yIn, zIn & 15, block, data, waterlogged);
+        return SUCCESS;
+    }
+
+
+    MU int WorldManager::flush() {
+        int status = SUCCESS;
+        for (auto& [key, loaded] : myRegions) {
+            if (c_int result = flushRegion(*loaded); result != SUCCESS) {
+                status = result;
+            }
+        }
+        return status;
+    }
+
+
+    MU int WorldManager::clear() {
+        c_int status = flush();
+        myRegionLookup.clear();
+        myRegions.clear();
+        return status;
+    }
+
+
+} // editor
@@ -1,25 +1,84 @@
 #pragma once
 
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "lce/enums.hpp"
+#include "lce/processor.hpp"
+
 #include "LegacyEditor/code/Region/RegionManager.hpp"
 
 namespace editor {
+class FileList;
+class FileListing;
 class LCEFile;
 
 /**
- * should be part of FileListing?
- * should be passed all the regions
- * has functions getBlock(), setBlock()
- * if it needs a specific region, it reads it
- * if it needs a specific chunk, it reads it
- * call a function at the end of its usage to clean up loaded chunks
- * should regionManager be rewritten to act more like chunkManager?
+ * Gives block access to a whole dimension of a FileListing.
+ * \n\n
+ * Regions are read when a block inside them is first asked for, and only the chunks
+ * that are touched get decompressed. At most "maxRegions" regions are kept, the least
+ * recently used one is written back (if it was edited) and dropped to make room.
+ * \n\n
+ * Edits stay in memory until "flush" is called, the region is evicted, or the
+ * WorldManager is destroyed. Chunks that were only read are put back exactly as they
+ * were, so a region that was never edited is never re-encoded.
  */
 class WorldManager {
+    struct LoadedRegion {
+        LCEFile* file = nullptr;
+        RegionManager region;
+        /// the indices of the chunks that have been decoded
+        std::unordered_set<u32> chunks;
+    };
+
+    using RegionList = std::list<std::pair<u32, std::unique_ptr<LoadedRegion>>>;
+
+    FileListing& myListing;
+    lce::FILETYPE myDimension;
+    size_t myMaxRegions;
+    /// chunk >> myRegionShift gives the region a chunk is in, 0 until it is known
+    int myRegionShift = 0;
+
+    /// most recently used first
+    RegionList myRegions;
+    std::unordered_map<u32, RegionList::iterator> myRegionLookup;
+
+    FileList& getRegionFiles() const;
+    int getRegionShift();
+    LoadedRegion* getRegion(int regionX, int regionZ);
+    chunk::ChunkData* getChunk(int xIn, int zIn);
+    int flushRegion(LoadedRegion& loaded) const;
+
 public:
-    WorldManager() = default;
+    /**
+     * @param theListing the listing whose region files are read and written to
+     * @param theDimension REGION_OVERWORLD, REGION_NETHER or REGION_END
+     * @param theMaxRegions how many regions may be loaded at once
+     */
+    explicit WorldManager(FileListing& theListing,
+                          lce::FILETYPE theDimension = lce::FILETYPE::REGION_OVERWORLD,
+                          size_t theMaxRegions = 4);
+    ~WorldManager();
+
+    WorldManager(const WorldManager&) = delete;
+    WorldManager& operator=(const WorldManager&) = delete;
+
+    /// Returns (blockID << 4 | dataTag), or 0 (air) if the chunk does not exist.
+    MU ND u16 getBlock(int xIn, int yIn, int zIn);
 
+    /// Only chunks that already exist can be edited.
+    MU int setBlock(int xIn, int yIn, int zIn, u16 block, u16 data, bool waterlogged = false);
 
+    /// Writes every edited chunk back into its region file.
+    MU int flush();
+
+    /// Flushes, then unloads every region.
+    MU int clear();
+
+    MU ND size_t getLoadedRegionCount() const { return myRegions.size(); }
 };
 
 } // editor
-
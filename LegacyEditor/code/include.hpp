@@ -4,4 +4,5 @@
 #include "LegacyEditor/code/FileListing/fileListing.hpp"
 
 #include "LegacyEditor/code/Map/map.hpp"
+#include "LegacyEditor/code/Map/worldMap.hpp"
 #include "LegacyEditor/code/scripts.hpp"
\ No newline at end of file
@@ -99,7 +99,7 @@ namespace editor {
                 }
             }
 
-            std::memcpy(&chunkData->newBlocks[0], &blocks[0], 131072);
+            std::memcpy(chunkData->editBlocks().data(), &blocks[0], 131072);
             // shuffleArray(&chunkData->newBlocks[0], 65535);
             // memset(&chunkData->biomes[0], 0x0B, 256);
             // memset(&chunkData->blockLight[0], 0xFF, 32768);
@@ -162,9 +162,9 @@ namespace editor {
                 }
             }
 
-            std::memcpy(chunkData->newBlocks.data(), &blocks[0], 131072);
-            memset(chunkData->blockLight.data(), 0xFF, 32768);
-            memset(chunkData->skyLight.data(), 0xFF, 32768);
+            std::memcpy(chunkData->editBlocks().data(), &blocks[0], 131072);
+            memset(chunkData->editBlockLight().data(), 0xFF, 32768);
+            memset(chunkData->editSkyLight().data(), 0xFF, 32768);
             chunkData->terrainPopulated = 2046;
 
             chunkData->defaultNBT();
@@ -209,6 +209,7 @@ namespace editor {
 
             // there is probably a better way to go about this
             memset(chunkManager.chunkData->heightMap.data(), 0, 256);
+            chunkManager.chunkData->isDirty = true;
 
             chunkManager.writeChunk(outConsole);
             chunkManager.ensureCompressed(outConsole);
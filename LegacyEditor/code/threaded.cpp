@@ -1,34 +1,184 @@
 #include "threaded.hpp"
 
-#include <functional>
-#include <vector>
-#include <thread>
+#include <algorithm>
+#include <exception>
 
-#include "LegacyEditor/code/FileListing/fileListing.hpp"
 
+namespace editor {
 
-template<int threadCount, typename Function, typename... Args>
-int run_parallel(Function func, Args... args) {
-    std::vector<std::thread> threads;
-    for (int i = 0; i < threadCount; ++i) {
-        threads.emplace_back(std::bind(func, i, args...));
+
+    /// the pool and queue index of the worker running on this thread, if any.
+    static thread_local const ThreadPool* currentPool = nullptr;
+    static thread_local size_t currentIndex = 0;
+
+
+    ThreadPool::ThreadPool(c_u32 theThreadCount) {
+        c_u32 workerCount = std::max(1U, theThreadCount) - 1;
+        myQueues.reserve(workerCount);
+        for (u32 i = 0; i < workerCount; i++) {
+            myQueues.push_back(std::make_unique<TaskQueue>());
+        }
+        myWorkers.reserve(workerCount);
+        for (u32 i = 0; i < workerCount; i++) {
+            myWorkers.emplace_back(&ThreadPool::workerLoop, this, i);
+        }
     }
-    for (auto& thread : threads) {
-        if (thread.joinable()) {
-            thread.join();
+
+
+    ThreadPool::~ThreadPool() {
+        {
+            std::lock_guard lock(mySleepMutex);
+            myIsStopping = true;
+        }
+        myWakeup.notify_all();
+        for (std::thread& worker : myWorkers) {
+            worker.join();
         }
     }
-    return 0;
-}
 
-template int run_parallel<4>(std::function<void(int)> func);
 
-template int run_parallel<4>(
-        void (*)(size_t, editor::FileListing&),
-        std::reference_wrapper<editor::FileListing>
-);
+    void ThreadPool::workerLoop(c_u32 theIndex) {
+        currentPool = this;
+        currentIndex = theIndex;
+        while (true) {
+            if (tryRunOne()) {
+                continue;
+            }
+            std::unique_lock lock(mySleepMutex);
+            myWakeup.wait(lock, [this] { return myIsStopping || myQueuedCount != 0; });
+            if (myIsStopping && myQueuedCount == 0) {
+                return;
+            }
+        }
+    }
+
+
+    /// workers push to their own queue, other threads spread tasks round-robin.
+    void ThreadPool::push(std::function<void()> theTask) {
+        c_auto index = currentPool == this ? currentIndex : myNextQueue++ % myQueues.size();
+        {
+            // counted under the same lock it is taken off under, so the count never drops below 0
+            std::lock_guard lock(myQueues[index]->mutex);
+            ++myQueuedCount;
+            myQueues[index]->tasks.push_back(std::move(theTask));
+        }
+        {
+            // a worker checks the count under this lock before it sleeps, so the wakeup is not lost
+            std::lock_guard lock(mySleepMutex);
+        }
+        myWakeup.notify_one();
+    }
+
+
+    /**
+     * Runs a single task, newest first from this worker's own queue,
+     * otherwise the oldest task stolen from another queue.
+     * @return false if there was nothing to run
+     */
+    bool ThreadPool::tryRunOne() {
+        if (myQueuedCount == 0) {
+            return false;
+        }
+
+        std::function<void()> task;
+        for (size_t i = 0; i < myQueues.size() && !task; i++) {
+            TaskQueue& queue = *myQueues[(currentIndex + i) % myQueues.size()];
+            std::lock_guard lock(queue.mutex);
+            if (queue.tasks.empty()) {
+                continue;
+            }
+            if (i == 0) {
+                task = std::move(queue.tasks.back());
+                queue.tasks.pop_back();
+            } else {
+                task = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+            }
+            --myQueuedCount;
+        }
 
-template int run_parallel<32>(
-        void (*)(size_t, editor::FileListing&),
-        std::reference_wrapper<editor::FileListing>
-);
\ No newline at end of file
+        if (!task) {
+            return false;
+        }
+        task();
+        return true;
+    }
+
+
+    /**
+     * The state of one "parallelFor" call. Its tasks take the next index range from it
+     * until there is none left, so a task that only runs after the call returned does nothing.
+     */
+    struct ThreadPool::Batch {
+        const std::function<void(size_t)>* func = nullptr;
+        size_t count = 0;
+        size_t grainSize = 1;
+        size_t taskCount = 0;
+
+        std::atomic<size_t> next = 0;
+        size_t remaining = 0;
+        std::mutex mutex;
+        std::condition_variable done;
+        std::exception_ptr firstError;
+
+        /// Runs index ranges until there are none left to take.
+        void runAll() {
+            for (size_t task = next++; task < taskCount; task = next++) {
+                const size_t begin = task * grainSize;
+                const size_t end = std::min(begin + grainSize, count);
+                std::exception_ptr error;
+                try {
+                    for (size_t i = begin; i < end; i++) {
+                        (*func)(i);
+                    }
+                } catch (...) {
+                    error = std::current_exception();
+                }
+
+                std::lock_guard lock(mutex);
+                if (error && !firstError) {
+                    firstError = error;
+                }
+                if (--remaining == 0) {
+                    done.notify_all();
+                }
+            }
+        }
+    };
+
+
+    void ThreadPool::parallelFor(const size_t theCount, const std::function<void(size_t)>& theFunc,
+                                 size_t theGrainSize) {
+        theGrainSize = std::max(static_cast<size_t>(1), theGrainSize);
+        const size_t taskCount = (theCount + theGrainSize - 1) / theGrainSize;
+
+        if (myWorkers.empty() || taskCount <= 1) {
+            for (size_t i = 0; i < theCount; i++) {
+                theFunc(i);
+            }
+            return;
+        }
+
+        // the tasks may outlive this call, so they share the batch instead of pointing at the stack
+        auto batch = std::make_shared<Batch>();
+        batch->func = &theFunc;
+        batch->count = theCount;
+        batch->grainSize = theGrainSize;
+        batch->taskCount = taskCount;
+        batch->remaining = taskCount;
+        const size_t helperCount = std::min(myWorkers.size(), taskCount - 1);
+        for (size_t helper = 0; helper < helperCount; helper++) {
+            push([batch] { batch->runAll(); });
+        }
+
+        // this thread works on its own batch only, then waits for the ranges others took
+        batch->runAll();
+        std::unique_lock lock(batch->mutex);
+        batch->done.wait(lock, [&batch] { return batch->remaining == 0; });
+
+        if (batch->firstError) {
+            std::rethrow_exception(batch->firstError);
+        }
+    }
+
+}
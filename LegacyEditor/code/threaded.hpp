@@ -1,18 +1,76 @@
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 
-/**
- * \n
- * It is a requirement that the first argument passed to the
- * function is an index based on the maximum thread count.
- * \n\n
- * use 'std::ref' for references.
- * @tparam threadCount how many threads to create
- * @tparam Function
- * @tparam Args
- * @param func the function to call
- * @param args the arguments to pass to the function
- * @return
- */
-template<int threadCount, typename Function, typename... Args>
-int run_parallel(Function func, Args... args);
+#include "lce/processor.hpp"
+
+
+namespace editor {
+
+
+    /**
+     * A work-stealing thread pool.
+     * \n\n
+     * Every worker owns a queue. Tasks submitted from a worker go to the back of
+     * its own queue and are taken from the back (newest first), while idle workers
+     * steal from the front of other queues (oldest first). This keeps nested work,
+     * such as the chunks of a region that is itself a task, close to the thread
+     * that created it, and lets idle threads pick up the rest.
+     * \n\n
+     * A thread that calls "parallelFor" runs the indices of that call itself alongside
+     * the workers, and only blocks for the ones already being run on other threads,
+     * so "parallelFor" can be called from inside a task without deadlocking.
+     */
+    class ThreadPool {
+        struct TaskQueue {
+            std::mutex mutex;
+            std::deque<std::function<void()>> tasks;
+        };
+        struct Batch;
+
+        std::vector<std::unique_ptr<TaskQueue>> myQueues;
+        std::vector<std::thread> myWorkers;
+
+        std::mutex mySleepMutex;
+        std::condition_variable myWakeup;
+        std::atomic<size_t> myQueuedCount = 0;
+        std::atomic<size_t> myNextQueue = 0;
+        bool myIsStopping = false;
+
+        void workerLoop(u32 theIndex);
+        void push(std::function<void()> theTask);
+        bool tryRunOne();
+
+    public:
+        /**
+         * @param theThreadCount how many threads do work, including the thread
+         * that calls "parallelFor". "1" runs everything on the calling thread.
+         */
+        explicit ThreadPool(u32 theThreadCount);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        MU ND u32 getThreadCount() const { return static_cast<u32>(myWorkers.size()) + 1; }
+
+        /**
+         * Calls "theFunc(i)" for every i in [0, theCount), and returns once all calls finished.
+         * \n
+         * The first exception thrown by "theFunc" is rethrown on the calling thread.
+         * @param theCount how many indices to run
+         * @param theFunc the function to call with each index
+         * @param theGrainSize how many indices one task runs
+         */
+        void parallelFor(size_t theCount, const std::function<void(size_t)>& theFunc, size_t theGrainSize = 1);
+    };
+
+
+}
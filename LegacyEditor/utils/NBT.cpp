@@ -1,110 +1,244 @@
 #include "NBT.hpp"
 
+#include <bit>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+
+#include "LegacyEditor/utils/endianDataManager.hpp"
+
 
 static constexpr int TO_STRING_MAX_LIST_SIZE = 128;
 
 
-void NBTBase::write(DataManager& output) const {
-    switch (type) {
-        case NBT_INT8: {
-            u8 writeVal = 0;
-            std::memcpy(&writeVal, data, 1);
-            output.writeInt8(writeVal);
-            return;
-        }
-        case NBT_INT16: {
-            i16 writeVal = 0;
-            std::memcpy(&writeVal, data, 2);
-            output.writeInt16(writeVal);
-            return;
-        }
-        case NBT_INT32: {
-            i32 writeVal = 0;
-            std::memcpy(&writeVal, data, 4);
-            output.writeInt32(writeVal);
-            return;
-        }
-        case NBT_INT64: {
-            i64 writeVal = 0;
-            std::memcpy(&writeVal, data, 8);
-            output.writeInt64(writeVal);
-            return;
-        }
-        case NBT_FLOAT: {
-            float writeVal = 0;
-            std::memcpy(&writeVal, data, 4);
-            output.writeFloat(writeVal);
-            return;
-        }
-        case NBT_DOUBLE: {
-            double writeVal = 0;
-            std::memcpy(&writeVal, data, 8);
-            output.writeDouble(writeVal);
-            return;
-        }
-        case TAG_BYTE_ARRAY: {
-            c_auto* val = toType<NBTTagByteArray>();
-            output.writeInt32(val->size);
-            output.writeBytes(val->array, val->size);
-            return;
+std::string_view NBTKeyPool::intern(const std::string_view theKey) {
+    // each thread remembers the keys it has seen, so that only new ones take the lock
+    thread_local std::unordered_set<std::string_view> seen;
+    if (c_auto iter = seen.find(theKey); iter != seen.end()) {
+        return *iter;
+    }
+
+    static std::mutex mutex;
+    // never destructed, pooled keys may still be used while the process exits
+    static auto* pool = new std::unordered_set<std::string, NBTKeyHash, NBTKeyEqual>();
+    std::string_view pooled;
+    {
+        std::scoped_lock lock(mutex);
+        auto iter = pool->find(theKey);
+        if (iter == pool->end()) {
+            iter = pool->emplace(theKey).first;
+        }
+        // the set is node based, so the string (and its characters) never move
+        pooled = *iter;
+    }
+    seen.insert(pooled);
+    return pooled;
+}
+
+
+/// Creates a tag whose object is allocated in "theArena", or with new when it is nullptr.
+template<class classType, class... Args>
+static NBTBase makeTag(NBTArena* theArena, const NBTType theType, Args&&... args) {
+    if (theArena != nullptr) {
+        return {theArena->create<classType>(std::forward<Args>(args)...), theType, true};
+    }
+    return {new classType(std::forward<Args>(args)...), theType};
+}
+
+
+namespace {
+
+    /**
+     * Writes encoded NBT in the byte order picked at compile time, with plain stores and
+     * no bounds checks; the caller makes sure the output holds NBTBase::getEncodedSize bytes.
+     */
+    template<std::endian ORDER>
+    class NBTWriter {
+        EndianDataManager<ORDER> myOutput;
+
+        void put8(c_u8 theValue) { myOutput.writeInt8(theValue); }
+        void put16(c_u16 theValue) { myOutput.writeInt16(theValue); }
+        void put32(c_u32 theValue) { myOutput.writeInt32(theValue); }
+        void put64(c_u64 theValue) { myOutput.writeInt64(theValue); }
+
+        void putBytes(const void* theData, c_u32 theSize) {
+            myOutput.writeBytes(static_cast<c_u8*>(theData), theSize);
         }
-        case TAG_STRING: {
-            c_auto* val = toType<NBTTagString>();
-            output.writeUTF(val->getString());
-            return;
+
+        /// Like DataManager::writeUTF, the length is cut to 16 bits but every byte is written.
+        void putString(const std::string_view theString) {
+            put16(static_cast<u16>(theString.size()));
+            putBytes(theString.data(), static_cast<u32>(theString.size()));
         }
-        case TAG_LIST: {
-            c_auto* val = toType<NBTTagList>();
-            output.writeInt8(val->tagType);
-            output.writeInt32(val->tagList.size());
-            for (c_auto& item: val->tagList) {
-                item.write(output);
-            }
-            return;
+
+        template<class intType>
+        void putArray(const intType* theArray, c_int theSize) {
+            put32(static_cast<u32>(theSize));
+            myOutput.writeArray(theArray, std::max(theSize, 0));
         }
-        case TAG_COMPOUND: {
-            auto* val = toType<NBTTagCompound>();
-            auto iter = val->tagMap.begin();
-            for (size_t sizeIter = 0; sizeIter < val->tagMap.size(); sizeIter++) {
-                NBTTagCompound::writeEntry(iter->first, iter->second, output);
-                ++iter;
-            }
 
-            output.writeInt8(0);
-            return;
+    public:
+        explicit NBTWriter(const DataManager& theOutput) : myOutput(theOutput) {}
+
+        ND u8* getPtr() const { return myOutput.ptr; }
+
+        void putEntry(const std::string_view theName, const NBTBase& theTag) {
+            put8(theTag.getId());
+            if (theTag.getId() != NBT_NONE) {
+                putString(theName);
+                putValue(theTag);
+            }
         }
 
-        case TAG_INT_ARRAY: {
-            c_auto* val = toType<NBTTagIntArray>();
-            output.writeInt32(val->size);
-            for (int sizeIter = 0; sizeIter < val->size; sizeIter++) {
-                output.writeInt32(val->array[sizeIter]);
+        void putValue(const NBTBase& theTag) {
+            switch (theTag.type) {
+                case NBT_INT8:
+                    put8(theTag.getPrim<u8>());
+                    return;
+                case NBT_INT16:
+                    put16(theTag.getPrim<u16>());
+                    return;
+                case NBT_INT32:
+                case NBT_FLOAT:
+                    put32(theTag.getPrim<u32>());
+                    return;
+                case NBT_INT64:
+                case NBT_DOUBLE:
+                    put64(theTag.getPrim<u64>());
+                    return;
+                case TAG_BYTE_ARRAY: {
+                    c_auto* val = theTag.toType<NBTTagByteArray>();
+                    put32(static_cast<u32>(val->size));
+                    putBytes(val->array, std::max(val->size, 0));
+                    return;
+                }
+                case TAG_STRING: {
+                    c_auto* val = theTag.toType<NBTTagString>();
+                    putString(std::string_view(val->data, val->size));
+                    return;
+                }
+                case TAG_LIST: {
+                    c_auto* val = theTag.toType<NBTTagList>();
+                    put8(val->tagType);
+                    put32(static_cast<u32>(val->tagList.size()));
+                    for (const NBTBase& item: val->tagList) {
+                        putValue(item);
+                    }
+                    return;
+                }
+                case TAG_COMPOUND: {
+                    for (const auto& [key, tag]: theTag.toType<NBTTagCompound>()->tags) {
+                        putEntry(key, tag);
+                    }
+                    put8(NBT_NONE);
+                    return;
+                }
+                case TAG_INT_ARRAY: {
+                    c_auto* val = theTag.toType<NBTTagIntArray>();
+                    putArray(val->array, val->size);
+                    return;
+                }
+                case TAG_LONG_ARRAY: {
+                    c_auto* val = theTag.toType<NBTTagLongArray>();
+                    putArray(val->array, val->size);
+                    return;
+                }
+                default:;
             }
-            return;
         }
+    };
 
-        case TAG_LONG_ARRAY: {
-            c_auto* val = toType<NBTTagLongArray>();
-            output.writeInt32(val->size);
 
-            for (int sizeIter = 0; sizeIter < val->size; sizeIter++) {
-                output.writeInt64(val->array[sizeIter]);
-            }
+    /// Runs "theWrite" with a writer at the position of "theOutput", in its byte order, and moves past what it wrote.
+    template<class Function>
+    void writeTo(DataManager& theOutput, Function&& theWrite) {
+        u8* end;
+        if (theOutput.isBig) {
+            NBTWriter<std::endian::big> writer(theOutput);
+            theWrite(writer);
+            end = writer.getPtr();
+        } else {
+            NBTWriter<std::endian::little> writer(theOutput);
+            theWrite(writer);
+            end = writer.getPtr();
         }
-        default:;
+        theOutput.incrementPointer(static_cast<u32>(end - theOutput.ptr));
     }
+
 }
 
-void NBTBase::NbtFree() const {
+
+void NBTBase::write(DataManager& output) const {
+    writeTo(output, [this](auto& writer) { writer.putValue(*this); });
+}
+
+
+u64 NBTBase::getEncodedSize() const {
     switch (type) {
         case NBT_INT8:
+            return 1;
         case NBT_INT16:
+            return 2;
         case NBT_INT32:
-        case NBT_INT64:
         case NBT_FLOAT:
+            return 4;
+        case NBT_INT64:
         case NBT_DOUBLE:
-            free(this->data);
-            return;
+            return 8;
+        case TAG_BYTE_ARRAY:
+            return 4 + static_cast<u64>(std::max(toType<NBTTagByteArray>()->size, 0));
+        case TAG_STRING:
+            return 2 + static_cast<u64>(toType<NBTTagString>()->size);
+        case TAG_LIST: {
+            u64 size = 5;
+            for (const NBTBase& item: toType<NBTTagList>()->tagList) {
+                size += item.getEncodedSize();
+            }
+            return size;
+        }
+        case TAG_COMPOUND: {
+            u64 size = 1;
+            for (const auto& [key, tag]: toType<NBTTagCompound>()->tags) {
+                size += NBTTagCompound::getEntrySize(key, tag);
+            }
+            return size;
+        }
+        case TAG_INT_ARRAY:
+            return 4 + 4 * static_cast<u64>(std::max(toType<NBTTagIntArray>()->size, 0));
+        case TAG_LONG_ARRAY:
+            return 4 + 8 * static_cast<u64>(std::max(toType<NBTTagLongArray>()->size, 0));
+        default:
+            return 0;
+    }
+}
+
+
+NBTBase NBTBase::create(const NBTType theType, NBTArena* theArena) {
+    switch (theType) {
+        case TAG_BYTE_ARRAY:
+            return makeTag<NBTTagByteArray>(theArena, theType);
+        case TAG_STRING:
+            return makeTag<NBTTagString>(theArena, theType);
+        case TAG_LIST:
+            return makeTag<NBTTagList>(theArena, theType, theArena);
+        case TAG_COMPOUND:
+            return makeTag<NBTTagCompound>(theArena, theType, theArena);
+        case TAG_INT_ARRAY:
+            return makeTag<NBTTagIntArray>(theArena, theType);
+        case TAG_LONG_ARRAY:
+            return makeTag<NBTTagLongArray>(theArena, theType);
+        default:
+            return {nullptr, theType, theArena != nullptr};
+    }
+}
+
+
+void NBTBase::NbtFree() const {
+    // primitives are stored inline, and tags in an arena are freed with it
+    if (inArena) {
+        return;
+    }
+    switch (type) {
         case TAG_BYTE_ARRAY: {
             c_auto* val = toType<NBTTagByteArray>();
             free(val->array);
@@ -119,12 +253,18 @@ void NBTBase::NbtFree() const {
         }
         case TAG_LIST: {
             auto* val = toType<NBTTagList>();
+            if (val->arena != nullptr) {
+                return;
+            }
             val->deleteAll();
             delete val;
             return;
         }
         case TAG_COMPOUND: {
             auto* val = toType<NBTTagCompound>();
+            if (val->arena != nullptr) {
+                return;
+            }
             val->deleteAll();
             delete val;
             return;
@@ -149,36 +289,18 @@ std::string NBTBase::toString() const {
     switch (type) {
         case NBT_NONE:
             return "END";
-        case NBT_INT8: {
-            u8 val = 0;
-            std::memcpy(&val, this->data, 1);
-            return std::to_string(val) + "b";
-        }
-        case NBT_INT16: {
-            i16 val = 0;
-            std::memcpy(&val, this->data, 2);
-            return std::to_string(val) + "s";
-        }
-        case NBT_INT32: {
-            i32 val = 0;
-            std::memcpy(&val, this->data, 4);
-            return std::to_string(val);
-        }
-        case NBT_INT64: {
-            i64 val = 0;
-            std::memcpy(&val, this->data, 8);
-            return std::to_string(val) + "L";
-        }
-        case NBT_FLOAT: {
-            float val = 0;
-            std::memcpy(&val, this->data, 4);
-            return std::to_string(val) + "f";
-        }
-        case NBT_DOUBLE: {
-            double val = 0;
-            std::memcpy(&val, this->data, 8);
-            return std::to_string(val) + "d";
-        }
+        case NBT_INT8:
+            return std::to_string(getPrim<u8>()) + "b";
+        case NBT_INT16:
+            return std::to_string(getPrim<i16>()) + "s";
+        case NBT_INT32:
+            return std::to_string(getPrim<i32>());
+        case NBT_INT64:
+            return std::to_string(getPrim<i64>()) + "L";
+        case NBT_FLOAT:
+            return std::to_string(getPrim<float>()) + "f";
+        case NBT_DOUBLE:
+            return std::to_string(getPrim<double>()) + "d";
         case TAG_BYTE_ARRAY: {
             c_auto* val = toType<NBTTagByteArray>();
             std::string stringBuilder = "[B;";
@@ -216,11 +338,11 @@ std::string NBTBase::toString() const {
             auto* val = toType<NBTTagCompound>();
             std::string stringBuilder = "{";
 
-            for (const std::string& str: val->getKeySet()) {
+            for (const auto& [key, tag]: val->tags) {
                 if (stringBuilder.length() != 1) { stringBuilder.append(", "); }
-                stringBuilder.append(str);
+                stringBuilder.append(key);
                 stringBuilder.append(": ");
-                stringBuilder.append(val->tagMap.at(str).toString());
+                stringBuilder.append(tag.toString());
             }
             stringBuilder.push_back('}');
             return stringBuilder;
@@ -259,62 +381,68 @@ std::string NBTBase::toString() const {
 }
 
 
-void NBTBase::read(DataManager& input) {
-    switch (type) {
-        case NBT_INT8: {
-            c_u8 readData = input.readInt8();
-            data = malloc(1);
-            std::memcpy(data, &readData, 1);
+/// Finds the entry for "key", adding an empty one at the end if there is none.
+static NBTBase& getEntry(NBTTagCompound* compound, const std::string_view key) {
+    if (NBTBase* tag = compound->findTag(key); tag != nullptr) {
+        return *tag;
+    }
+    return compound->tags.emplace_back(NBTKeyPool::intern(key), NBTBase()).second;
+}
+
+
+/**
+ * The length of a byte, int or long array, clamped to what the rest of the input holds:
+ * a corrupt length (negative, or past the end) must not reach the allocation or the single copy.
+ */
+template<class intType, std::endian ORDER>
+static int readArraySize(EndianDataManager<ORDER>& input) {
+    c_auto size = static_cast<int>(input.readInt32());
+    c_u32 left = (input.size - input.getPosition()) / sizeof(intType);
+    return static_cast<int>(std::min(static_cast<u32>(std::max(size, 0)), left));
+}
+
+
+/// NBTBase::read for a byte order known at compile time.
+template<std::endian ORDER>
+static void readValue(NBTBase& theTag, EndianDataManager<ORDER>& input, NBTArena* theArena) {
+    switch (theTag.type) {
+        case NBT_INT8:
+            theTag.setPrim(static_cast<u8>(input.readInt8()));
             return;
-        }
-        case NBT_INT16: {
-            c_auto readData = static_cast<i16>(input.readInt16());
-            data = malloc(2);
-            std::memcpy(data, &readData, 2);
+        case NBT_INT16:
+            theTag.setPrim(static_cast<i16>(input.readInt16()));
             return;
-        }
-        case NBT_INT32: {
-            c_auto readData = static_cast<i32>(input.readInt32());
-            data = malloc(4);
-            std::memcpy(data, &readData, 4);
+        case NBT_INT32:
+            theTag.setPrim(static_cast<i32>(input.readInt32()));
             return;
-        }
-        case NBT_INT64: {
-            c_auto readData = static_cast<i64>(input.readInt64());
-            data = malloc(8);
-            std::memcpy(data, &readData, 8);
+        case NBT_INT64:
+            theTag.setPrim(static_cast<i64>(input.readInt64()));
             return;
-        }
-        case NBT_FLOAT: {
-            const float readData = input.readFloat();
-            data = malloc(4);
-            std::memcpy(data, &readData, 4);
+        case NBT_FLOAT:
+            theTag.setPrim(input.readFloat());
             return;
-        }
-        case NBT_DOUBLE: {
-            const double readData = input.readDouble();
-            data = malloc(8);
-            std::memcpy(data, &readData, 8);
+        case NBT_DOUBLE:
+            theTag.setPrim(input.readDouble());
             return;
-        }
         case TAG_BYTE_ARRAY: {
-            auto* val = toType<NBTTagByteArray>();
-            c_auto num = static_cast<int>(input.readInt32());
-            val->array = input.readBytes(num);
+            auto* val = theTag.toType<NBTTagByteArray>();
+            c_int num = readArraySize<u8>(input);
+            val->array = static_cast<u8*>(NbtAlloc(theArena, num));
+            input.readBytes(num, val->array);
             val->size = num;
             return;
         }
         case TAG_STRING: {
-            auto* val = toType<NBTTagString>();
-            const std::string inputString = input.readUTF();
+            auto* val = theTag.toType<NBTTagString>();
+            const std::string_view inputString = input.readUTFView();
             c_int size = static_cast<int>(inputString.size());
-            val->data = static_cast<char*>(malloc(size));
-            std::memcpy(val->data, inputString.c_str(), size);
+            val->data = static_cast<char*>(NbtAlloc(theArena, size));
+            std::memcpy(val->data, inputString.data(), size);
             val->size = size;
             return;
         }
         case TAG_LIST: {
-            auto* val = toType<NBTTagList>();
+            auto* val = theTag.toType<NBTTagList>();
             val->tagType = static_cast<NBTType>(input.readInt8());
             c_auto size = static_cast<int>(input.readInt32());
             if (size == 0) {
@@ -326,197 +454,198 @@ void NBTBase::read(DataManager& input) {
                 printf("Missing type on ListTag");
 
             } else {
+                // every item takes at least a byte, which bounds the reserve on corrupt sizes
+                val->tagList.reserve(std::min(static_cast<u32>(std::max(size, 0)),
+                                              input.size - input.getPosition()));
                 for (int j = 0; j < size; ++j) {
-                    NBTBase* nbtBase = createNewByType(val->tagType);
-                    nbtBase->read(input);
-                    val->tagList.push_back(*nbtBase);
-                    //free the base data (the data and the type), the rest is allocated
-                    // and this is copied when pushed back so that is why we free it
-                    delete nbtBase;
+                    val->tagList.push_back(NBTBase::create(val->tagType, theArena));
+                    readValue(val->tagList.back(), input, theArena);
                 }
             }
             return;
         }
         case TAG_COMPOUND: {
-            auto* val = toType<NBTTagCompound>();
+            auto* val = theTag.toType<NBTTagCompound>();
             u8 byte;
 
             while (byte = input.readInt8(), byte != 0) {
-                std::string str = input.readUTF();
-                const NBTBase* nbtBase = NBT::readNBT(static_cast<NBTType>(byte), str, input);
-                val->tagMap[str] = *nbtBase;
-                delete nbtBase;
+                const std::string_view key = input.readUTFView();
+                NBTBase nbtBase = NBTBase::create(static_cast<NBTType>(byte), theArena);
+                readValue(nbtBase, input, theArena);
+                getEntry(val, key) = nbtBase;
             }
             return;
         }
         case TAG_INT_ARRAY: {
-            auto* val = toType<NBTTagIntArray>();
-            c_int size = static_cast<int>(input.readInt32());
-            val->array = static_cast<int*>(malloc(size * 4)); // i * size of int
-
-            for (int j = 0; j < size; ++j) {
-                val->array[j] = static_cast<int>(input.readInt32());
-            }
+            auto* val = theTag.toType<NBTTagIntArray>();
+            c_int size = readArraySize<int>(input);
+            val->array = static_cast<int*>(NbtAlloc(theArena, size * 4)); // i * size of int
+            input.readArray(val->array, size);
             val->size = size;
             return;
         }
         case TAG_LONG_ARRAY: {
-            auto* val = toType<NBTTagLongArray>();
-            c_int size = static_cast<int>(input.readInt32());
-            val->array = static_cast<i64*>(malloc(size * 8)); // i * size of long
-
-            for (int j = 0; j < size; ++j) {
-                val->array[j] = static_cast<int>(input.readInt64());
-            }
+            auto* val = theTag.toType<NBTTagLongArray>();
+            c_int size = readArraySize<i64>(input);
+            val->array = static_cast<i64*>(NbtAlloc(theArena, size * 8)); // i * size of long
+            input.readArray(val->array, size);
             val->size = size;
+            return;
         }
         default:;
     }
 }
 
 
-NBTBase NBTBase::copy() const {
+void NBTBase::read(DataManager& input, NBTArena* theArena) {
+    if (input.isBig) {
+        BigDataManager reader(input);
+        readValue(*this, reader, theArena);
+        reader.sync(input);
+    } else {
+        LittleDataManager reader(input);
+        readValue(*this, reader, theArena);
+        reader.sync(input);
+    }
+}
+
+
+NBTBase NBTBase::copy(NBTArena* theArena) const {
     switch (type) {
-        case NBT_INT8: {
-            auto* copyData = static_cast<u8*>(malloc(1));
-            std::memcpy(copyData, data, 1);
-            return {copyData, type};
-        }
-        case NBT_INT16: {
-            auto* copyData = static_cast<i16*>(malloc(2));
-            std::memcpy(copyData, data, 2);
-            return {copyData, type};
-        }
-        case NBT_INT32: {
-            auto* copyData = static_cast<i32*>(malloc(4));
-            std::memcpy(copyData, data, 4);
-            return {copyData, type};
-        }
-        case NBT_INT64: {
-            auto* copyData = static_cast<i64*>(malloc(8));
-            std::memcpy(copyData, data, 8);
-            return {copyData, type};
-        }
-        case NBT_FLOAT: {
-            auto* copyData = static_cast<float*>(malloc(4));
-            std::memcpy(copyData, data, 4);
-            return {copyData, type};
-        }
+        case NBT_INT8:
+        case NBT_INT16:
+        case NBT_INT32:
+        case NBT_INT64:
+        case NBT_FLOAT:
         case NBT_DOUBLE: {
-            auto* copyData = static_cast<double*>(malloc(8));
-            std::memcpy(copyData, data, 8);
-            return {copyData, type};
+            NBTBase copied = *this;
+            copied.inArena = theArena != nullptr;
+            return copied;
         }
         case TAG_BYTE_ARRAY: {
             c_auto* val = toType<NBTTagByteArray>();
             c_int size = val->size;
-            auto* aByte = static_cast<u8*>(malloc(size));
+            auto* aByte = static_cast<u8*>(NbtAlloc(theArena, size));
             std::memcpy(aByte, val->array, size);
-            return {new NBTTagByteArray(aByte, size), TAG_BYTE_ARRAY};
+            return makeTag<NBTTagByteArray>(theArena, TAG_BYTE_ARRAY, aByte, size);
         }
         case TAG_STRING: {
             c_auto* val = toType<NBTTagString>();
-            c_auto copied = NBTBase(new NBTTagString(val->getString()), TAG_STRING);
-            return copied;
+            return makeTag<NBTTagString>(theArena, TAG_STRING, std::string_view(val->data, val->size), theArena);
         }
         case TAG_LIST: {
             c_auto* val = toType<NBTTagList>();
-            auto* pNbtTagList = new NBTTagList();
+            NBTBase copied = create(TAG_LIST, theArena);
+            auto* pNbtTagList = copied.toType<NBTTagList>();
             pNbtTagList->tagType = val->tagType;
+            pNbtTagList->tagList.reserve(val->tagList.size());
 
-            for (NBTBase nbtBase: val->tagList) {
-                NBTBase nbtBase1 = nbtBase.copy();
-                pNbtTagList->tagList.push_back(nbtBase1);
+            for (const NBTBase& nbtBase: val->tagList) {
+                pNbtTagList->tagList.push_back(nbtBase.copy(theArena));
             }
 
-            return {pNbtTagList, TAG_LIST};
+            return copied;
         }
         case TAG_COMPOUND: {
-            auto* val = toType<NBTTagCompound>();
-            auto* pNbtTagCompound = new NBTTagCompound();
-            for (const std::vector<std::string> keySet = val->getKeySet(); const std::string& str: keySet) {
-                pNbtTagCompound->setTag(str, val->tagMap.at(str).copy());
+            c_auto* val = toType<NBTTagCompound>();
+            NBTBase copied = create(TAG_COMPOUND, theArena);
+            auto* pNbtTagCompound = copied.toType<NBTTagCompound>();
+            for (const auto& [key, tag]: val->tags) {
+                getEntry(pNbtTagCompound, key) = tag.copy(theArena);
             }
 
-            return {pNbtTagCompound, TAG_COMPOUND};
+            return copied;
         }
         case TAG_INT_ARRAY: {
             c_auto* val = toType<NBTTagIntArray>();
             c_int size = val->size * 4;
-            auto* const anInt = static_cast<int*>(malloc(size)); //size is in the number of ints
+            auto* const anInt = static_cast<int*>(NbtAlloc(theArena, size)); //size is in the number of ints
             std::memcpy(anInt, val->array, size);
-            return {new NBTTagIntArray(anInt, val->size), TAG_INT_ARRAY};
+            return makeTag<NBTTagIntArray>(theArena, TAG_INT_ARRAY, anInt, val->size);
         }
         case TAG_LONG_ARRAY: {
             c_auto* val = toType<NBTTagLongArray>();
             c_int size = val->size * 8; // size is in the number of longs
-            auto* along = static_cast<i64*>(malloc(size));
+            auto* along = static_cast<i64*>(NbtAlloc(theArena, size));
             std::memcpy(along, val->array, size);
-            return {new NBTTagLongArray(along, val->size), TAG_LONG_ARRAY};
+            return makeTag<NBTTagLongArray>(theArena, TAG_LONG_ARRAY, along, val->size);
         }
         case NBT_NONE:
         default:
-            return {nullptr, this->type};
+            return {nullptr, this->type, theArena != nullptr};
+    }
+}
+
+
+/**
+ * Tags added to a compound or list that lives in an arena are moved into it,
+ * so that the whole tree is still freed with the arena.
+ */
+static NBTBase adoptTag(NBTArena* theArena, const NBTBase& theTag) {
+    if (theArena == nullptr || theTag.inArena) {
+        return theTag;
     }
+    const NBTBase copied = theTag.copy(theArena);
+    theTag.NbtFree();
+    return copied;
 }
 
+
 /// I don't think this is necessary, but if it is then I'll do it.
 /// It just is in the java code but never used
 MU bool NBTBase::equals(MU NBTBase check) { return false; }
 
 
-void NBTTagCompound::writeEntry(const std::string& name, const NBTBase data, DataManager& output) {
-    c_int tagID = data.getId();
-    output.writeInt8(tagID);
-    if (tagID != 0) {
-        output.writeUTF(name);
-        data.write(output);
-    }
+void NBTTagCompound::writeEntry(const std::string_view name, const NBTBase data, DataManager& output) {
+    writeTo(output, [&](auto& writer) { writer.putEntry(name, data); });
+}
+
+
+u64 NBTTagCompound::getEntrySize(const std::string_view name, const NBTBase& data) {
+    return data.getId() != NBT_NONE ? 3 + name.size() + data.getEncodedSize() : 1;
 }
 
 
-std::vector<std::string> NBTTagCompound::getKeySet() {
-    std::vector<std::string> keySet;
-    auto iter = tagMap.begin();
-    c_int size = static_cast<int>(tagMap.size());
-    for (int sizeIter = 0; sizeIter < size; sizeIter++) {
-        keySet.push_back(iter->first);
-        ++iter;
+int NBTTagCompound::getSize() const { return static_cast<int>(tags.size()); }
+
+
+NBTBase* NBTTagCompound::findTag(const std::string_view key) {
+    for (auto& [name, tag]: tags) {
+        if (name == key) { return &tag; }
     }
-    return keySet;
+    return nullptr;
 }
 
 
-int NBTTagCompound::getSize() const { return static_cast<int>(tagMap.size()); }
+const NBTBase* NBTTagCompound::findTag(const std::string_view key) const {
+    return const_cast<NBTTagCompound*>(this)->findTag(key);
+}
 
 
-void NBTTagCompound::setTag(const std::string& key, const NBTBase value) {
-    if (tagMap.contains(key)) { tagMap[key].NbtFree(); }
-    tagMap[key] = value;
+void NBTTagCompound::setTag(const std::string_view key, const NBTBase value) {
+    NBTBase& entry = getEntry(this, key);
+    entry.NbtFree();
+    entry = adoptTag(arena, value);
 }
 
 
-void NBTTagCompound::setByte(const std::string& key, u8 value) {
-    if (tagMap.contains(key)) { tagMap[key].NbtFree(); }
-    tagMap[key] = NBTBase(&value, 1, NBT_INT8);
+void NBTTagCompound::setByte(const std::string_view key, u8 value) {
+    setTag(key, NBTBase(&value, 1, NBT_INT8));
 }
 
 
-void NBTTagCompound::setShort(const std::string& key, short value) {
-    if (tagMap.contains(key)) { tagMap[key].NbtFree(); }
-    tagMap[key] = NBTBase(&value, 2, NBT_INT16);
+void NBTTagCompound::setShort(const std::string_view key, short value) {
+    setTag(key, NBTBase(&value, 2, NBT_INT16));
 }
 
 
-void NBTTagCompound::setInteger(const std::string& key, int value) {
-    if (tagMap.contains(key)) { tagMap[key].NbtFree(); }
-    tagMap[key] = NBTBase(&value, 4, NBT_INT32);
+void NBTTagCompound::setInteger(const std::string_view key, int value) {
+    setTag(key, NBTBase(&value, 4, NBT_INT32));
 }
 
 
-void NBTTagCompound::setLong(const std::string& key, i64 value) {
-    if (tagMap.contains(key)) { tagMap[key].NbtFree(); }
-    tagMap[key] = NBTBase(&value, 8, NBT_INT64);
+void NBTTagCompound::setLong(const std::string_view key, i64 value) {
+    setTag(key, NBTBase(&value, 8, NBT_INT64));
 }
 
 /*
@@ -531,211 +660,183 @@ UUIDJava NBTTagCompound::getUniqueId(const std::string& key) {
 }
 */
 
-bool NBTTagCompound::hasUniqueId(const std::string& key) {
-    return hasKey(key + "Most", TAG_PRIMITIVE) && hasKey(key + "Least", TAG_PRIMITIVE);
+bool NBTTagCompound::hasUniqueId(const std::string_view key) {
+    return hasKey(std::string(key) + "Most", TAG_PRIMITIVE) && hasKey(std::string(key) + "Least", TAG_PRIMITIVE);
 }
 
 
-void NBTTagCompound::setFloat(const std::string& key, float value) {
-    if (tagMap.contains(key)) { tagMap[key].NbtFree(); }
-    tagMap[key] = NBTBase(&value, 4, NBT_FLOAT);
+void NBTTagCompound::setFloat(const std::string_view key, float value) {
+    setTag(key, NBTBase(&value, 4, NBT_FLOAT));
 }
 
 
-void NBTTagCompound::setDouble(const std::string& key, double value) {
-    if (tagMap.contains(key)) { tagMap[key].NbtFree(); }
-    tagMap[key] = NBTBase(&value, 8, NBT_DOUBLE);
+void NBTTagCompound::setDouble(const std::string_view key, double value) {
+    setTag(key, NBTBase(&value, 8, NBT_DOUBLE));
 }
 
 
-void NBTTagCompound::setString(const std::string& key, const std::string& value) {
-    if (tagMap.contains(key)) { tagMap[key].NbtFree(); }
-    tagMap[key] = NBTBase(new NBTTagString(value), TAG_STRING);
+void NBTTagCompound::setString(const std::string_view key, const std::string_view value) {
+    setTag(key, makeTag<NBTTagString>(arena, TAG_STRING, value, arena));
 }
 
-void NBTTagCompound::setByteArray(const std::string& key, c_u8* value, c_int size) {
-    if (tagMap.contains(key)) { tagMap[key].NbtFree(); }
-    auto* data = static_cast<u8*>(malloc(size)); // so the original can be safely deleted
+void NBTTagCompound::setByteArray(const std::string_view key, c_u8* value, c_int size) {
+    auto* data = static_cast<u8*>(NbtAlloc(arena, size)); // so the original can be safely deleted
     std::memcpy(data, value, size);
-    tagMap[key] = NBTBase(new NBTTagByteArray(data, size), TAG_BYTE_ARRAY);
+    setTag(key, makeTag<NBTTagByteArray>(arena, TAG_BYTE_ARRAY, data, size));
 }
 
 
-void NBTTagCompound::setIntArray(const std::string& key, c_int* value, c_int size) {
-    if (tagMap.contains(key)) { tagMap[key].NbtFree(); }
-    auto* const data = static_cast<int*>(malloc(size * 4)); // so the original can be safely deleted
+void NBTTagCompound::setIntArray(const std::string_view key, c_int* value, c_int size) {
+    auto* const data = static_cast<int*>(NbtAlloc(arena, size * 4)); // so the original can be safely deleted
     std::memcpy(data, value, size * 4);
-    tagMap[key] = NBTBase(new NBTTagIntArray(data, size), TAG_INT_ARRAY);
+    setTag(key, makeTag<NBTTagIntArray>(arena, TAG_INT_ARRAY, data, size));
 }
 
 
-void NBTTagCompound::setLongArray(const std::string& key, const i64* value, c_int size) {
-    if (tagMap.contains(key)) { tagMap[key].NbtFree(); }
-    auto* data = static_cast<i64*>(malloc(size * 8)); //so the original can be safely deleted
-    std::memcpy(data, value, size * 8);                    //the endianness is maintained because it is copied raw
-    tagMap[key] = NBTBase(new NBTTagLongArray(data, size), TAG_LONG_ARRAY);
+void NBTTagCompound::setLongArray(const std::string_view key, const i64* value, c_int size) {
+    auto* data = static_cast<i64*>(NbtAlloc(arena, size * 8)); //so the original can be safely deleted
+    std::memcpy(data, value, size * 8);                        //the endianness is maintained because it is copied raw
+    setTag(key, makeTag<NBTTagLongArray>(arena, TAG_LONG_ARRAY, data, size));
 }
 
 
-void NBTTagCompound::setCompoundTag(const std::string& key, NBTTagCompound* compoundTag) {
-    if (tagMap.contains(key)) { tagMap[key].NbtFree(); }
-    tagMap[key] = NBTBase(compoundTag, TAG_COMPOUND);
+void NBTTagCompound::setCompoundTag(const std::string_view key, NBTTagCompound* compoundTag) {
+    setTag(key, NBTBase(compoundTag, TAG_COMPOUND, arena != nullptr && compoundTag->arena == arena));
 }
 
 
-void NBTTagCompound::setListTag(const std::string& key, NBTTagList* listTag) {
-    if (tagMap.contains(key)) { tagMap[key].NbtFree(); }
-    tagMap[key] = NBTBase(listTag, TAG_LIST);
+void NBTTagCompound::setListTag(const std::string_view key, NBTTagList* listTag) {
+    setTag(key, NBTBase(listTag, TAG_LIST, arena != nullptr && listTag->arena == arena));
 }
 
 
-void NBTTagCompound::setBool(const std::string& key, u8 value) {
-    if (tagMap.contains(key)) { tagMap[key].NbtFree(); }
+void NBTTagCompound::setBool(const std::string_view key, u8 value) {
     value = value != 0U ? 1 : 0;
-    tagMap[key] = NBTBase(&value, 1, NBT_INT8);
+    setTag(key, NBTBase(&value, 1, NBT_INT8));
 }
 
 
-NBTBase NBTTagCompound::getTag(const std::string& key) {
-    if (c_auto iter = tagMap.find(key); iter != tagMap.end()) { return iter->second; }
+NBTBase NBTTagCompound::getTag(const std::string_view key) {
+    if (const NBTBase* tag = findTag(key); tag != nullptr) { return *tag; }
     return {};
 }
 
 
-NBTType NBTTagCompound::getTagId(const std::string& key) {
+NBTType NBTTagCompound::getTagId(const std::string_view key) {
     const NBTBase nbtBase = getTag(key);
     return nbtBase.getId();
 }
 
 
 void NBTTagCompound::deleteAll() {
-    for (auto& [fst, snd]: tagMap) { snd.NbtFree(); }
-    tagMap.clear();
+    for (auto& [fst, snd]: tags) { snd.NbtFree(); }
+    tags.clear();
 }
 
 
-bool NBTTagCompound::hasKey(const std::string& key) const {
-    if (tagMap.empty()) {
-        return false;
-    }
-    if (tagMap.contains(key)) {
+bool NBTTagCompound::hasKey(const std::string_view key) const {
+    return findTag(key) != nullptr;
+}
+
+
+/// Whether a tag of "tagID" is "type", TAG_PRIMITIVE matching NBT_INT8 to NBT_DOUBLE.
+static bool isOfType(c_int tagID, c_int type) {
+    if (tagID == type) {
         return true;
     }
-    return false;
+    if (type != TAG_PRIMITIVE) {
+        return false;
+    }
+    return tagID == 1 || tagID == 2 || tagID == 3 || tagID == 4 || tagID == 5 || tagID == 6;
 }
 
 
-bool NBTTagCompound::hasKey(const std::string& key, c_int type) {
-    if (hasKey(key)) {
-        c_int tagID = getTagId(key);
-        if (tagID == type) {
-            return true;
-        }
-        if (type != TAG_PRIMITIVE) {
-            return false;
-        }
-        return tagID == 1 || tagID == 2 || tagID == 3 || tagID == 4 || tagID == 5 || tagID == 6;
-    }
-    return false;
+bool NBTTagCompound::hasKey(const std::string_view key, c_int type) {
+    const NBTBase* tag = findTag(key);
+    return tag != nullptr && isOfType(tag->getId(), type);
 }
 
 
-bool NBTTagCompound::hasKey(const std::string& key, const NBTType type) {
-    if (hasKey(key)) {
-        c_int tagID = getTagId(key);
-        if (tagID == type) {
-            return true;
-        }
-        if (type != TAG_PRIMITIVE) {
-            return false;
-        }
-        return tagID == 1 || tagID == 2 || tagID == 3 || tagID == 4 || tagID == 5 || tagID == 6;
-    }
-    return false;
+bool NBTTagCompound::hasKey(const std::string_view key, const NBTType type) {
+    const NBTBase* tag = findTag(key);
+    return tag != nullptr && isOfType(tag->getId(), type);
 }
 
 
-std::string NBTTagCompound::getString(const std::string& key) {
+std::string NBTTagCompound::getString(const std::string_view key) {
     if (hasKey(key, TAG_STRING)) {
-        return NBTBase::toType<NBTTagString>(tagMap.at(key))->getString();
+        return NBTBase::toType<NBTTagString>(*findTag(key))->getString();
     }
     return "";
 }
 
 
-NBTTagByteArray* NBTTagCompound::getByteArray(const std::string& key) {
+NBTTagByteArray* NBTTagCompound::getByteArray(const std::string_view key) {
     if (hasKey(key, TAG_BYTE_ARRAY)) {
-        const NBTBase byteArrayBase = tagMap.at(key);
+        const NBTBase byteArrayBase = *findTag(key);
         return NBTBase::toType<NBTTagByteArray>(byteArrayBase);
     }
     return nullptr;
 }
 
 
-NBTTagIntArray* NBTTagCompound::getIntArray(const std::string& key) {
+NBTTagIntArray* NBTTagCompound::getIntArray(const std::string_view key) {
     if (hasKey(key, TAG_INT_ARRAY)) {
-        const NBTBase intArrayBase = tagMap.at(key);
+        const NBTBase intArrayBase = *findTag(key);
         return NBTBase::toType<NBTTagIntArray>(intArrayBase);
     }
     return nullptr;
 }
 
 
-NBTTagLongArray* NBTTagCompound::getLongArray(const std::string& key) {
+NBTTagLongArray* NBTTagCompound::getLongArray(const std::string_view key) {
     if (hasKey(key, TAG_LONG_ARRAY)) {
-        const NBTBase longArrayBase = tagMap.at(key);
+        const NBTBase longArrayBase = *findTag(key);
         return NBTBase::toType<NBTTagLongArray>(longArrayBase);
     }
     return nullptr;
 }
 
 
-NBTTagCompound* NBTTagCompound::getCompoundTag(const std::string& key) {
+NBTTagCompound* NBTTagCompound::getCompoundTag(const std::string_view key) {
     if (hasKey(key, TAG_COMPOUND)) {
-        const NBTBase base = tagMap.at(key);
+        const NBTBase base = *findTag(key);
         return NBTBase::toType<NBTTagCompound>(base);
     }
     return nullptr;
 }
 
 
-NBTTagList* NBTTagCompound::getListTag(const std::string& key) {
+NBTTagList* NBTTagCompound::getListTag(const std::string_view key) {
     if (hasKey(key, TAG_LIST)) {
-        return NBTBase::toType<NBTTagList>(tagMap.at(key));
+        return NBTBase::toType<NBTTagList>(*findTag(key));
     }
     return nullptr;
 }
 
 
-bool NBTTagCompound::getBool(const std::string& key) { return getPrimitive<bool>(key); }
+bool NBTTagCompound::getBool(const std::string_view key) { return getPrimitive<bool>(key); }
 
 
-void NBTTagCompound::removeTag(const std::string& key) {
-    if (!hasKey(key)) { return; }
-    tagMap.at(key).NbtFree();
-    tagMap.erase(key);
+void NBTTagCompound::removeTag(const std::string_view key) {
+    c_auto iter = std::ranges::find(tags, key, &NBTEntry::first);
+    if (iter == tags.end()) { return; }
+    iter->second.NbtFree();
+    tags.erase(iter);
 }
 
 
-MU bool NBTTagCompound::hasNoTags() const { return tagMap.empty(); }
+MU bool NBTTagCompound::hasNoTags() const { return tags.empty(); }
 
 
 void NBTTagCompound::merge(NBTTagCompound* other) {
-    auto iter = other->tagMap.begin();
-    c_int size = static_cast<int>(other->tagMap.size());
-    for (int x = 0; x < size; x++) {
-        std::string key = iter->first;
-        if (NBTBase nbtBase = iter->second; nbtBase.getId() == TAG_COMPOUND) {
-            if (hasKey(key, TAG_COMPOUND)) {
-                NBTTagCompound* pNbtTagCompound = getCompoundTag(key);
-                pNbtTagCompound->merge(NBTBase::toType<NBTTagCompound>(nbtBase));
-            } else {
-                setTag(key, nbtBase.copy());
-            }
+    for (const auto& [key, nbtBase]: other->tags) {
+        if (nbtBase.getId() == TAG_COMPOUND && hasKey(key, TAG_COMPOUND)) {
+            NBTTagCompound* pNbtTagCompound = getCompoundTag(key);
+            pNbtTagCompound->merge(NBTBase::toType<NBTTagCompound>(nbtBase));
         } else {
-            setTag(key, nbtBase.copy());
+            setTag(key, nbtBase.copy(arena));
         }
-        ++iter;
     }
 }
 
@@ -747,14 +848,14 @@ MU void NBTTagList::appendTag(const NBTBase nbt) {
         nbt.NbtFree();
         return;
     }
-    tagList.push_back(nbt);
+    tagList.push_back(adoptTag(arena, nbt));
 }
 
 
 void NBTTagList::set(c_u32 index, const NBTBase nbt) {
     if (index < tagList.size()) {
         tagList[index].NbtFree();
-        tagList[index] = nbt;
+        tagList[index] = adoptTag(arena, nbt);
     } else {
         nbt.NbtFree();
     }
@@ -763,7 +864,7 @@ void NBTTagList::set(c_u32 index, const NBTBase nbt) {
 
 void NBTTagList::insert(c_u32 index, const NBTBase nbt) {
     if (index < tagList.size()) {
-        tagList.insert(tagList.begin() + index, nbt);
+        tagList.insert(tagList.begin() + index, adoptTag(arena, nbt));
     } else {
         nbt.NbtFree();
     }
@@ -901,28 +1002,29 @@ NBTTagCompound* NBTUtil::createPosTag(BlockPos pos) {
 
 
 void NBT::writeTag(const NBTBase* tag, DataManager& output) {
-    output.writeInt8(tag->getId());
+    NBTTagCompound::writeEntry("", *tag, output);
+}
 
-    if (tag->getId() != NBT_NONE) {
-        output.writeUTF("");
-        tag->write(output);
-    }
+
+u64 NBT::getTagSize(const NBTBase* tag) {
+    return NBTTagCompound::getEntrySize("", *tag);
 }
 
 
-NBTBase* NBT::readTag(DataManager& input) {
+NBTBase* NBT::readTag(DataManager& input, NBTArena* theArena) {
     NBTBase* returnValue = nullptr;
     if (int id = input.readInt8(); id != 0) {
-        const std::string key = input.readUTF();
-        returnValue = readNBT(static_cast<NBTType>(id), key, input);
+        const std::string_view key = input.readUTFView();
+        returnValue = readNBT(static_cast<NBTType>(id), key, input, theArena);
     }
     return returnValue;
 }
 
 
-NBTBase* NBT::readNBT(const NBTType tagID, MU const std::string& key, DataManager& input) {
-    NBTBase* pNbtBase = createNewByType(tagID);
-    pNbtBase->read(input);
+NBTBase* NBT::readNBT(const NBTType tagID, MU const std::string_view key, DataManager& input, NBTArena* theArena) {
+    NBTBase* pNbtBase = theArena != nullptr ? theArena->create<NBTBase>(NBTBase::create(tagID, theArena))
+                                            : createNewByType(tagID);
+    pNbtBase->read(input, theArena);
     return pNbtBase;
 }
 
@@ -1,7 +1,10 @@
 #pragma once
 
+#include <algorithm>
 #include <cstring>
-#include <unordered_map>
+#include <memory_resource>
+#include <string_view>
+#include <utility>
 #include <vector>
 #include <ranges>
 
@@ -30,6 +33,51 @@ enum NBTType : u8 {
 };
 
 
+/**
+ * Bump allocator that a whole NBT tree can be read into.
+ * \n\n
+ * Every tag, string, array and container node of the tree is carved out of a few
+ * large blocks, so reading does no malloc per tag and the tree is freed by deleting
+ * the arena, not with NbtFree. Tags set on a compound or list that lives in an arena
+ * are copied into it.
+ */
+class NBTArena {
+    std::pmr::monotonic_buffer_resource myResource;
+
+public:
+    /// A read tree takes roughly this many bytes per byte of encoded NBT.
+    static constexpr size_t BYTES_PER_ENCODED_BYTE = 8;
+    static constexpr size_t MIN_BLOCK_SIZE = 1024;
+
+    explicit NBTArena(const size_t theInitialSize = MIN_BLOCK_SIZE) : myResource(theInitialSize) {}
+    NBTArena(const NBTArena&) = delete;
+    NBTArena& operator=(const NBTArena&) = delete;
+
+    /// Sizes the first block so that a tree of "theEncodedSize" bytes usually fits in it.
+    static size_t getInitialSize(const size_t theEncodedSize) {
+        return std::max(MIN_BLOCK_SIZE, theEncodedSize * BYTES_PER_ENCODED_BYTE);
+    }
+
+    ND std::pmr::memory_resource* getResource() { return &myResource; }
+
+    ND void* allocate(const size_t theSize, const size_t theAlign = alignof(std::max_align_t)) {
+        return myResource.allocate(theSize, theAlign);
+    }
+
+    /// Objects created here are never destructed, so they may only own arena memory.
+    template<class classType, class... Args>
+    ND classType* create(Args&&... args) {
+        return new (allocate(sizeof(classType), alignof(classType))) classType(std::forward<Args>(args)...);
+    }
+};
+
+
+/// Allocates from "theArena", or with malloc when it is nullptr.
+inline void* NbtAlloc(NBTArena* theArena, const size_t theSize) {
+    return theArena != nullptr ? theArena->allocate(theSize) : malloc(theSize);
+}
+
+
 template<class classType>
 class NBTTagTypeArray {
 public:
@@ -63,24 +111,39 @@ concept NBT_TAG_TYPE = std::is_same_v<T, NBTTagByteArray> ||
 
 class NBTBase {
 public:
-    void* data;
+    union {
+        void* data;
+        /// primitives (NBT_INT8 to NBT_DOUBLE) are stored here instead of behind "data"
+        u64 value;
+    };
     NBTType type;
+    /// set on tags that live in an NBTArena, NbtFree leaves those to the arena
+    bool inArena = false;
 
-    NBTBase(void* dataIn, const NBTType typeIn) : data(dataIn), type(typeIn) {}
+    NBTBase(void* dataIn, const NBTType typeIn, c_bool inArenaIn = false)
+        : data(dataIn), type(typeIn), inArena(inArenaIn) {}
 
     NBTBase() : NBTBase(nullptr, NBT_NONE) {}
 
-    NBTBase(void* dataIn, c_int dataSizeIn, const NBTType typeIn) : NBTBase(dataIn, typeIn) {
-        std::memcpy(data, dataIn, dataSizeIn);
+    NBTBase(const void* dataIn, c_int dataSizeIn, const NBTType typeIn) : value(0), type(typeIn) {
+        std::memcpy(&value, dataIn, dataSizeIn);
     }
 
+    /// Creates an empty tag, its container (if any) is allocated in "theArena" when given.
+    static NBTBase create(NBTType theType, NBTArena* theArena = nullptr);
+
+    /// Writes the value in the byte order of "output", which must have getEncodedSize bytes left.
     void write(DataManager& output) const;
 
-    void read(DataManager& input);
+    /// How many bytes "write" stores, without the type and name in front of it.
+    ND u64 getEncodedSize() const;
+
+    void read(DataManager& input, NBTArena* theArena = nullptr);
 
     ND std::string toString() const;
 
-    ND NBTBase copy() const;
+    /// Deep copy; into "theArena" when given.
+    ND NBTBase copy(NBTArena* theArena = nullptr) const;
 
     void NbtFree() const;
 
@@ -88,21 +151,34 @@ public:
 
     ND NBTType getId() const { return type; }
 
+    template<class primType>
+    ND primType getPrim() const {
+        primType prim;
+        std::memcpy(&prim, &value, sizeof(primType));
+        return prim;
+    }
+
+    template<class primType>
+    void setPrim(const primType prim) {
+        value = 0;
+        std::memcpy(&value, &prim, sizeof(primType));
+    }
+
     template<class classType>
-    classType toPrim() {
+    classType toPrim() const {
         switch (type) {
             case NBT_INT8:
-                return (classType) *(u8*) data;
+                return (classType) getPrim<u8>();
             case NBT_INT16:
-                return (classType) *(i16*) data;
+                return (classType) getPrim<i16>();
             case NBT_INT32:
-                return (classType) *(i32*) data;
+                return (classType) getPrim<i32>();
             case NBT_INT64:
-                return (classType) *(i64*) data;
+                return (classType) getPrim<i64>();
             case NBT_FLOAT:
-                return (classType) *(float*) data;
+                return (classType) getPrim<float>();
             case NBT_DOUBLE:
-                return (classType) *(double*) data;
+                return (classType) getPrim<double>();
             default:
                 return 0;
         }
@@ -132,10 +208,10 @@ public:
     i64 size;
     NBTTagString() : data(nullptr), size(0) {}
 
-    explicit NBTTagString(const std::string& dataIn) {
+    explicit NBTTagString(const std::string_view dataIn, NBTArena* theArena = nullptr) {
         size = static_cast<int>(dataIn.size());
-        data = static_cast<char*>(malloc(size));
-        std::memcpy(data, dataIn.c_str(), size);
+        data = static_cast<char*>(NbtAlloc(theArena, size));
+        std::memcpy(data, dataIn.data(), size);
     }
 
     ND bool hasNoTags() const { return size != 0; }
@@ -156,15 +232,63 @@ public:
 
 class NBTTagList;
 
+
+/// Lets the key pool be searched with a std::string_view, without building a key.
+struct NBTKeyHash {
+    using is_transparent = void;
+    size_t operator()(const std::string_view key) const { return std::hash<std::string_view>{}(key); }
+};
+
+struct NBTKeyEqual {
+    using is_transparent = void;
+    bool operator()(const std::string_view first, const std::string_view second) const { return first == second; }
+};
+
+
+/**
+ * Every compound key is stored once for the whole process: the same few names ("id", "x", "Items")
+ * repeat across thousands of compounds, which then only hold a view of the pooled copy.
+ * \n\n
+ * Pooled keys are never freed, so their views stay valid for as long as the process runs.
+ */
+class NBTKeyPool {
+public:
+    /// Returns the pooled copy of "theKey", adding it on first use; safe to call from any thread.
+    ND static std::string_view intern(std::string_view theKey);
+};
+
+
+/// A key of a compound, always pooled (see NBTKeyPool), and its tag.
+using NBTEntry = std::pair<std::string_view, NBTBase>;
+
+
 class NBTTagCompound {
-    typedef const std::string& STR;
+    typedef std::string_view STR;
 
 public:
-    std::unordered_map<std::string, NBTBase> tagMap;
+    /**
+     * The tags in the order they were read or set, which is also the order they are written in.
+     * Compounds rarely hold more than a few dozen tags, so a scan over this finds
+     * a key faster than hashing it would.
+     */
+    std::pmr::vector<NBTEntry> tags;
+    /// the arena that the tags of this compound are allocated in, or nullptr
+    NBTArena* arena = nullptr;
+
+    NBTTagCompound() = default;
+    explicit NBTTagCompound(NBTArena* theArena)
+        : tags(theArena != nullptr ? theArena->getResource() : std::pmr::get_default_resource()),
+          arena(theArena) {}
 
     static void writeEntry(STR name, NBTBase data, DataManager& output);
+    /// How many bytes writeEntry stores for "data".
+    ND static u64 getEntrySize(STR name, const NBTBase& data);
     int getSize() const;
 
+    /// The tag stored under "key", or nullptr.
+    ND NBTBase* findTag(STR key);
+    ND const NBTBase* findTag(STR key) const;
+
     // set tags
     void setTag(STR key, NBTBase value);
     void setByte(STR key, u8 value);
@@ -188,11 +312,12 @@ public:
     bool hasKey(STR key) const;
     bool hasKey(STR key, int type);
     bool hasKey(STR key, NBTType type);
-    std::vector<std::string> getKeySet();
+    /// The keys in order, without copying them.
+    ND auto getKeySet() const { return tags | std::views::keys; }
     template<typename classType>
     classType getPrimitive(STR key) {
-        if (hasKey(key, TAG_PRIMITIVE)) {
-            return tagMap.at(key).toPrim<classType>();
+        if (const NBTBase* tag = findTag(key); tag != nullptr) {
+            return tag->toPrim<classType>();
         }
         return static_cast<classType>(0);
     }
@@ -215,10 +340,15 @@ public:
 
 class NBTTagList {
 public:
-    std::vector<NBTBase> tagList;
+    std::pmr::vector<NBTBase> tagList;
     NBTType tagType;
+    /// the arena that the tags of this list are allocated in, or nullptr
+    NBTArena* arena = nullptr;
 
     NBTTagList() : tagType(NBT_NONE) {}
+    explicit NBTTagList(NBTArena* theArena)
+        : tagList(theArena != nullptr ? theArena->getResource() : std::pmr::get_default_resource()),
+          tagType(NBT_NONE), arena(theArena) {}
 
     MU void appendTag(NBTBase nbt);
     void set(const uint32_t index, const NBTBase nbt);
@@ -265,15 +395,21 @@ class NBT {
 public:
     MU static bool isCompoundTag(const NBTType type) { return type == TAG_COMPOUND; }
     static void writeTag(const NBTBase* tag, DataManager& output);
-    static NBTBase* readTag(DataManager& input);
-    static NBTBase* readNBT(NBTType tagID, const std::string& key, DataManager& input);
+    /// How many bytes writeTag stores: the type, the empty name and the value.
+    ND static u64 getTagSize(const NBTBase* tag);
+    /**
+     * Reads a named tag and everything inside it.
+     * @param theArena when given, the whole tree (the returned NBTBase included) is
+     * allocated in it; it must then be freed by deleting the arena, not with NbtFree.
+     */
+    static NBTBase* readTag(DataManager& input, NBTArena* theArena = nullptr);
+    static NBTBase* readNBT(NBTType tagID, std::string_view key, DataManager& input, NBTArena* theArena = nullptr);
 };
 
 
 MU static NBTBase createNBT_INT8(c_i8 dataIn) {
     NBTBase nbtBase;
-    nbtBase.data = malloc(sizeof(dataIn));
-    std::memcpy(nbtBase.data, &dataIn, sizeof(dataIn));
+    nbtBase.setPrim(dataIn);
     nbtBase.type = NBT_INT8;
     return nbtBase;
 }
@@ -281,8 +417,7 @@ MU static NBTBase createNBT_INT8(c_i8 dataIn) {
 
 MU static NBTBase createNBT_INT16(c_i16 dataIn) {
     NBTBase nbtBase;
-    nbtBase.data = malloc(sizeof(dataIn));
-    std::memcpy(nbtBase.data, &dataIn, sizeof(dataIn));
+    nbtBase.setPrim(dataIn);
     nbtBase.type = NBT_INT16;
     return nbtBase;
 }
@@ -290,8 +425,7 @@ MU static NBTBase createNBT_INT16(c_i16 dataIn) {
 
 MU static NBTBase createNBT_INT32(c_i32 dataIn) {
     NBTBase nbtBase;
-    nbtBase.data = malloc(sizeof(dataIn));
-    std::memcpy(nbtBase.data, &dataIn, sizeof(dataIn));
+    nbtBase.setPrim(dataIn);
     nbtBase.type = NBT_INT32;
     return nbtBase;
 }
@@ -299,8 +433,7 @@ MU static NBTBase createNBT_INT32(c_i32 dataIn) {
 
 MU static NBTBase createNBT_INT64(const i64 dataIn) {
     NBTBase nbtBase;
-    nbtBase.data = malloc(sizeof(dataIn));
-    std::memcpy(nbtBase.data, &dataIn, sizeof(dataIn));
+    nbtBase.setPrim(dataIn);
     nbtBase.type = NBT_INT64;
     return nbtBase;
 }
@@ -308,8 +441,7 @@ MU static NBTBase createNBT_INT64(const i64 dataIn) {
 
 MU static NBTBase createNBT_FLOAT(const float dataIn) {
     NBTBase nbtBase;
-    nbtBase.data = malloc(sizeof(dataIn));
-    std::memcpy(nbtBase.data, &dataIn, sizeof(dataIn));
+    nbtBase.setPrim(dataIn);
     nbtBase.type = NBT_FLOAT;
     return nbtBase;
 }
@@ -317,8 +449,7 @@ MU static NBTBase createNBT_FLOAT(const float dataIn) {
 
 MU static NBTBase createNBT_DOUBLE(const double dataIn) {
     NBTBase nbtBase;
-    nbtBase.data = malloc(sizeof(dataIn));
-    std::memcpy(nbtBase.data, &dataIn, sizeof(dataIn));
+    nbtBase.setPrim(dataIn);
     nbtBase.type = NBT_DOUBLE;
     return nbtBase;
 }
@@ -357,29 +488,7 @@ MU static NBTBase convertType(NBTBase baseData, NBTType toType) {
 
 
 inline NBTBase* createNewByType(NBTType type) {
-    switch (type) {
-        case NBT_NONE:
-        case NBT_INT8:
-        case NBT_INT16:
-        case NBT_INT32:
-        case NBT_INT64:
-        case NBT_FLOAT:
-        case NBT_DOUBLE:
-        default:
-            return new NBTBase(nullptr, type);
-        case TAG_BYTE_ARRAY:
-            return new NBTBase(new NBTTagByteArray(), type);
-        case TAG_STRING:
-            return new NBTBase(new NBTTagString(), type);
-        case TAG_LIST:
-            return new NBTBase(new NBTTagList(), type);
-        case TAG_COMPOUND:
-            return new NBTBase(new NBTTagCompound(), type);
-        case TAG_INT_ARRAY:
-            return new NBTBase(new NBTTagIntArray(), type);
-        case TAG_LONG_ARRAY:
-            return new NBTBase(new NBTTagLongArray(), type);
-    }
+    return new NBTBase(NBTBase::create(type));
 }
 
 
@@ -387,19 +496,17 @@ MU static void compareNBT(const NBTBase* first, const NBTBase* second) {
     auto* firstNBT = NBTBase::toType<NBTTagCompound>(first)->getCompoundTag("Data");
     auto* secondNBT = NBTBase::toType<NBTTagCompound>(second)->getCompoundTag("Data");
 
-    // Iterate over the keys of firstNBT->tagMap
-    for (const auto& entry : firstNBT->tagMap) {
-        const auto& key = entry.first;
+    // Iterate over the keys of firstNBT
+    for (const std::string_view key : firstNBT->getKeySet()) {
         if (!secondNBT->hasKey(key)) {
-            printf("second does not contain tag '%s'\n", key.c_str());
+            printf("second does not contain tag '%.*s'\n", static_cast<int>(key.size()), key.data());
         }
     }
 
-    // Iterate over the keys of secondNBT->tagMap
-    for (const auto& entry : secondNBT->tagMap) {
-        const auto& key = entry.first;
+    // Iterate over the keys of secondNBT
+    for (const std::string_view key : secondNBT->getKeySet()) {
         if (!firstNBT->hasKey(key)) {
-            printf("first does not contain tag '%s'\n", key.c_str());
+            printf("first does not contain tag '%.*s'\n", static_cast<int>(key.size()), key.data());
         }
     }
 }
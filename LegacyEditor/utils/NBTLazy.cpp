@@ -0,0 +1,247 @@
+#include "NBTLazy.hpp"
+
+#include "LegacyEditor/utils/NBTReader.hpp"
+#include "LegacyEditor/utils/dataManager.hpp"
+#include "LegacyEditor/utils/error_status.hpp"
+
+
+/// Reads a tag header, "theType" is NBT_NONE at the end of a compound.
+static int readHeader(DataManager& theInput, NBTType& theType, std::string_view& theName) {
+    c_u32 left = theInput.size - theInput.getPosition();
+    if (left < 1) {
+        return INVALID_SAVE;
+    }
+    c_u8 type = theInput.readInt8();
+    theType = static_cast<NBTType>(type);
+    if (type == NBT_NONE) {
+        return SUCCESS;
+    }
+    if (type > TAG_LONG_ARRAY || left < 3) {
+        return INVALID_SAVE;
+    }
+    c_u16 length = theInput.readInt16();
+    if (length > left - 3) {
+        return INVALID_SAVE;
+    }
+    theName = std::string_view(reinterpret_cast<const char*>(theInput.ptr), length);
+    theInput.incrementPointer(length);
+    return SUCCESS;
+}
+
+
+int NBTLazyCompound::read(DataManager& theInput) {
+    myBytes.clear();
+    myName = {};
+    myEntries.clear();
+    myArena.reset();
+    myIsModified = false;
+    myIsBig = theInput.isBig;
+
+    c_u8* start = theInput.ptr;
+    NBTType type;
+    std::string_view name;
+    if (c_int status = readHeader(theInput, type, name); status != SUCCESS || type != TAG_COMPOUND) {
+        return INVALID_SAVE;
+    }
+    myName = name;
+
+    while (true) {
+        c_auto offset = static_cast<u32>(theInput.ptr - start);
+        if (c_int status = readHeader(theInput, type, name); status != SUCCESS) {
+            myName = {};
+            myEntries.clear();
+            return status;
+        }
+        if (type == NBT_NONE) {
+            break;
+        }
+        if (c_int status = NBTReader::skip(theInput, type); status != SUCCESS) {
+            myName = {};
+            myEntries.clear();
+            return status;
+        }
+        Entry& entry = myEntries.emplace_back();
+        entry.name = name;
+        entry.type = type;
+        entry.offset = offset;
+        entry.size = static_cast<u32>(theInput.ptr - start) - offset;
+    }
+
+    // the names pointed into the input until now
+    myBytes.assign(start, static_cast<c_u8*>(theInput.ptr));
+    auto rebase = [&](const std::string_view theName) {
+        return std::string_view(reinterpret_cast<const char*>(myBytes.data())
+                                + (reinterpret_cast<c_u8*>(theName.data()) - start), theName.size());
+    };
+    myName = rebase(myName);
+    for (Entry& entry : myEntries) {
+        entry.name = rebase(entry.name);
+    }
+    return SUCCESS;
+}
+
+
+NBTLazyCompound::Entry* NBTLazyCompound::find(const STR theKey) {
+    // a chunk has a handful of tags, so a scan beats hashing them
+    for (Entry& entry : myEntries) {
+        if (entry.name == theKey) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+
+const NBTLazyCompound::Entry* NBTLazyCompound::find(const STR theKey) const {
+    return const_cast<NBTLazyCompound*>(this)->find(theKey);
+}
+
+
+NBTArena* NBTLazyCompound::getArena() {
+    if (myArena == nullptr) {
+        myArena = std::make_unique<NBTArena>();
+    }
+    return myArena.get();
+}
+
+
+/// The bytes were checked by "read", so the value can be read without bounds checks.
+NBTBase NBTLazyCompound::readValue(const Entry& theEntry, NBTArena* theArena) const {
+    DataManager input(const_cast<u8*>(myBytes.data()) + theEntry.offset, theEntry.size, myIsBig);
+    input.incrementPointer(3 + static_cast<u32>(theEntry.name.size()));
+    NBTBase value = NBTBase::create(theEntry.type, theArena);
+    value.read(input, theArena);
+    return value;
+}
+
+
+void NBTLazyCompound::write(DataManager& theOutput) const {
+    c_bool isSameOrder = theOutput.isBig == myIsBig;
+    if (!myIsModified && isSameOrder && !myBytes.empty()) {
+        theOutput.writeBytes(myBytes.data(), static_cast<u32>(myBytes.size()));
+        return;
+    }
+
+    // only needed to turn tags that were never read into the other byte order
+    std::unique_ptr<NBTArena> arena;
+    theOutput.writeInt8(TAG_COMPOUND);
+    theOutput.writeUTF(myName);
+    for (const Entry& entry : myEntries) {
+        if (entry.value.type != NBT_NONE) {
+            NBTTagCompound::writeEntry(entry.name, entry.value, theOutput);
+        } else if (isSameOrder) {
+            theOutput.writeBytes(myBytes.data() + entry.offset, entry.size);
+        } else {
+            if (arena == nullptr) {
+                arena = std::make_unique<NBTArena>(NBTArena::getInitialSize(entry.size));
+            }
+            NBTTagCompound::writeEntry(entry.name, readValue(entry, arena.get()), theOutput);
+        }
+    }
+    theOutput.writeInt8(NBT_NONE);
+}
+
+
+u64 NBTLazyCompound::getWriteSize() const {
+    if (!myIsModified && !myBytes.empty()) {
+        return myBytes.size();
+    }
+
+    // a tag that was never read takes as many bytes in either byte order
+    u64 size = 3 + myName.size() + 1;
+    for (const Entry& entry : myEntries) {
+        size += entry.value.type != NBT_NONE ? NBTTagCompound::getEntrySize(entry.name, entry.value) : entry.size;
+    }
+    return size;
+}
+
+
+NBTBase* NBTLazyCompound::toTree(NBTArena* theArena) const {
+    auto* tree = theArena->create<NBTBase>(NBTBase::create(TAG_COMPOUND, theArena));
+    auto* compound = tree->toType<NBTTagCompound>();
+    for (const Entry& entry : myEntries) {
+        compound->setTag(entry.name, entry.value.type != NBT_NONE
+                                             ? entry.value.copy(theArena)
+                                             : readValue(entry, theArena));
+    }
+    return tree;
+}
+
+
+NBTType NBTLazyCompound::getTagId(const STR theKey) const {
+    const Entry* entry = find(theKey);
+    return entry != nullptr ? entry->type : NBT_NONE;
+}
+
+
+std::vector<std::string_view> NBTLazyCompound::getKeySet() const {
+    std::vector<STR> keySet;
+    keySet.reserve(myEntries.size());
+    for (const Entry& entry : myEntries) {
+        keySet.push_back(entry.name);
+    }
+    return keySet;
+}
+
+
+NBTBase NBTLazyCompound::getTag(const STR theKey) {
+    Entry* entry = find(theKey);
+    if (entry == nullptr) {
+        return {};
+    }
+    if (entry->value.type == NBT_NONE) {
+        entry->value = readValue(*entry, getArena());
+        myIsModified = true;
+    }
+    return entry->value;
+}
+
+
+NBTTagCompound* NBTLazyCompound::getCompoundTag(const STR theKey) {
+    if (getTagId(theKey) != TAG_COMPOUND) {
+        return nullptr;
+    }
+    return getTag(theKey).toType<NBTTagCompound>();
+}
+
+
+NBTTagList* NBTLazyCompound::getListTag(const STR theKey) {
+    if (getTagId(theKey) != TAG_LIST) {
+        return nullptr;
+    }
+    return getTag(theKey).toType<NBTTagList>();
+}
+
+
+void NBTLazyCompound::setTag(const STR theKey, const NBTBase theValue) {
+    // an NBT_NONE entry would end the compound when written
+    if (theValue.type == NBT_NONE) {
+        removeTag(theKey);
+        return;
+    }
+
+    Entry* entry = find(theKey);
+    if (entry == nullptr) {
+        entry = &myEntries.emplace_back();
+        entry->name = NBTKeyPool::intern(theKey);
+    }
+    entry->type = theValue.type;
+    if (theValue.inArena) {
+        entry->value = theValue;
+    } else {
+        entry->value = theValue.copy(getArena());
+        theValue.NbtFree();
+    }
+    myIsModified = true;
+}
+
+
+void NBTLazyCompound::removeTag(const STR theKey) {
+    for (auto iter = myEntries.begin(); iter != myEntries.end(); ++iter) {
+        if (iter->name == theKey) {
+            myEntries.erase(iter);
+            myIsModified = true;
+            return;
+        }
+    }
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include "lce/processor.hpp"
+
+#include "LegacyEditor/utils/NBT.hpp"
+
+
+class DataManager;
+
+
+/**
+ * A compound that is kept as the bytes it was read from, with one entry per tag
+ * that points at where the tag is stored; the entries are found in a single pass
+ * with NBTReader::skip, so no tree is built until a tag is asked for.
+ * \n\n
+ * getTag reads only the asked for tag, into an arena owned by the compound.
+ * write copies every tag that was never read or replaced straight out of the
+ * original bytes, and the whole compound at once if none were.
+ * \n\n
+ * A tag that getTag returned is written from its tree, as the caller may have edited it.
+ */
+class NBTLazyCompound {
+    typedef std::string_view STR;
+
+    struct Entry {
+        /// points into "myBytes", or into NBTKeyPool for tags added with setTag
+        STR name;
+        NBTType type = NBT_NONE;
+        /// where the tag starts in "myBytes", and its size with the header
+        u32 offset = 0;
+        u32 size = 0;
+        /// the read or set tag; NBT_NONE while it is still only the bytes at "offset"
+        NBTBase value;
+    };
+
+    u8_vec myBytes;
+    /// the name of the compound itself
+    STR myName;
+    std::vector<Entry> myEntries;
+    std::unique_ptr<NBTArena> myArena;
+    bool myIsBig = true;
+    bool myIsModified = false;
+
+    ND Entry* find(STR theKey);
+    ND const Entry* find(STR theKey) const;
+    ND NBTArena* getArena();
+    ND NBTBase readValue(const Entry& theEntry, NBTArena* theArena) const;
+
+public:
+    NBTLazyCompound() = default;
+    NBTLazyCompound(const NBTLazyCompound&) = delete;
+    NBTLazyCompound& operator=(const NBTLazyCompound&) = delete;
+
+    /**
+     * Indexes the named compound tag at the position of "theInput", and keeps a copy of its bytes.
+     * The input is left after it.
+     * @return SUCCESS; INVALID_SAVE if it is not a compound or is cut off or corrupt, the compound is then empty
+     */
+    ND int read(DataManager& theInput);
+
+    /// Writes it as the named tag it was read as.
+    void write(DataManager& theOutput) const;
+    /// How many bytes "write" stores, in either byte order.
+    ND u64 getWriteSize() const;
+
+    /// Reads every tag into a compound allocated in "theArena", as NBT::readTag would have.
+    ND NBTBase* toTree(NBTArena* theArena) const;
+
+    ND bool hasKey(STR theKey) const { return find(theKey) != nullptr; }
+    ND NBTType getTagId(STR theKey) const;
+    ND int getSize() const { return static_cast<int>(myEntries.size()); }
+    ND std::vector<STR> getKeySet() const;
+
+    /// Reads the tag on first use; NBT_NONE if there is none. It is freed along with the compound.
+    ND NBTBase getTag(STR theKey);
+    ND NBTTagCompound* getCompoundTag(STR theKey);
+    ND NBTTagList* getListTag(STR theKey);
+
+    /// Like NBTTagCompound::setTag, a tag that is not in an arena is moved into the compound's.
+    void setTag(STR theKey, NBTBase theValue);
+    void removeTag(STR theKey);
+
+    /// Whether any tag was read, set or removed since "read".
+    ND bool isModified() const { return myIsModified; }
+    /// The size of the bytes it was read from.
+    ND size_t getEncodedSize() const { return myBytes.size(); }
+};
@@ -0,0 +1,303 @@
+#include "NBTReader.hpp"
+
+#include "LegacyEditor/utils/dataManager.hpp"
+#include "LegacyEditor/utils/error_status.hpp"
+
+
+namespace {
+
+    /// How many bytes a value of "theType" takes, or 0 if it stores its own length.
+    u32 getFixedSize(const NBTType theType) {
+        switch (theType) {
+            case NBT_INT8:
+                return 1;
+            case NBT_INT16:
+                return 2;
+            case NBT_INT32:
+            case NBT_FLOAT:
+                return 4;
+            case NBT_INT64:
+            case NBT_DOUBLE:
+                return 8;
+            default:
+                return 0;
+        }
+    }
+
+
+    /// How many bytes an element of an array of "theType" takes.
+    u32 getArrayElementSize(const NBTType theType) {
+        switch (theType) {
+            case TAG_INT_ARRAY:
+                return 4;
+            case TAG_LONG_ARRAY:
+                return 8;
+            default:
+                return 1;
+        }
+    }
+
+
+    bool isKnownType(c_u8 theType) {
+        return theType >= NBT_INT8 && theType <= TAG_LONG_ARRAY;
+    }
+
+
+    /// Walks one value, visiting it or only stepping over it.
+    class Walker {
+        DataManager& myInput;
+        NBTVisitor* myVisitor;
+        bool myIsStopped = false;
+
+        ND bool canRead(c_u64 theSize) const {
+            return theSize <= myInput.size - myInput.getPosition();
+        }
+
+        /// Notes a STOP, so that every level returns.
+        NBTVisit check(const NBTVisit theResult) {
+            if (theResult == NBTVisit::STOP) {
+                myIsStopped = true;
+            }
+            return theResult;
+        }
+
+        ND int walkPrimitive(NBTType theType, bool theVisit);
+        ND int walkList(u32 theDepth, bool theVisit);
+        ND int walkCompound(u32 theDepth, bool theVisit);
+
+    public:
+        Walker(DataManager& theInput, NBTVisitor* theVisitor) : myInput(theInput), myVisitor(theVisitor) {}
+
+        /// Reads a tag header; "theType" is NBT_NONE at the end of a compound.
+        ND int readHeader(NBTType& theType, std::string_view& theName) {
+            if (!canRead(1)) {
+                return INVALID_SAVE;
+            }
+            c_u8 type = myInput.readInt8();
+            theType = static_cast<NBTType>(type);
+            if (type == NBT_NONE) {
+                return SUCCESS;
+            }
+            if (!isKnownType(type) || !canRead(2)) {
+                return INVALID_SAVE;
+            }
+            c_u16 length = myInput.readInt16();
+            if (!canRead(length)) {
+                return INVALID_SAVE;
+            }
+            theName = std::string_view(reinterpret_cast<const char*>(myInput.ptr), length);
+            myInput.incrementPointer(length);
+            return SUCCESS;
+        }
+
+        ND int walk(const NBTType theType, c_u32 theDepth, c_bool theVisit) {
+            if (theDepth > NBTReader::MAX_DEPTH) {
+                return INVALID_SAVE;
+            }
+
+            switch (theType) {
+                case NBT_INT8:
+                case NBT_INT16:
+                case NBT_INT32:
+                case NBT_INT64:
+                case NBT_FLOAT:
+                case NBT_DOUBLE:
+                    return walkPrimitive(theType, theVisit);
+
+                case TAG_BYTE_ARRAY:
+                case TAG_INT_ARRAY:
+                case TAG_LONG_ARRAY: {
+                    if (!canRead(4)) {
+                        return INVALID_SAVE;
+                    }
+                    c_auto count = static_cast<i32>(myInput.readInt32());
+                    c_u64 size = static_cast<u64>(count) * getArrayElementSize(theType);
+                    if (count < 0 || !canRead(size)) {
+                        return INVALID_SAVE;
+                    }
+                    if (theVisit) {
+                        check(myVisitor->visitArray(theType, myInput.ptr, static_cast<u32>(count)));
+                    }
+                    myInput.incrementPointer(static_cast<u32>(size));
+                    return SUCCESS;
+                }
+
+                case TAG_STRING: {
+                    if (!canRead(2)) {
+                        return INVALID_SAVE;
+                    }
+                    c_u16 length = myInput.readInt16();
+                    if (!canRead(length)) {
+                        return INVALID_SAVE;
+                    }
+                    if (theVisit) {
+                        check(myVisitor->visitString(
+                                std::string_view(reinterpret_cast<const char*>(myInput.ptr), length)));
+                    }
+                    myInput.incrementPointer(length);
+                    return SUCCESS;
+                }
+
+                case TAG_LIST:
+                    return walkList(theDepth, theVisit);
+
+                case TAG_COMPOUND:
+                    return walkCompound(theDepth, theVisit);
+
+                default:
+                    return INVALID_SAVE;
+            }
+        }
+    };
+
+
+    int Walker::walkPrimitive(const NBTType theType, c_bool theVisit) {
+        c_u32 size = getFixedSize(theType);
+        if (!canRead(size)) {
+            return INVALID_SAVE;
+        }
+        if (!theVisit) {
+            myInput.incrementPointer(size);
+            return SUCCESS;
+        }
+
+        NBTBase value;
+        value.type = theType;
+        switch (theType) {
+            case NBT_INT8:
+                value.setPrim(static_cast<u8>(myInput.readInt8()));
+                break;
+            case NBT_INT16:
+                value.setPrim(static_cast<i16>(myInput.readInt16()));
+                break;
+            case NBT_INT32:
+                value.setPrim(static_cast<i32>(myInput.readInt32()));
+                break;
+            case NBT_INT64:
+                value.setPrim(static_cast<i64>(myInput.readInt64()));
+                break;
+            case NBT_FLOAT:
+                value.setPrim(myInput.readFloat());
+                break;
+            default:
+                value.setPrim(myInput.readDouble());
+                break;
+        }
+        check(myVisitor->visitPrimitive(value));
+        return SUCCESS;
+    }
+
+
+    int Walker::walkList(c_u32 theDepth, c_bool theVisit) {
+        if (!canRead(5)) {
+            return INVALID_SAVE;
+        }
+        c_u8 type = myInput.readInt8();
+        c_auto count = static_cast<i32>(myInput.readInt32());
+        // like NBTBase::read, an empty list has no type
+        const NBTType elementType = count > 0 ? static_cast<NBTType>(type) : NBT_NONE;
+        c_u32 elementCount = count > 0 ? static_cast<u32>(count) : 0;
+        if (elementCount != 0 && !isKnownType(type)) {
+            return INVALID_SAVE;
+        }
+
+        bool visitElements = theVisit;
+        if (theVisit) {
+            const NBTVisit result = check(myVisitor->beginList(elementType, elementCount));
+            if (result == NBTVisit::STOP) {
+                return SUCCESS;
+            }
+            visitElements = result != NBTVisit::SKIP;
+        }
+
+        // a list of fixed size values can be stepped over at once
+        if (c_u32 fixedSize = getFixedSize(elementType); fixedSize != 0 && !visitElements) {
+            c_u64 size = static_cast<u64>(elementCount) * fixedSize;
+            if (!canRead(size)) {
+                return INVALID_SAVE;
+            }
+            myInput.incrementPointer(static_cast<u32>(size));
+            return SUCCESS;
+        }
+
+        for (u32 index = 0; index < elementCount; index++) {
+            if (c_int status = walk(elementType, theDepth + 1, visitElements); status != SUCCESS) {
+                return status;
+            }
+            if (myIsStopped) {
+                return SUCCESS;
+            }
+        }
+
+        if (visitElements) {
+            check(myVisitor->endList());
+        }
+        return SUCCESS;
+    }
+
+
+    int Walker::walkCompound(c_u32 theDepth, c_bool theVisit) {
+        bool visitTags = theVisit;
+        if (theVisit) {
+            const NBTVisit result = check(myVisitor->beginCompound());
+            if (result == NBTVisit::STOP) {
+                return SUCCESS;
+            }
+            visitTags = result != NBTVisit::SKIP;
+        }
+
+        while (true) {
+            NBTType type;
+            std::string_view name;
+            if (c_int status = readHeader(type, name); status != SUCCESS) {
+                return status;
+            }
+            if (type == NBT_NONE) {
+                break;
+            }
+
+            bool visitValue = visitTags;
+            if (visitTags) {
+                const NBTVisit result = check(myVisitor->visitTag(type, name));
+                if (result == NBTVisit::STOP) {
+                    return SUCCESS;
+                }
+                visitValue = result != NBTVisit::SKIP;
+            }
+            if (c_int status = walk(type, theDepth + 1, visitValue); status != SUCCESS) {
+                return status;
+            }
+            if (myIsStopped) {
+                return SUCCESS;
+            }
+        }
+
+        if (visitTags) {
+            check(myVisitor->endCompound());
+        }
+        return SUCCESS;
+    }
+
+}
+
+
+int NBTReader::read(DataManager& theInput, NBTVisitor& theVisitor) {
+    Walker walker(theInput, &theVisitor);
+    NBTType type;
+    std::string_view name;
+    if (c_int status = walker.readHeader(type, name); status != SUCCESS || type == NBT_NONE) {
+        return status;
+    }
+
+    const NBTVisit result = theVisitor.visitTag(type, name);
+    if (result == NBTVisit::STOP) {
+        return SUCCESS;
+    }
+    return walker.walk(type, 0, result != NBTVisit::SKIP);
+}
+
+
+int NBTReader::skip(DataManager& theInput, const NBTType theType) {
+    Walker walker(theInput, nullptr);
+    return walker.walk(theType, 0, false);
+}
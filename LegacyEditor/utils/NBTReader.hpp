@@ -0,0 +1,77 @@
+#pragma once
+
+#include <string_view>
+
+#include "lce/processor.hpp"
+
+#include "LegacyEditor/utils/NBT.hpp"
+
+
+class DataManager;
+
+
+/// What NBTReader does after a visitor returns.
+enum class NBTVisit : u8 {
+    /// keep reading
+    CONTINUE,
+    /// step over the value that was just started without visiting it
+    SKIP,
+    /// stop reading, NBTReader::read returns right away
+    STOP,
+};
+
+
+/**
+ * Receives the tags that NBTReader reads, in the order they are stored.
+ * \n\n
+ * Every method does nothing by default, so a visitor only overrides what it looks at.
+ * Names, strings and arrays point into the buffer that is being read, and are only valid as long as it is.
+ */
+class NBTVisitor {
+public:
+    virtual ~NBTVisitor() = default;
+
+    /// A tag of a compound, or the root tag, is about to be read; SKIP steps over its value.
+    virtual NBTVisit visitTag(MU NBTType theType, MU std::string_view theName) { return NBTVisit::CONTINUE; }
+
+    /// NBT_INT8 to NBT_DOUBLE, read them with NBTBase::getPrim or NBTBase::toPrim.
+    virtual NBTVisit visitPrimitive(MU NBTBase theValue) { return NBTVisit::CONTINUE; }
+
+    virtual NBTVisit visitString(MU std::string_view theValue) { return NBTVisit::CONTINUE; }
+
+    /// Byte, int and long arrays; the elements are left in the byte order of the save.
+    virtual NBTVisit visitArray(MU NBTType theType, MU c_u8* theData, MU u32 theCount) { return NBTVisit::CONTINUE; }
+
+    /// SKIP steps over the whole compound, endCompound is then not called.
+    virtual NBTVisit beginCompound() { return NBTVisit::CONTINUE; }
+    virtual NBTVisit endCompound() { return NBTVisit::CONTINUE; }
+
+    /// SKIP steps over the whole list, endList is then not called.
+    virtual NBTVisit beginList(MU NBTType theElementType, MU u32 theCount) { return NBTVisit::CONTINUE; }
+    virtual NBTVisit endList() { return NBTVisit::CONTINUE; }
+};
+
+
+/**
+ * Reads NBT straight out of its encoded bytes and hands each tag to an NBTVisitor,
+ * without building a tree or allocating anything.
+ * \n\n
+ * NBT does not store how long a compound or list is, so a skipped one is still walked,
+ * but only its tag headers are looked at; primitives, strings and arrays are jumped over.
+ * Every read is checked against the end of the buffer, so corrupt data stops with an error.
+ */
+class NBTReader {
+public:
+    /// how deep compounds and lists may be nested before the data is treated as corrupt
+    static constexpr u32 MAX_DEPTH = 512;
+
+    /**
+     * Reads one named tag and everything inside it, as NBT::readTag does.
+     * The input is left after it, or where the visitor stopped.
+     * @return SUCCESS, also when the visitor stops early; INVALID_SAVE if the tag is cut off or corrupt
+     */
+    ND static int read(DataManager& theInput, NBTVisitor& theVisitor);
+
+    /// Steps over a value of "theType", see read.
+    ND static int skip(DataManager& theInput, NBTType theType);
+};
@@ -1,68 +1,95 @@
 #pragma once
 
+#include <algorithm>
+#include <cstring>
+
 #include "lce/processor.hpp"
 
-#include "LegacyEditor/utils/dataManager.hpp"
+#include "LegacyEditor/utils/RLE/rle_scan.hpp"
 
 
+/**
+ * Chunk RLE: 255 is the escape byte, followed by (count - 1) and, for runs of 4 or more, the value.
+ * Literal spans are copied and runs are filled in bulk, and nothing is written past "sizeOut".
+ * @param sizeOut the size of the buffer_out, set to the decompressed size
+ */
 static void RLE_decompress(u8* dataIn, c_u32 sizeIn, u8* dataOut, u32& sizeOut) {
-    DataManager managerIn(dataIn, sizeIn);
-    DataManager managerOut(dataOut, sizeOut);
+    c_u8* in = dataIn;
+    c_u8* inEnd = dataIn + sizeIn;
+    u8* out = dataOut;
+    u8* outEnd = dataOut + sizeOut;
 
-    while (managerIn.getPosition() < sizeIn) {
-        if (c_u8 byte1 = managerIn.readInt8(); byte1 != 255) {
-            managerOut.writeInt8(byte1);
-        } else {
-            c_u8 byte2 = managerIn.readInt8();
-            u8 value = 255;
-            if (byte2 >= 3) {
-                value = managerIn.readInt8();
-            }
-            for (int j = 0; j <= static_cast<int>(byte2); j++) {
-                managerOut.writeInt8(value);
+    while (in < inEnd) {
+        c_u32 literals = std::min(RLE_countUntil(in, inEnd - in, 255), static_cast<u32>(outEnd - out));
+        std::memcpy(out, in, literals);
+        in += literals;
+        out += literals;
+
+        if (in == inEnd || out == outEnd || inEnd - in < 2) {
+            break;
+        }
+
+        c_u32 count = in[1] + 1;
+        u8 value = 255;
+        in += 2;
+        if (count > 3) {
+            if (in == inEnd) {
+                break;
             }
+            value = *in++;
         }
+
+        c_u32 run = std::min(count, static_cast<u32>(outEnd - out));
+        std::memset(out, value, run);
+        out += run;
     }
-    sizeOut = managerOut.getPosition();
+    sizeOut = out - dataOut;
 }
 
 
+/**
+ * The inverse of RLE_decompress; runs are at most 256 bytes.
+ * The output can be up to twice as large as the input.
+ * @param sizeOut the size of the buffer_out, set to the compressed size, or 0 if it did not fit
+ */
 static void RLE_compress(c_u8* dataIn, c_u32 sizeIn, u8* dataOut, u32& sizeOut) {
+    c_u32 capacity = sizeOut;
     u32 dataIndex = 0;
     sizeOut = 0;
 
     while (dataIndex < sizeIn) {
-        c_u8 value = dataIn[dataIndex];
-        u32 count = 1;
+        // bytes that are not 255 and do not start a run are written as they are
+        if (c_u32 literals = RLE_countLiterals(dataIn + dataIndex, sizeIn - dataIndex); literals != 0) {
+            if (sizeOut + literals > capacity) {
+                sizeOut = 0;
+                return;
+            }
+            std::memcpy(dataOut + sizeOut, dataIn + dataIndex, literals);
+            sizeOut += literals;
+            dataIndex += literals;
+            continue;
+        }
 
-        // Count the run of the same byte
-        while (dataIndex + count < sizeIn && dataIn[dataIndex + count] == value && count < 256) {
-            count++;
+        c_u8 value = dataIn[dataIndex];
+        c_u32 count = RLE_countRun(dataIn + dataIndex, std::min(sizeIn - dataIndex, 256U), value);
+        if (sizeOut + 3 > capacity) {
+            sizeOut = 0;
+            return;
         }
 
-        if (value == 255) {
-            if (count < 4) {
-                dataOut[sizeOut++] = 255;
-                dataOut[sizeOut++] = count - 1;
-            } else {
-                dataOut[sizeOut++] = 255;
-                dataOut[sizeOut++] = count - 1;
+        if (count >= 4 || value == 255) {
+            dataOut[sizeOut++] = 255;
+            dataOut[sizeOut++] = count - 1;
+            if (count >= 4) {
                 dataOut[sizeOut++] = value;
             }
         } else {
-            if (count >= 4) {
-                // If run length is 4 or more, encode it
-                dataOut[sizeOut++] = 255;
-                dataOut[sizeOut++] = count - 1;
+            // a run of 2 or 3 is cheaper to write as it is
+            for (u32 i = 0; i < count; ++i) {
                 dataOut[sizeOut++] = value;
-            } else {
-                // Else write the bytes directly
-                for (u32 i = 0; i < count; ++i) {
-                    dataOut[sizeOut++] = value;
-                }
             }
         }
 
         dataIndex += count;
     }
-}
\ No newline at end of file
+}
@@ -1,83 +1,101 @@
 #pragma once
 
+#include <algorithm>
 #include <cstring>
 
 #include "lce/processor.hpp"
 
-#include "LegacyEditor/utils/dataManager.hpp"
+#include "LegacyEditor/utils/RLE/rle_scan.hpp"
 
 
 /**
  * A form of RLE decompression.
+ * Nothing is written past "sizeOut".
  *
  * @param dataIn buffer_in to parseLayer from
  * @param sizeIn buffer_in size
  * @param dataOut a pointer to allocated buffer_out
  * @param sizeOut the size of the allocated buffer_out
+ * @return the decompressed size
  */
 static u32 RLE_NSX_OR_PS4_DECOMPRESS(u8* dataIn, c_u32 sizeIn, u8* dataOut, c_u32 sizeOut) {
-    DataManager managerIn(dataIn, sizeIn);
-    DataManager managerOut(dataOut, sizeOut);
-
-    while (managerIn.getPosition() < sizeIn) {
-
-        if (c_u8 value = managerIn.readInt8(); value != 0x00) {
-            managerOut.writeInt8(value);
-
-        } else {
-            int numZeros = managerIn.readInt8();
+    c_u8* in = dataIn;
+    c_u8* inEnd = dataIn + sizeIn;
+    u8* out = dataOut;
+    u8* outEnd = dataOut + sizeOut;
+
+    while (in < inEnd) {
+        c_u32 literals = std::min(RLE_countUntil(in, inEnd - in, 0), static_cast<u32>(outEnd - out));
+        std::memcpy(out, in, literals);
+        in += literals;
+        out += literals;
+
+        if (in == inEnd || out == outEnd || inEnd - in < 2) {
+            break;
+        }
 
-            if (numZeros == 0) {
-                c_int numZeros1 = managerIn.readInt8();
-                c_int numZeros2 = managerIn.readInt8();
-                numZeros = numZeros1 << 8 | numZeros2;
-                numZeros += 256;
+        u32 numZeros = in[1];
+        in += 2;
+        if (numZeros == 0) {
+            // 0, 0, (count - 256) as a big endian u16
+            if (inEnd - in < 2) {
+                break;
             }
-
-            memset(managerOut.ptr, 0, numZeros);
-            managerOut.incrementPointer(numZeros);
+            numZeros = (in[0] << 8 | in[1]) + 256;
+            in += 2;
         }
+
+        numZeros = std::min(numZeros, static_cast<u32>(outEnd - out));
+        std::memset(out, 0, numZeros);
+        out += numZeros;
     }
-    return managerOut.getPosition();
+    return out - dataOut;
 }
 
 
 /**
  * A form of RLE compression.
+ * The output can be up to twice as large as the input.
  *
  * @param dataIn buffer_in to parseLayer from
  * @param sizeIn buffer_in size
  * @param dataOut a pointer to allocated buffer_out
  * @param sizeOut the size of the allocated buffer_out
+ * @return the compressed size, or 0 if it did not fit
  */
-static u32 RLE_NSXPS4_COMPRESS(c_u8* dataIn, c_u32 sizeIn, u8* dataOut, u32 sizeOut) {
+static u32 RLE_NSXPS4_COMPRESS(c_u8* dataIn, c_u32 sizeIn, u8* dataOut, c_u32 sizeOut) {
+    static constexpr u32 MAX_RUN = 0xFFFF + 256;
     u32 dataIndex = 0;
-    sizeOut = 0;
+    u32 outIndex = 0;
 
     while (dataIndex < sizeIn) {
-        if (c_u8 value = dataIn[dataIndex]; value != 0) {
-            dataOut[sizeOut++] = value;
-            continue;
+        c_u32 literals = RLE_countUntil(dataIn + dataIndex, sizeIn - dataIndex, 0);
+        if (outIndex + literals > sizeOut) {
+            return 0;
+        }
+        std::memcpy(dataOut + outIndex, dataIn + dataIndex, literals);
+        outIndex += literals;
+        dataIndex += literals;
+        if (dataIndex == sizeIn) {
+            break;
         }
 
-        u32 runCount = 1;
-        while (dataIndex + runCount < sizeIn && dataIn[dataIndex + runCount] == 0) {
-            runCount++;
+        c_u32 runCount = RLE_countRun(dataIn + dataIndex, std::min(sizeIn - dataIndex, MAX_RUN), 0);
+        if (outIndex + 4 > sizeOut) {
+            return 0;
         }
 
         if (runCount < 256) {
-            dataOut[sizeOut++] = 0;
-            dataOut[sizeOut++] = runCount;
+            dataOut[outIndex++] = 0;
+            dataOut[outIndex++] = runCount;
         } else {
-            dataOut[sizeOut++] = 0;
-            dataOut[sizeOut++] = 0;
-            dataOut[sizeOut++] = (runCount >> 8) - 1;
-            dataOut[sizeOut++] = runCount & 255;
+            dataOut[outIndex++] = 0;
+            dataOut[outIndex++] = 0;
+            dataOut[outIndex++] = (runCount - 256) >> 8;
+            dataOut[outIndex++] = (runCount - 256) & 255;
         }
 
         dataIndex += runCount;
     }
-    return sizeOut;
+    return outIndex;
 }
-
-
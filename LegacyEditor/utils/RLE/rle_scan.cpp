@@ -0,0 +1,183 @@
+#include "rle_scan.hpp"
+
+#include <cstring>
+
+#include "LegacyEditor/utils/cpuFeatures.hpp"
+
+
+// #####################################################
+// #               Scalar
+// #####################################################
+
+
+static u32 countRunScalar(c_u8* ptr, c_u32 maxCount, c_u8 value) {
+    u32 count = 0;
+    while (count < maxCount && ptr[count] == value) {
+        count++;
+    }
+    return count;
+}
+
+
+static u32 countLiteralsScalar(c_u8* ptr, c_u32 maxCount, u32 count = 0) {
+    for (; count < maxCount; count++) {
+        if (ptr[count] == 255) {
+            break;
+        }
+        if (count + 1 < maxCount && ptr[count] == ptr[count + 1]) {
+            break;
+        }
+    }
+    return count;
+}
+
+
+#ifdef CPU_X86
+
+
+static u32 firstSetBit(c_u32 mask) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return index;
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+
+// #####################################################
+// #               SSE2
+// #####################################################
+
+
+static u32 countRunSSE2(c_u8* ptr, c_u32 maxCount, c_u8 value) {
+    const __m128i target = _mm_set1_epi8(static_cast<char>(value));
+    u32 count = 0;
+    for (; count + 16 <= maxCount; count += 16) {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr + count));
+        if (c_u32 mask = ~_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, target)) & 0xFFFF; mask != 0) {
+            return count + firstSetBit(mask);
+        }
+    }
+    return count + countRunScalar(ptr + count, maxCount - count, value);
+}
+
+
+static u32 countLiteralsSSE2(c_u8* ptr, c_u32 maxCount) {
+    const __m128i escape = _mm_set1_epi8(static_cast<char>(255));
+    u32 count = 0;
+    // each byte is compared with the next one, so the last byte is left to the scalar loop
+    for (; count + 17 <= maxCount; count += 16) {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr + count));
+        const __m128i next = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr + count + 1));
+        const __m128i stop = _mm_or_si128(_mm_cmpeq_epi8(bytes, escape), _mm_cmpeq_epi8(bytes, next));
+        if (c_u32 mask = _mm_movemask_epi8(stop); mask != 0) {
+            return count + firstSetBit(mask);
+        }
+    }
+    return countLiteralsScalar(ptr, maxCount, count);
+}
+
+
+// #####################################################
+// #               AVX2
+// #####################################################
+
+
+CPU_TARGET_AVX2 static u32 countRunAVX2(c_u8* ptr, c_u32 maxCount, c_u8 value) {
+    const __m256i target = _mm256_set1_epi8(static_cast<char>(value));
+    u32 count = 0;
+    for (; count + 32 <= maxCount; count += 32) {
+        const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr + count));
+        c_u32 mask = ~static_cast<u32>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, target)));
+        if (mask != 0) {
+            return count + firstSetBit(mask);
+        }
+    }
+    return count + countRunScalar(ptr + count, maxCount - count, value);
+}
+
+
+#endif
+
+
+// #####################################################
+// #               Dispatch
+// #####################################################
+
+
+static RLE_SIMD getBestSimd() {
+#ifdef CPU_X86
+    return cpu::hasAVX2() ? RLE_SIMD::AVX2 : RLE_SIMD::SSE2;
+#else
+    return RLE_SIMD::SCALAR;
+#endif
+}
+
+
+static RLE_SIMD& currentSimd() {
+    static RLE_SIMD level = getBestSimd();
+    return level;
+}
+
+
+MU ND RLE_SIMD RLE_getSimd() {
+    return currentSimd();
+}
+
+
+MU void RLE_setSimd(const RLE_SIMD level) {
+    static const RLE_SIMD best = getBestSimd();
+    currentSimd() = level < best ? level : best;
+}
+
+
+MU ND const char* RLE_getSimdName(const RLE_SIMD level) {
+    switch (level) {
+        case RLE_SIMD::AVX2: return "avx2";
+        case RLE_SIMD::SSE2: return "sse2";
+        case RLE_SIMD::SCALAR:
+        default: return "scalar";
+    }
+}
+
+
+ND u32 RLE_countRun(c_u8* ptr, c_u32 maxCount, c_u8 value) {
+    switch (currentSimd()) {
+#ifdef CPU_X86
+        case RLE_SIMD::AVX2: {
+            // most runs are short; only switch to the wide loop once a run is long
+            static constexpr u32 SHORT_RUN = 64;
+            if (maxCount <= SHORT_RUN) {
+                return countRunSSE2(ptr, maxCount, value);
+            }
+            if (c_u32 count = countRunSSE2(ptr, SHORT_RUN, value); count < SHORT_RUN) {
+                return count;
+            }
+            return SHORT_RUN + countRunAVX2(ptr + SHORT_RUN, maxCount - SHORT_RUN, value);
+        }
+        case RLE_SIMD::SSE2: return countRunSSE2(ptr, maxCount, value);
+#endif
+        default: return countRunScalar(ptr, maxCount, value);
+    }
+}
+
+
+ND u32 RLE_countUntil(c_u8* ptr, c_u32 maxCount, c_u8 value) {
+    // memchr is already vectorized (and dispatched at runtime) by every libc we build with
+    c_auto* found = static_cast<c_u8*>(std::memchr(ptr, value, maxCount));
+    return found == nullptr ? maxCount : static_cast<u32>(found - ptr);
+}
+
+
+ND u32 RLE_countLiterals(c_u8* ptr, c_u32 maxCount) {
+    switch (currentSimd()) {
+#ifdef CPU_X86
+        // literal spans are short, a 32 byte loop was measured to be slower here
+        case RLE_SIMD::AVX2:
+        case RLE_SIMD::SSE2: return countLiteralsSSE2(ptr, maxCount);
+#endif
+        default: return countLiteralsScalar(ptr, maxCount);
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "lce/processor.hpp"
+
+
+/**
+ * Byte scanners shared by the RLE codecs.
+ * \n\n
+ * They look at 16 (SSE2) or 32 (AVX2) bytes per step; the widest one the cpu
+ * supports is picked the first time one is called, with a scalar fallback
+ * for everything that is not x86.
+ */
+enum class RLE_SIMD : u8 {
+    SCALAR,
+    SSE2,
+    AVX2,
+};
+
+
+MU ND RLE_SIMD RLE_getSimd();
+
+/// Used by benchmarks; levels the cpu does not support fall back to the best one it does.
+/// Not thread safe, call it before any RLE function runs.
+MU void RLE_setSimd(RLE_SIMD level);
+
+MU ND const char* RLE_getSimdName(RLE_SIMD level);
+
+
+/// Counts the bytes from "ptr" that equal "value", looking at most "maxCount" bytes.
+ND u32 RLE_countRun(c_u8* ptr, u32 maxCount, u8 value);
+
+/// Counts the bytes from "ptr" before the first one that equals "value", or "maxCount".
+ND u32 RLE_countUntil(c_u8* ptr, u32 maxCount, u8 value);
+
+/**
+ * Counts the bytes from "ptr" that RLE_compress writes as-is: ones that are not 255
+ * and are not followed by the same byte. Looks at most "maxCount" bytes.
+ */
+ND u32 RLE_countLiterals(c_u8* ptr, u32 maxCount);
@@ -1,71 +1,79 @@
 #pragma once
 
+#include <algorithm>
 #include <cstring>
 
 #include "lce/processor.hpp"
 
-#include "LegacyEditor/utils/dataManager.hpp"
+#include "LegacyEditor/utils/RLE/rle_scan.hpp"
 
 
+/**
+ * Zero RLE: a 0 is followed by how many zeros it stands for.
+ * Nothing is written past "sizeOut".
+ * @return the decompressed size
+ */
 static u32 RLEVITA_DECOMPRESS(u8* dataIn, c_u32 sizeIn, u8* dataOut, c_u32 sizeOut) {
-    DataManager managerIn(dataIn, sizeIn);
-    DataManager managerOut(dataOut, sizeOut);
+    c_u8* in = dataIn;
+    c_u8* inEnd = dataIn + sizeIn;
+    u8* out = dataOut;
+    u8* outEnd = dataOut + sizeOut;
 
-    while (managerIn.getPosition() < sizeIn) {
+    while (in < inEnd) {
+        c_u32 literals = std::min(RLE_countUntil(in, inEnd - in, 0), static_cast<u32>(outEnd - out));
+        std::memcpy(out, in, literals);
+        in += literals;
+        out += literals;
 
-        if (c_u8 value = managerIn.readInt8(); value != 0x00) {
-            managerOut.writeInt8(value);
-        } else {
-            c_int numZeros = managerIn.readInt8();
-            memset(managerOut.ptr, 0, numZeros);
-            managerOut.incrementPointer(numZeros);
+        if (in == inEnd || out == outEnd || inEnd - in < 2) {
+            break;
         }
+
+        c_u32 numZeros = std::min(static_cast<u32>(in[1]), static_cast<u32>(outEnd - out));
+        in += 2;
+        std::memset(out, 0, numZeros);
+        out += numZeros;
     }
-    return managerOut.getPosition();
+    return out - dataOut;
 }
 
 
 /**
  * Technically regular RLE compression.
+ * The output can be up to twice as large as the input.
  *
  * @param dataIn buffer_in to parseLayer from
  * @param sizeIn buffer_in size
  * @param dataOut a pointer to allocated buffer_out
  * @param sizeOut the size of the allocated buffer_out
+ * @return the compressed size, or 0 if it did not fit
  */
 static u32 RLEVITA_COMPRESS(u8* dataIn, c_u32 sizeIn, u8* dataOut, c_u32 sizeOut) {
-    if (sizeOut < 2) {
-        return 0;
-    }
-
-    DataManager managerIn(dataIn, sizeIn);
-    DataManager managerOut(dataOut, sizeOut);
+    u32 dataIndex = 0;
+    u32 outIndex = 0;
 
-    u8 zeroCount = 0;
-
-    for (u32 i = 0; i < sizeIn; ++i) {
+    while (dataIndex < sizeIn) {
+        c_u32 literals = RLE_countUntil(dataIn + dataIndex, sizeIn - dataIndex, 0);
+        if (outIndex + literals > sizeOut) {
+            return 0;
+        }
+        std::memcpy(dataOut + outIndex, dataIn + dataIndex, literals);
+        outIndex += literals;
+        dataIndex += literals;
 
-        if (c_u8 value = managerIn.readInt8(); value != 0) {
-            if (zeroCount > 0) {
-                managerOut.writeInt8(0);
-                managerOut.writeInt8(zeroCount);
-                zeroCount = 0;
-            }
-            managerOut.writeInt8(value);
-        } else {
-            zeroCount++;
-            if (zeroCount == 255 || i == sizeIn - 1) {
-                managerOut.writeInt8(0);
-                managerOut.writeInt8(zeroCount);
-                zeroCount = 0;
+        // a run longer than 255 zeros is split into several
+        u32 zeroCount = RLE_countRun(dataIn + dataIndex, sizeIn - dataIndex, 0);
+        dataIndex += zeroCount;
+        while (zeroCount != 0) {
+            if (outIndex + 2 > sizeOut) {
+                return 0;
             }
+            c_u32 count = std::min(zeroCount, 255U);
+            dataOut[outIndex++] = 0;
+            dataOut[outIndex++] = count;
+            zeroCount -= count;
         }
     }
 
-    if (zeroCount > 0) {
-        managerOut.writeInt8(0);
-        managerOut.writeInt8(zeroCount);
-    }
-
-    return managerOut.getPosition();
+    return outIndex;
 }
@@ -0,0 +1,99 @@
+#include "XDecompress.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <new>
+
+#include "include/lzx/lzx.h"
+
+
+XmemDecoder::XmemDecoder() {
+    myState = lzx_init(WINDOW_BITS);
+    myInput = new(std::nothrow) u8[MAX_INPUT_SIZE + INPUT_PADDING];
+}
+
+
+XmemDecoder::~XmemDecoder() {
+    lzx_teardown(myState);
+    delete[] myInput;
+}
+
+
+XmemDecoder& XmemDecoder::forThisThread() {
+    thread_local XmemDecoder decoder;
+    return decoder;
+}
+
+
+int XmemDecoder::decompress(u8* theOut, u32* theOutSize, c_u8* theIn, c_u32 theInSize) {
+    c_u32 capacity = *theOutSize;
+    *theOutSize = 0;
+    if (myState == nullptr || myInput == nullptr) {
+        printf("XMEM: Failed to initialize lzx decompressor, exiting\n");
+        return XMEM_ERROR::LZX;
+    }
+    // a fresh stream, the window and tables are kept
+    lzx_reset(myState);
+
+    c_u8* in = theIn;
+    c_u8* const inEnd = theIn + theInSize;
+    u32 written = 0;
+    bool isLastFrame = false;
+
+    // a stream that is a whole number of frames long has no shorter last frame to mark its end
+    while (!isLastFrame && in != inEnd) {
+        u32 frameSize = FRAME_SIZE;
+        if (in[0] == 0xFF) {
+            if (inEnd - in < 3) {
+                printf("Tried to readBytes past buffer when decompressing buffer with xmem\n");
+                return XMEM_ERROR::OVERFLOW;
+            }
+            frameSize = in[1] << 8 | in[2];
+            in += 3;
+            isLastFrame = true;
+        }
+        if (inEnd - in < 2) {
+            printf("Tried to readBytes past buffer when decompressing buffer with xmem\n");
+            return XMEM_ERROR::OVERFLOW;
+        }
+        c_u32 inputSize = in[0] << 8 | in[1];
+        in += 2;
+
+        if (inputSize == 0 || frameSize == 0) {
+            printf("XMEM: dst_size == 0 | src_size == 0, exiting\n");
+            return XMEM_ERROR::BAD_DATA;
+        }
+        if (frameSize > FRAME_SIZE) {
+            printf("XMEM: dst_size > 32768; invalid data, exiting\n");
+            return XMEM_ERROR::BAD_DATA;
+        }
+        if (inputSize > inEnd - in) {
+            printf("Tried to readBytes past buffer when decompressing buffer with xmem\n");
+            return XMEM_ERROR::OVERFLOW;
+        }
+        if (frameSize > capacity - written) {
+            printf("XMEM: output buffer is too small, exiting\n");
+            return XMEM_ERROR::OVERFLOW;
+        }
+
+        std::memcpy(myInput, in, inputSize);
+        std::memset(myInput + inputSize, 0, INPUT_PADDING);
+        in += inputSize;
+
+        // lzx copies each frame out of its window, so it is decoded straight into the output
+        if (lzx_decompress(myState, myInput, theOut + written,
+                           static_cast<int>(inputSize), static_cast<int>(frameSize)) != DECR_OK) {
+            printf("XMEM: Error decompressing, exiting\n");
+            return XMEM_ERROR::LZX;
+        }
+        written += frameSize;
+    }
+
+    *theOutSize = written;
+    return 0;
+}
+
+
+int XDecompress(u8* the_data_out, u32* the_size_out, c_u8* the_data_in, c_u32 the_size_in) {
+    return XmemDecoder::forThisThread().decompress(the_data_out, the_size_out, the_data_in, the_size_in);
+}
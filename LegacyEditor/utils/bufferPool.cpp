@@ -0,0 +1,121 @@
+#include "bufferPool.hpp"
+
+#include <bit>
+#include <new>
+
+
+namespace {
+
+    /// The buffers one thread is keeping, freed when the thread exits.
+    struct ThreadBuffers {
+        u8* buffers[BufferPool::CLASS_COUNT][BufferPool::BUFFERS_PER_CLASS] = {};
+        u32 counts[BufferPool::CLASS_COUNT] = {};
+
+        ~ThreadBuffers() { free(); }
+
+        void free() {
+            for (u32 index = 0; index < BufferPool::CLASS_COUNT; index++) {
+                for (u32 slot = 0; slot < counts[index]; slot++) {
+                    delete[] buffers[index][slot];
+                }
+                counts[index] = 0;
+            }
+        }
+    };
+
+
+    ThreadBuffers& getThreadBuffers() {
+        thread_local ThreadBuffers threadBuffers;
+        return threadBuffers;
+    }
+
+
+    /// The smallest class that fits "theSize", which may be past the last one.
+    u32 getClassShift(c_u32 theSize) {
+        c_u32 shift = theSize <= 1 ? 0 : static_cast<u32>(std::bit_width(theSize - 1));
+        return shift < BufferPool::MIN_CLASS_SHIFT ? BufferPool::MIN_CLASS_SHIFT : shift;
+    }
+
+}
+
+
+BufferPool::Buffer::Buffer(c_u32 theSize) {
+    myData = acquire(theSize, myCapacity);
+}
+
+
+BufferPool::Buffer::Buffer(Buffer&& theOther) noexcept
+    : myData(theOther.myData), myCapacity(theOther.myCapacity) {
+    theOther.myData = nullptr;
+    theOther.myCapacity = 0;
+}
+
+
+BufferPool::Buffer& BufferPool::Buffer::operator=(Buffer&& theOther) noexcept {
+    if (this != &theOther) {
+        release();
+        myData = theOther.myData;
+        myCapacity = theOther.myCapacity;
+        theOther.myData = nullptr;
+        theOther.myCapacity = 0;
+    }
+    return *this;
+}
+
+
+void BufferPool::Buffer::release() {
+    if (myData != nullptr) {
+        giveBack(myData, myCapacity);
+        myData = nullptr;
+        myCapacity = 0;
+    }
+}
+
+
+u8* BufferPool::acquire(c_u32 theSize, u32& theCapacity) {
+    c_u32 shift = getClassShift(theSize);
+    if (shift > MAX_CLASS_SHIFT) {
+        theCapacity = theSize;
+        return new(std::nothrow) u8[theSize];
+    }
+
+    theCapacity = 1U << shift;
+    ThreadBuffers& threadBuffers = getThreadBuffers();
+    u32& count = threadBuffers.counts[shift - MIN_CLASS_SHIFT];
+    if (count != 0) {
+        return threadBuffers.buffers[shift - MIN_CLASS_SHIFT][--count];
+    }
+    return new(std::nothrow) u8[theCapacity];
+}
+
+
+void BufferPool::giveBack(u8* theData, c_u32 theCapacity) {
+    c_u32 shift = getClassShift(theCapacity);
+    if (shift > MAX_CLASS_SHIFT || theCapacity != 1U << shift) {
+        delete[] theData;
+        return;
+    }
+
+    ThreadBuffers& threadBuffers = getThreadBuffers();
+    u32& count = threadBuffers.counts[shift - MIN_CLASS_SHIFT];
+    if (count == BUFFERS_PER_CLASS) {
+        delete[] theData;
+        return;
+    }
+    threadBuffers.buffers[shift - MIN_CLASS_SHIFT][count++] = theData;
+}
+
+
+MU void BufferPool::trim() {
+    getThreadBuffers().free();
+}
+
+
+MU u64 BufferPool::getKeptBytes() {
+    const ThreadBuffers& threadBuffers = getThreadBuffers();
+    u64 total = 0;
+    for (u32 index = 0; index < CLASS_COUNT; index++) {
+        total += static_cast<u64>(threadBuffers.counts[index]) << (index + MIN_CLASS_SHIFT);
+    }
+    return total;
+}
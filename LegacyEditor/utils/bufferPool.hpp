@@ -0,0 +1,60 @@
+#pragma once
+
+#include "lce/processor.hpp"
+
+
+/**
+ * Scratch memory that is handed back and reused instead of freed.
+ * \n\n
+ * Every thread has its own pool, so taking and returning a buffer needs no locking.
+ * Buffers are sorted into classes by their size rounded up to a power of two, from 4 KiB
+ * to 16 MiB; each class keeps at most a few of them. Larger sizes are not pooled.
+ * \n\n
+ * A buffer is not cleared when it is reused.
+ */
+class BufferPool {
+public:
+    static constexpr u32 MIN_CLASS_SHIFT = 12;
+    static constexpr u32 MAX_CLASS_SHIFT = 24;
+    static constexpr u32 CLASS_COUNT = MAX_CLASS_SHIFT - MIN_CLASS_SHIFT + 1;
+    static constexpr u32 BUFFERS_PER_CLASS = 4;
+
+
+    /// A buffer taken from the pool of the calling thread, given back when it goes out of scope.
+    class Buffer {
+        u8* myData = nullptr;
+        u32 myCapacity = 0;
+
+    public:
+        Buffer() = default;
+        /// Holds at least "theSize" bytes.
+        explicit Buffer(u32 theSize);
+        ~Buffer() { release(); }
+
+        Buffer(const Buffer&) = delete;
+        Buffer& operator=(const Buffer&) = delete;
+        Buffer(Buffer&& theOther) noexcept;
+        Buffer& operator=(Buffer&& theOther) noexcept;
+
+        /// Gives the buffer back to the pool early.
+        void release();
+
+        ND u8* data() const { return myData; }
+        ND u32 capacity() const { return myCapacity; }
+    };
+
+
+    /// Frees every buffer the calling thread is keeping.
+    MU static void trim();
+
+    /// How many bytes the calling thread is keeping.
+    MU ND static u64 getKeptBytes();
+
+private:
+    /**
+     * @param theCapacity set to the real size of the buffer
+     * @return nullptr if the memory could not be allocated
+     */
+    ND static u8* acquire(u32 theSize, u32& theCapacity);
+    static void giveBack(u8* theData, u32 theCapacity);
+};
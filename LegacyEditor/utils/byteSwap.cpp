@@ -0,0 +1,78 @@
+#include "byteSwap.hpp"
+
+#include <cstring>
+
+#include "LegacyEditor/utils/cpuFeatures.hpp"
+
+
+namespace byteswap {
+
+
+    /// The elements left over after the vector loop, or all of them without SSE2.
+    template<class intType>
+    static void swapTail(u8* theData, const size_t theCount) {
+        for (size_t index = 0; index < theCount; index++) {
+            intType value;
+            std::memcpy(&value, theData + index * sizeof(intType), sizeof(intType));
+            value = swap(value);
+            std::memcpy(theData + index * sizeof(intType), &value, sizeof(intType));
+        }
+    }
+
+
+#ifdef CPU_X86
+    /// Swaps the two bytes of every 16 bit lane; SSE2 has no byte shuffle, so it is done with shifts.
+    static __m128i swapLanes16(const __m128i theValue) {
+        return _mm_or_si128(_mm_slli_epi16(theValue, 8), _mm_srli_epi16(theValue, 8));
+    }
+#endif
+
+
+    void swapArray16(void* theData, const size_t theCount) {
+        auto* data = static_cast<u8*>(theData);
+        size_t index = 0;
+#ifdef CPU_X86
+        for (; index + 8 <= theCount; index += 8) {
+            auto* lane = reinterpret_cast<__m128i*>(data + index * 2);
+            _mm_storeu_si128(lane, swapLanes16(_mm_loadu_si128(lane)));
+        }
+#endif
+        swapTail<u16>(data + index * 2, theCount - index);
+    }
+
+
+    void swapArray32(void* theData, const size_t theCount) {
+        auto* data = static_cast<u8*>(theData);
+        size_t index = 0;
+#ifdef CPU_X86
+        for (; index + 4 <= theCount; index += 4) {
+            auto* lane = reinterpret_cast<__m128i*>(data + index * 4);
+            // swap the 16 bit halves of each value, then the bytes of each half
+            __m128i value = _mm_loadu_si128(lane);
+            value = _mm_shufflelo_epi16(value, _MM_SHUFFLE(2, 3, 0, 1));
+            value = _mm_shufflehi_epi16(value, _MM_SHUFFLE(2, 3, 0, 1));
+            _mm_storeu_si128(lane, swapLanes16(value));
+        }
+#endif
+        swapTail<u32>(data + index * 4, theCount - index);
+    }
+
+
+    void swapArray64(void* theData, const size_t theCount) {
+        auto* data = static_cast<u8*>(theData);
+        size_t index = 0;
+#ifdef CPU_X86
+        for (; index + 2 <= theCount; index += 2) {
+            auto* lane = reinterpret_cast<__m128i*>(data + index * 8);
+            // reverse the four 16 bit parts of each value, then the bytes of each part
+            __m128i value = _mm_loadu_si128(lane);
+            value = _mm_shufflelo_epi16(value, _MM_SHUFFLE(0, 1, 2, 3));
+            value = _mm_shufflehi_epi16(value, _MM_SHUFFLE(0, 1, 2, 3));
+            _mm_storeu_si128(lane, swapLanes16(value));
+        }
+#endif
+        swapTail<u64>(data + index * 8, theCount - index);
+    }
+
+
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+
+#include "lce/processor.hpp"
+
+
+/**
+ * Byte order helpers for code that knows at compile time which order it reads or writes,
+ * see EndianDataManager. Unlike swapEndian16/32/64 in utils.hpp they are constexpr,
+ * and compilers turn them into a single bswap.
+ */
+namespace byteswap {
+
+    constexpr u16 swap16(c_u16 theValue) {
+        return static_cast<u16>(theValue >> 8 | theValue << 8);
+    }
+
+    constexpr u32 swap32(c_u32 theValue) {
+        return theValue >> 24 | (theValue >> 8 & 0xFF00) | (theValue << 8 & 0xFF0000) | theValue << 24;
+    }
+
+    constexpr u64 swap64(c_u64 theValue) {
+        return static_cast<u64>(swap32(static_cast<u32>(theValue))) << 32 | swap32(static_cast<u32>(theValue >> 32));
+    }
+
+
+    /// Swaps an unsigned integer of any size.
+    template<class intType>
+    constexpr intType swap(const intType theValue) {
+        if constexpr (sizeof(intType) == 1) {
+            return theValue;
+        } else if constexpr (sizeof(intType) == 2) {
+            return swap16(theValue);
+        } else if constexpr (sizeof(intType) == 4) {
+            return swap32(theValue);
+        } else {
+            return swap64(theValue);
+        }
+    }
+
+
+    /// Turns a value between "ORDER" and the order of this machine; it is the same both ways.
+    template<std::endian ORDER, class intType>
+    constexpr intType convert(const intType theValue) {
+        if constexpr (ORDER == std::endian::native) {
+            return theValue;
+        } else {
+            return swap(theValue);
+        }
+    }
+
+
+    /**
+     * Swap every element of an array in place, 16 bytes at a time where SSE2 is available.
+     * "theData" needs no alignment; "theCount" is in elements, not bytes.
+     */
+    void swapArray16(void* theData, size_t theCount);
+    void swapArray32(void* theData, size_t theCount);
+    void swapArray64(void* theData, size_t theCount);
+
+
+    /// Turns an array of "intType" between "ORDER" and the order of this machine, in place.
+    template<std::endian ORDER, class intType>
+    void convertArray(void* theData, const size_t theCount) {
+        if constexpr (ORDER != std::endian::native) {
+            if constexpr (sizeof(intType) == 2) {
+                swapArray16(theData, theCount);
+            } else if constexpr (sizeof(intType) == 4) {
+                swapArray32(theData, theCount);
+            } else if constexpr (sizeof(intType) == 8) {
+                swapArray64(theData, theCount);
+            }
+        }
+    }
+
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "lce/processor.hpp"
+
+/*
+ * The one place that decides which SIMD code is built and which of it may run.
+ * CPU_X86 is set on x86-64, where SSE2 is always there; anything newer is
+ * compiled with a CPU_TARGET_* attribute and only called after asking cpu::has*.
+ */
+#if defined(__x86_64__) || defined(_M_X64)
+#define CPU_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define CPU_TARGET_SSSE3
+#define CPU_TARGET_AVX2
+#else
+#define CPU_TARGET_SSSE3 __attribute__((target("ssse3")))
+#define CPU_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+
+namespace cpu {
+
+#ifdef CPU_X86
+
+    namespace detail {
+        inline bool querySSSE3() {
+#ifdef _MSC_VER
+            int info[4];
+            __cpuid(info, 1);
+            return (info[2] & (1 << 9)) != 0;
+#else
+            return __builtin_cpu_supports("ssse3");
+#endif
+        }
+
+        inline bool queryAVX2() {
+#ifdef _MSC_VER
+            int info[4];
+            __cpuid(info, 1);
+            // the OS has to save the ymm registers as well
+            if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0 || (_xgetbv(0) & 6) != 6) {
+                return false;
+            }
+            __cpuidex(info, 7, 0);
+            return (info[1] & (1 << 5)) != 0;
+#else
+            return __builtin_cpu_supports("avx2");
+#endif
+        }
+    }
+
+
+    /// Asked once, then cached for the whole program.
+    ND inline bool hasSSSE3() {
+        static const bool result = detail::querySSSE3();
+        return result;
+    }
+
+    /// Asked once, then cached for the whole program.
+    ND inline bool hasAVX2() {
+        static const bool result = detail::queryAVX2();
+        return result;
+    }
+
+#else
+
+    ND inline bool hasSSSE3() { return false; }
+    ND inline bool hasAVX2() { return false; }
+
+#endif
+
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstring>
+
 #include "lce/processor.hpp"
 
 
@@ -8,6 +10,8 @@ public:
     u32 size = 0;
     u8* data = nullptr;
     bool dealloc_out_of_scope = false;
+    /// false if "data" points into memory owned by something else, such as a mapped file.
+    bool owns_memory = true;
 
     Data() = default;
 
@@ -28,13 +32,41 @@ public:
 
     bool allocate(c_u32 sizeIn) {
         size = sizeIn;
-        delete[] data;
+        if (owns_memory) {
+            delete[] data;
+        }
+        owns_memory = true;
 
         data = new(std::nothrow) u8[sizeIn];
         return data != nullptr;
     }
 
 
+    /// points at memory owned by something else, which will not be freed by this class.
+    void view(u8* dataIn, c_u32 sizeIn) {
+        deallocate();
+        data = dataIn;
+        size = sizeIn;
+        owns_memory = false;
+    }
+
+
+    /// if this is a view, copies the memory it points to so that it is owned.
+    bool makeOwned() {
+        if (owns_memory || data == nullptr) {
+            return true;
+        }
+        u8* copy = new(std::nothrow) u8[size];
+        if (copy == nullptr) {
+            return false;
+        }
+        std::memcpy(copy, data, size);
+        data = copy;
+        owns_memory = true;
+        return true;
+    }
+
+
     /// if set to true, it will deallocate it's memory when it goes out of scope.
     void setScopeDealloc(const bool exp) {
         dealloc_out_of_scope = exp;
@@ -42,22 +74,27 @@ public:
 
     void deallocate() {
         if (data != nullptr) {
-            delete[] data;
+            if (owns_memory) {
+                delete[] data;
+            }
             data = nullptr;
             size = 0;
         }
+        owns_memory = true;
     }
 
     void steal(Data& other) {
         deallocate();
         data = other.data;
         size = other.size;
+        owns_memory = other.owns_memory;
         other.reset();
     }
 
     void reset() {
         data = nullptr;
         size = 0;
+        owns_memory = true;
     }
 
     ND u8* start() const { return data; }
@@ -3,6 +3,7 @@
 #include <cstring>
 
 #include "LegacyEditor/code/LCEFile/LCEFile.hpp"
+#include "LegacyEditor/utils/timer.hpp"
 
 
 static constexpr u8 FF_MASK = 0xFF;
@@ -219,8 +220,13 @@ bool DataManager::readBool() {
 
 
 std::string DataManager::readUTF() {
+    return std::string(readUTFView());
+}
+
+
+std::string_view DataManager::readUTFView() {
     c_u8 length = readInt16();
-    std::string return_string(reinterpret_cast<char*>(ptr), length);
+    const std::string_view return_string(reinterpret_cast<char*>(ptr), length);
     incrementPointer(length);
     return return_string;
 }
@@ -361,6 +367,7 @@ void DataManager::readBytes(c_u32 length, u8* dataIn) {
 }
 
 int DataManager::readFromFile(const std::string& fileStrIn) {
+    const StageTimer timer(STAGE::FILE_IO);
     FILE* file = fopen(fileStrIn.c_str(), "rb");
     if (file == nullptr) {
         printf("Cannot open infile '%s'", fileStrIn.c_str());
@@ -559,10 +566,10 @@ void DataManager::writeFile(const editor::LCEFile& fileIn) {
 }
 
 
-void DataManager::writeUTF(std::string str) {
+void DataManager::writeUTF(const std::string_view str) {
     c_u32 str_size = str.size();
     writeInt16(str_size);
-    writeBytes(reinterpret_cast<u8*>(str.data()), str_size);
+    writeBytes(reinterpret_cast<c_u8*>(str.data()), str_size);
 }
 
 
@@ -622,6 +629,7 @@ void DataManager::writeWStringFromString(const std::string& str, c_u32 upperboun
 }
 
 int DataManager::writeToFile(const fs::path& inFilePath) const {
+    const StageTimer timer(STAGE::FILE_IO);
     std::string inFileStr = inFilePath.string();
 
     FILE *f_out = fopen(inFileStr.c_str(), "wb");
@@ -638,6 +646,7 @@ int DataManager::writeToFile(const fs::path& inFilePath) const {
 
 
 int DataManager::writeToFile(c_u8* ptrIn, c_u32 sizeIn, const fs::path& inFilePath) const {
+    const StageTimer timer(STAGE::FILE_IO);
     std::string inFileStr = inFilePath.string();
 
     FILE* f_out = fopen(inFileStr.c_str(), "wb");
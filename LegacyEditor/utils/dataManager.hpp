@@ -2,12 +2,14 @@
 
 #include <filesystem>
 #include <string>
+#include <string_view>
 
 #include "lce/processor.hpp"
 
 #include "include/ghc/fs_std.hpp"
 
 #include "LegacyEditor/utils/data.hpp"
+#include "LegacyEditor/utils/mappedFile.hpp"
 
 
 namespace editor {
@@ -29,6 +31,9 @@ public:
     explicit DataManager(const Data* dataIn) : data(dataIn->start()), ptr(data), size(dataIn->size) {}
     explicit DataManager(const Data* dataIn, c_bool isBig) : isBig(isBig), data(dataIn->start()), ptr(data), size(dataIn->size) {}
 
+    explicit DataManager(const MappedFile& fileIn) : data(fileIn.start()), ptr(data), size(fileIn.getSize()) {}
+    explicit DataManager(const MappedFile& fileIn, c_bool isBig) : isBig(isBig), data(fileIn.start()), ptr(data), size(fileIn.getSize()) {}
+
     explicit DataManager(u8* dataIn, c_u32 sizeIn) : data(dataIn), ptr(dataIn), size(sizeIn) {}
     explicit DataManager(u8* dataIn, c_u32 sizeIn, c_bool isBig) : isBig(isBig), data(dataIn), ptr(dataIn), size(sizeIn) {}
 
@@ -79,6 +84,8 @@ public:
     MU u64 readInt64AtOffset(u32 offset) const;
 
     std::string readUTF();
+    /// Same as readUTF, but points into .data instead of copying the string.
+    std::string_view readUTFView();
     std::string readString(i32 length);
     std::string readNullTerminatedString();
 
@@ -120,7 +127,7 @@ public:
     void writeFile(const editor::LCEFile& fileIn);
     void writeBytes(c_u8* dataPtrIn, u32 length);
 
-    void writeUTF(std::string str);
+    void writeUTF(std::string_view str);
     /**
      * \brief note that upperbounds is per 2 bytes, so use 64 for 128 bytes.
      * \param wstr
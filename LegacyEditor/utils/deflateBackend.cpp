@@ -0,0 +1,61 @@
+#include "deflateBackend.hpp"
+
+#include <atomic>
+
+#include "include/tinf/tinf.h"
+#include "include/zlib-1.2.12/zlib.h"
+
+#include "LegacyEditor/utils/error_status.hpp"
+#include "LegacyEditor/utils/fastInflate.hpp"
+
+
+u32 DeflateBackend::getDeflateBound(c_u32 theInSize) const {
+    return static_cast<u32>(compressBound(theInSize));
+}
+
+
+int DeflateBackend::deflateZlib(u8* theOut, u32& theOutSize, c_u8* theIn, c_u32 theInSize, c_int theLevel) const {
+    uLongf outSize = theOutSize;
+    if (compress2(theOut, &outSize, theIn, theInSize, theLevel) != Z_OK) {
+        theOutSize = 0;
+        return COMPRESS;
+    }
+    theOutSize = static_cast<u32>(outSize);
+    return SUCCESS;
+}
+
+
+int TinfBackend::inflateRaw(u8* theOut, u32& theOutSize, c_u8* theIn, c_u32 theInSize) const {
+    return tinf_uncompress(theOut, &theOutSize, theIn, theInSize) == TINF_OK ? SUCCESS : DECOMPRESS;
+}
+
+
+int TinfBackend::inflateZlib(u8* theOut, u32& theOutSize, c_u8* theIn, c_u32 theInSize) const {
+    return tinf_zlib_uncompress(theOut, &theOutSize, theIn, theInSize) == TINF_OK ? SUCCESS : DECOMPRESS;
+}
+
+
+int FastInflateBackend::inflateRaw(u8* theOut, u32& theOutSize, c_u8* theIn, c_u32 theInSize) const {
+    return fastInflate(theOut, theOutSize, theIn, theInSize);
+}
+
+
+int FastInflateBackend::inflateZlib(u8* theOut, u32& theOutSize, c_u8* theIn, c_u32 theInSize) const {
+    return fastZlibInflate(theOut, theOutSize, theIn, theInSize);
+}
+
+
+namespace {
+    const FastInflateBackend DEFAULT_BACKEND;
+    std::atomic<const DeflateBackend*> currentBackend = &DEFAULT_BACKEND;
+}
+
+
+MU const DeflateBackend& getDeflateBackend() {
+    return *currentBackend.load(std::memory_order_acquire);
+}
+
+
+MU void setDeflateBackend(const DeflateBackend& theBackend) {
+    currentBackend.store(&theBackend, std::memory_order_release);
+}
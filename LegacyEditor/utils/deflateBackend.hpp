@@ -0,0 +1,73 @@
+#pragma once
+
+#include "lce/processor.hpp"
+
+
+/// zlib's own default, a balance of speed and ratio
+static constexpr int DEFAULT_COMPRESSION_LEVEL = -1;
+/// stores the data without compressing it, the fastest level
+static constexpr int MIN_COMPRESSION_LEVEL = 0;
+static constexpr int MAX_COMPRESSION_LEVEL = 9;
+
+
+/**
+ * Inflates and deflates the zlib and raw deflate streams that chunks and listings are stored in.
+ * \n\n
+ * The backend in use is shared by every thread, so implementations must not keep state
+ * between calls. Deflating goes through the bundled zlib unless an implementation overrides it.
+ */
+class DeflateBackend {
+public:
+    virtual ~DeflateBackend() = default;
+
+    ND virtual const char* getName() const = 0;
+
+    /**
+     * Inflates a raw deflate stream, as PS3 chunks and listings are stored.
+     * @param theOutSize the size of "theOut"; set to how many bytes were inflated
+     * @return SUCCESS or DECOMPRESS
+     */
+    ND virtual int inflateRaw(u8* theOut, u32& theOutSize, c_u8* theIn, u32 theInSize) const = 0;
+
+    /// Inflates a zlib stream (a 2 byte header, raw deflate and an adler32), see inflateRaw.
+    ND virtual int inflateZlib(u8* theOut, u32& theOutSize, c_u8* theIn, u32 theInSize) const = 0;
+
+    /// The most bytes deflateZlib can write for "theInSize" bytes of input.
+    ND virtual u32 getDeflateBound(u32 theInSize) const;
+
+    /**
+     * Deflates into a zlib stream.
+     * @param theOutSize the size of "theOut", at least getDeflateBound; set to how many bytes were written
+     * @param theLevel from MIN_COMPRESSION_LEVEL to MAX_COMPRESSION_LEVEL, or DEFAULT_COMPRESSION_LEVEL
+     * @return SUCCESS or COMPRESS
+     */
+    ND virtual int deflateZlib(u8* theOut, u32& theOutSize, c_u8* theIn, u32 theInSize, int theLevel) const;
+};
+
+
+/// The small decoder from include/tinf, kept to compare against.
+class TinfBackend final : public DeflateBackend {
+public:
+    ND const char* getName() const override { return "tinf"; }
+    ND int inflateRaw(u8* theOut, u32& theOutSize, c_u8* theIn, u32 theInSize) const override;
+    ND int inflateZlib(u8* theOut, u32& theOutSize, c_u8* theIn, u32 theInSize) const override;
+};
+
+
+/// The table driven decoder from fastInflate.hpp, the default.
+class FastInflateBackend final : public DeflateBackend {
+public:
+    ND const char* getName() const override { return "fastInflate"; }
+    ND int inflateRaw(u8* theOut, u32& theOutSize, c_u8* theIn, u32 theInSize) const override;
+    ND int inflateZlib(u8* theOut, u32& theOutSize, c_u8* theIn, u32 theInSize) const override;
+};
+
+
+/// The backend every chunk and listing is inflated and deflated with.
+MU ND const DeflateBackend& getDeflateBackend();
+
+/**
+ * Replaces the backend in use. It is not owned, so it has to outlive every use;
+ * it should not be swapped while a save is being read or written.
+ */
+MU void setDeflateBackend(const DeflateBackend& theBackend);
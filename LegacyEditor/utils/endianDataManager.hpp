@@ -0,0 +1,214 @@
+#pragma once
+
+#include <bit>
+#include <cstring>
+#include <string_view>
+
+#include "lce/processor.hpp"
+
+#include "LegacyEditor/utils/byteSwap.hpp"
+#include "LegacyEditor/utils/dataManager.hpp"
+
+
+/**
+ * A DataManager whose byte order is part of its type, for the loops that read or write
+ * thousands of values: every access is a load or store plus at most one bswap, instead of
+ * a branch on DataManager::isBig and a byte by byte shift.
+ * \n\n
+ * With "CHECKED", a read or write that does not fit returns 0 or does nothing, does not move
+ * "ptr", and sets hasOverflowed(); without it there are no bounds checks at all, as in DataManager.
+ * \n\n
+ * It is usually made from a DataManager for one section, then handed back with "sync".
+ */
+template<std::endian ORDER, bool CHECKED = false>
+class EndianDataManager {
+    bool myHasOverflowed = false;
+
+    /// Whether "theAmount" more bytes fit; always true when not "CHECKED".
+    ND bool fits(c_u64 theAmount) {
+        if constexpr (CHECKED) {
+            if (theAmount > size - getPosition()) {
+                myHasOverflowed = true;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    ND bool fitsAt(c_u32 theOffset, c_u64 theAmount) {
+        if constexpr (CHECKED) {
+            if (theOffset > size || theAmount > size - theOffset) {
+                myHasOverflowed = true;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    template<class intType>
+    ND static intType load(c_u8* thePtr) {
+        intType value;
+        std::memcpy(&value, thePtr, sizeof(intType));
+        return byteswap::convert<ORDER>(value);
+    }
+
+    template<class intType>
+    static void store(u8* thePtr, const intType theValue) {
+        const intType value = byteswap::convert<ORDER>(theValue);
+        std::memcpy(thePtr, &value, sizeof(intType));
+    }
+
+    template<class intType>
+    ND intType readInt() {
+        if (!fits(sizeof(intType))) {
+            return 0;
+        }
+        const intType value = load<intType>(ptr);
+        ptr += sizeof(intType);
+        return value;
+    }
+
+    template<class intType>
+    void writeInt(const intType theValue) {
+        if (!fits(sizeof(intType))) {
+            return;
+        }
+        store(ptr, theValue);
+        ptr += sizeof(intType);
+    }
+
+    template<class intType>
+    ND intType readIntAtOffset(c_u32 theOffset) {
+        if (!fitsAt(theOffset, sizeof(intType))) {
+            return 0;
+        }
+        return load<intType>(data + theOffset);
+    }
+
+    template<class intType>
+    void writeIntAtOffset(c_u32 theOffset, const intType theValue) {
+        if (!fitsAt(theOffset, sizeof(intType))) {
+            return;
+        }
+        store(data + theOffset, theValue);
+    }
+
+public:
+    static constexpr bool IS_BIG = ORDER == std::endian::big;
+
+    u8 *data = nullptr, *ptr = nullptr;
+    u32 size = 0;
+
+    EndianDataManager() = default;
+    explicit EndianDataManager(u8* dataIn, c_u32 sizeIn) : data(dataIn), ptr(dataIn), size(sizeIn) {}
+    /// Continues from where "theManager" is; its byte order is not looked at.
+    explicit EndianDataManager(const DataManager& theManager)
+        : data(theManager.data), ptr(theManager.ptr), size(theManager.size) {}
+
+    /// Moves "theManager" to where this one is.
+    void sync(DataManager& theManager) const { theManager.ptr = ptr; }
+
+    ND u32 getPosition() const { return static_cast<u32>(ptr - data); }
+    ND bool canReadSize(c_u32 theAmount) const { return theAmount <= size - getPosition(); }
+    /// Whether a read or write did not fit, only ever set when "CHECKED".
+    ND bool hasOverflowed() const { return myHasOverflowed; }
+
+    void incrementPointer(c_u32 theAmount) {
+        if (fits(theAmount)) {
+            ptr += theAmount;
+        }
+    }
+
+    // READING SECTION
+
+    u8 readInt8() { return readInt<u8>(); }
+    u16 readInt16() { return readInt<u16>(); }
+    u32 readInt32() { return readInt<u32>(); }
+    u64 readInt64() { return readInt<u64>(); }
+    float readFloat() { return std::bit_cast<float>(readInt<u32>()); }
+    double readDouble() { return std::bit_cast<double>(readInt<u64>()); }
+
+    /// reads at offset from .data, not .ptr! Does not increment .ptr.
+    u16 readInt16AtOffset(c_u32 theOffset) { return readIntAtOffset<u16>(theOffset); }
+    /// reads at offset from .data, not .ptr! Does not increment .ptr.
+    u32 readInt32AtOffset(c_u32 theOffset) { return readIntAtOffset<u32>(theOffset); }
+    /// reads at offset from .data, not .ptr! Does not increment .ptr.
+    u64 readInt64AtOffset(c_u32 theOffset) { return readIntAtOffset<u64>(theOffset); }
+
+    /// Points into .data instead of copying the string, like DataManager::readUTFView.
+    std::string_view readUTFView() {
+        c_u16 length = readInt16();
+        if (!fits(length)) {
+            return {};
+        }
+        const std::string_view view(reinterpret_cast<const char*>(ptr), length);
+        ptr += length;
+        return view;
+    }
+
+    void readBytes(c_u32 theLength, u8* theOutput) {
+        if (!fits(theLength)) {
+            return;
+        }
+        std::memcpy(theOutput, ptr, theLength);
+        ptr += theLength;
+    }
+
+    /// Reads "theCount" values into "theOutput" with a single copy and bulk swap.
+    template<class intType>
+    void readArray(intType* theOutput, c_u32 theCount) {
+        if (!fits(static_cast<u64>(theCount) * sizeof(intType))) {
+            return;
+        }
+        std::memcpy(theOutput, ptr, theCount * sizeof(intType));
+        byteswap::convertArray<ORDER, intType>(theOutput, theCount);
+        ptr += theCount * sizeof(intType);
+    }
+
+    // WRITING SECTION
+
+    void writeInt8(c_u8 theValue) { writeInt<u8>(theValue); }
+    void writeInt16(c_u16 theValue) { writeInt<u16>(theValue); }
+    void writeInt32(c_u32 theValue) { writeInt<u32>(theValue); }
+    void writeInt64(c_u64 theValue) { writeInt<u64>(theValue); }
+    void writeFloat(const float theValue) { writeInt<u32>(std::bit_cast<u32>(theValue)); }
+    void writeDouble(const double theValue) { writeInt<u64>(std::bit_cast<u64>(theValue)); }
+
+    /// writes at offset from .data, not .ptr! Does not increment .ptr.
+    void writeInt16AtOffset(c_u32 theOffset, c_u16 theValue) { writeIntAtOffset<u16>(theOffset, theValue); }
+    /// writes at offset from .data, not .ptr! Does not increment .ptr.
+    void writeInt32AtOffset(c_u32 theOffset, c_u32 theValue) { writeIntAtOffset<u32>(theOffset, theValue); }
+    /// writes at offset from .data, not .ptr! Does not increment .ptr.
+    void writeInt64AtOffset(c_u32 theOffset, c_u64 theValue) { writeIntAtOffset<u64>(theOffset, theValue); }
+
+    void writeUTF(const std::string_view theString) {
+        if (!fits(2 + static_cast<u64>(theString.size()))) {
+            return;
+        }
+        writeInt16(static_cast<u16>(theString.size()));
+        writeBytes(reinterpret_cast<c_u8*>(theString.data()), static_cast<u32>(theString.size()));
+    }
+
+    void writeBytes(c_u8* theInput, c_u32 theLength) {
+        if (!fits(theLength)) {
+            return;
+        }
+        std::memcpy(ptr, theInput, theLength);
+        ptr += theLength;
+    }
+
+    /// Writes "theCount" values with a single copy, then swaps them where they were written.
+    template<class intType>
+    void writeArray(const intType* theInput, c_u32 theCount) {
+        if (!fits(static_cast<u64>(theCount) * sizeof(intType))) {
+            return;
+        }
+        std::memcpy(ptr, theInput, theCount * sizeof(intType));
+        byteswap::convertArray<ORDER, intType>(ptr, theCount);
+        ptr += theCount * sizeof(intType);
+    }
+};
+
+
+using BigDataManager = EndianDataManager<std::endian::big>;
+using LittleDataManager = EndianDataManager<std::endian::little>;
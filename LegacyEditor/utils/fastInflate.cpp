@@ -0,0 +1,463 @@
+#include "fastInflate.hpp"
+
+#include <bit>
+#include <cstring>
+
+#include "include/zlib-1.2.12/zlib.h"
+
+#include "LegacyEditor/utils/error_status.hpp"
+
+
+// #####################################################
+// #               Huffman Tables
+// #####################################################
+
+
+/**
+ * A code is looked up by its first TABLE_BITS bits. Longer codes share an entry
+ * that links to a subtable, which is indexed by the bits that come after.
+ */
+struct Entry {
+    /// the literal, the base length or distance, or where the subtable starts
+    u16 value;
+    /// the length of the code, or how many bits index the subtable it links to
+    u8 bits;
+    /// one of the KIND flags; for KIND_BASE, the low 4 bits are how many extra bits follow
+    u8 kind;
+};
+
+// a kind of 0 is a code that the block does not use
+static constexpr u8 KIND_LITERAL = 0x10;
+static constexpr u8 KIND_BASE = 0x20;
+static constexpr u8 KIND_END = 0x40;
+static constexpr u8 KIND_LINK = 0x80;
+
+static constexpr u32 MAX_CODE_BITS = 15;
+static constexpr u32 LITLEN_SYMBOLS = 288;
+static constexpr u32 DIST_SYMBOLS = 32;
+static constexpr u32 LITLEN_TABLE_BITS = 10;
+static constexpr u32 DIST_TABLE_BITS = 8;
+static constexpr u32 CODELEN_TABLE_BITS = 7;
+// every code longer than the table bits could start a subtable of its own
+static constexpr u32 LITLEN_TABLE_SIZE = (1U << LITLEN_TABLE_BITS)
+                                         + LITLEN_SYMBOLS * (1U << (MAX_CODE_BITS - LITLEN_TABLE_BITS));
+static constexpr u32 DIST_TABLE_SIZE = (1U << DIST_TABLE_BITS)
+                                       + DIST_SYMBOLS * (1U << (MAX_CODE_BITS - DIST_TABLE_BITS));
+
+static constexpr u16 LENGTH_BASE[29] = {
+        3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+        35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+static constexpr u8 LENGTH_EXTRA[29] = {
+        0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+        3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+static constexpr u16 DIST_BASE[30] = {
+        1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+        257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+static constexpr u8 DIST_EXTRA[30] = {
+        0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+        7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+
+static Entry getLitLenEntry(c_u32 theSymbol) {
+    if (theSymbol < 256) {
+        return {static_cast<u16>(theSymbol), 0, KIND_LITERAL};
+    }
+    if (theSymbol == 256) {
+        return {0, 0, KIND_END};
+    }
+    if (theSymbol < 286) {
+        return {LENGTH_BASE[theSymbol - 257], 0, static_cast<u8>(KIND_BASE | LENGTH_EXTRA[theSymbol - 257])};
+    }
+    return {0, 0, 0};
+}
+
+
+static Entry getDistEntry(c_u32 theSymbol) {
+    if (theSymbol < 30) {
+        return {DIST_BASE[theSymbol], 0, static_cast<u8>(KIND_BASE | DIST_EXTRA[theSymbol])};
+    }
+    return {0, 0, 0};
+}
+
+
+static Entry getCodeLenEntry(c_u32 theSymbol) {
+    return {static_cast<u16>(theSymbol), 0, KIND_LITERAL};
+}
+
+
+/**
+ * Fills "theTable" with the canonical code described by "theLengths". Codes that are
+ * incomplete are allowed, the entries they leave empty are only an error if they are read.
+ * @return false if there are more codes than the lengths allow
+ */
+static bool buildTable(Entry* theTable, c_u32 theTableBits, c_u8* theLengths, c_u32 theCount,
+                       Entry (*theGetEntry)(u32)) {
+    u16 lengthCount[MAX_CODE_BITS + 1] = {};
+    for (u32 symbol = 0; symbol < theCount; symbol++) {
+        lengthCount[theLengths[symbol]]++;
+    }
+    lengthCount[0] = 0;
+
+    int codesLeft = 1;
+    u32 maxLength = 0;
+    for (u32 length = 1; length <= MAX_CODE_BITS; length++) {
+        codesLeft = codesLeft * 2 - lengthCount[length];
+        if (codesLeft < 0) {
+            return false;
+        }
+        if (lengthCount[length] != 0) {
+            maxLength = length;
+        }
+    }
+
+    // symbols sorted by the length of their code, then by their value
+    u16 offsets[MAX_CODE_BITS + 2] = {};
+    for (u32 length = 1; length <= MAX_CODE_BITS; length++) {
+        offsets[length + 1] = offsets[length] + lengthCount[length];
+    }
+    u16 sorted[LITLEN_SYMBOLS];
+    for (u32 symbol = 0; symbol < theCount; symbol++) {
+        if (theLengths[symbol] != 0) {
+            sorted[offsets[theLengths[symbol]]++] = static_cast<u16>(symbol);
+        }
+    }
+
+    c_u32 tableSize = 1U << theTableBits;
+    c_u32 subBits = maxLength > theTableBits ? maxLength - theTableBits : 0;
+    std::memset(theTable, 0, tableSize * sizeof(Entry));
+    u32 nextSubtable = tableSize;
+
+    u32 code = 0;
+    u32 sortedIndex = 0;
+    for (u32 length = 1; length <= maxLength; length++, code <<= 1) {
+        for (u32 count = 0; count < lengthCount[length]; count++, code++) {
+            Entry entry = theGetEntry(sorted[sortedIndex++]);
+            entry.bits = static_cast<u8>(length);
+
+            // codes are read starting from their highest bit
+            u32 reversed = 0;
+            for (u32 bit = 0; bit < length; bit++) {
+                reversed |= (code >> bit & 1) << (length - 1 - bit);
+            }
+
+            if (length <= theTableBits) {
+                for (u32 index = reversed; index < tableSize; index += 1U << length) {
+                    theTable[index] = entry;
+                }
+                continue;
+            }
+
+            Entry& link = theTable[reversed & (tableSize - 1)];
+            if (link.kind != KIND_LINK) {
+                link = {static_cast<u16>(nextSubtable), static_cast<u8>(subBits), KIND_LINK};
+                std::memset(theTable + nextSubtable, 0, (1U << subBits) * sizeof(Entry));
+                nextSubtable += 1U << subBits;
+            }
+            Entry* subtable = theTable + link.value;
+            for (u32 index = reversed >> theTableBits; index < 1U << subBits; index += 1U << (length - theTableBits)) {
+                subtable[index] = entry;
+            }
+        }
+    }
+    return true;
+}
+
+
+struct FixedTables {
+    Entry litLen[LITLEN_TABLE_SIZE];
+    Entry dist[DIST_TABLE_SIZE];
+
+    FixedTables() {
+        u8 lengths[LITLEN_SYMBOLS];
+        std::memset(lengths, 8, 144);
+        std::memset(lengths + 144, 9, 112);
+        std::memset(lengths + 256, 7, 24);
+        std::memset(lengths + 280, 8, 8);
+        buildTable(litLen, LITLEN_TABLE_BITS, lengths, LITLEN_SYMBOLS, getLitLenEntry);
+        std::memset(lengths, 5, DIST_SYMBOLS);
+        buildTable(dist, DIST_TABLE_BITS, lengths, DIST_SYMBOLS, getDistEntry);
+    }
+};
+
+
+static const FixedTables& getFixedTables() {
+    static const FixedTables tables;
+    return tables;
+}
+
+
+// #####################################################
+// #               Inflate
+// #####################################################
+
+
+static u64 readLE64(c_u8* thePtr) {
+    u64 value;
+    std::memcpy(&value, thePtr, 8);
+    if constexpr (std::endian::native == std::endian::big) {
+        value = (value & 0x00000000FFFFFFFFULL) << 32 | (value & 0xFFFFFFFF00000000ULL) >> 32;
+        value = (value & 0x0000FFFF0000FFFFULL) << 16 | (value & 0xFFFF0000FFFF0000ULL) >> 16;
+        value = (value & 0x00FF00FF00FF00FFULL) << 8 | (value & 0xFF00FF00FF00FF00ULL) >> 8;
+    }
+    return value;
+}
+
+
+/// Copies "theLength" bytes from "theDistance" bytes back; it may write up to 15 bytes past them.
+static void copyMatch(u8* theOut, c_u32 theDistance, c_u32 theLength) {
+    c_u8* src = theOut - theDistance;
+    u8* const end = theOut + theLength;
+    if (theDistance >= 16) {
+        do {
+            std::memcpy(theOut, src, 16);
+            theOut += 16;
+            src += 16;
+        } while (theOut < end);
+    } else if (theDistance >= 8) {
+        do {
+            std::memcpy(theOut, src, 8);
+            theOut += 8;
+            src += 8;
+        } while (theOut < end);
+    } else if (theDistance == 1) {
+        std::memset(theOut, *src, theLength);
+    } else {
+        while (theOut < end) {
+            *theOut++ = *src++;
+        }
+    }
+}
+
+
+int fastInflate(u8* theOut, u32& theOutSize, c_u8* theIn, c_u32 theInSize) {
+    // worst case bits of one length and distance: 15 + 5 + 15 + 13
+    static constexpr u32 MAX_SYMBOL_BITS = 48;
+    static constexpr u8 CODELEN_ORDER[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+    c_u8* in = theIn;
+    c_u8* const inEnd = theIn + theInSize;
+    // zero bytes fed in past the end, they are an error if they get used
+    u32 overrun = 0;
+    u64 bitBuffer = 0;
+    u32 bitCount = 0;
+    u8* out = theOut;
+    u8* const outEnd = theOut + theOutSize;
+    theOutSize = 0;
+
+    // leaves at least 56 bits; the bytes loaded past bitCount are read again by the next refill
+    auto refill = [&] {
+        if (inEnd - in >= 8) {
+            bitBuffer |= readLE64(in) << bitCount;
+            in += (63 - bitCount) >> 3;
+            bitCount |= 56;
+            return;
+        }
+        while (bitCount <= 56) {
+            if (in < inEnd) {
+                bitBuffer |= static_cast<u64>(*in++) << bitCount;
+            } else {
+                overrun++;
+            }
+            bitCount += 8;
+        }
+    };
+    auto consume = [&](c_u32 theBits) {
+        bitBuffer >>= theBits;
+        bitCount -= theBits;
+    };
+    auto readBits = [&](c_u32 theBits) {
+        c_u32 value = static_cast<u32>(bitBuffer & ((1ULL << theBits) - 1));
+        consume(theBits);
+        return value;
+    };
+    auto decode = [&](const Entry* theTable, c_u32 theTableBits) {
+        Entry entry = theTable[bitBuffer & ((1U << theTableBits) - 1)];
+        if (entry.kind == KIND_LINK) {
+            entry = theTable[entry.value + (bitBuffer >> theTableBits & ((1U << entry.bits) - 1))];
+        }
+        consume(entry.bits);
+        return entry;
+    };
+
+    Entry litLenTable[LITLEN_TABLE_SIZE];
+    Entry distTable[DIST_TABLE_SIZE];
+
+    bool isFinal = false;
+    while (!isFinal) {
+        refill();
+        isFinal = readBits(1) != 0;
+        c_u32 blockType = readBits(2);
+        const Entry* litLen = litLenTable;
+        const Entry* dist = distTable;
+
+        if (blockType == 0) {
+            // stored: the rest of this byte is skipped, then the bytes are read straight from the input
+            consume(bitCount & 7);
+            c_u64 position = static_cast<u64>(in - theIn) + overrun - (bitCount >> 3);
+            if (position + 4 > theInSize) {
+                return DECOMPRESS;
+            }
+            in = theIn + position;
+            overrun = 0;
+            bitBuffer = 0;
+            bitCount = 0;
+
+            c_u32 length = in[0] | in[1] << 8;
+            c_u32 lengthCheck = in[2] | in[3] << 8;
+            in += 4;
+            if (length != (~lengthCheck & 0xFFFF) || length > inEnd - in) {
+                return DECOMPRESS;
+            }
+            if (length > outEnd - out) {
+                return DECOMPRESS;
+            }
+            std::memcpy(out, in, length);
+            in += length;
+            out += length;
+            continue;
+        }
+
+        if (blockType == 1) {
+            litLen = getFixedTables().litLen;
+            dist = getFixedTables().dist;
+
+        } else if (blockType == 2) {
+            c_u32 litLenCount = readBits(5) + 257;
+            c_u32 distCount = readBits(5) + 1;
+            c_u32 codeLenCount = readBits(4) + 4;
+            if (litLenCount > 286 || distCount > 30) {
+                return DECOMPRESS;
+            }
+
+            u8 codeLenLengths[19] = {};
+            for (u32 index = 0; index < codeLenCount; index++) {
+                if (bitCount < 3) { refill(); }
+                codeLenLengths[CODELEN_ORDER[index]] = static_cast<u8>(readBits(3));
+            }
+            Entry codeLenTable[1U << CODELEN_TABLE_BITS];
+            if (!buildTable(codeLenTable, CODELEN_TABLE_BITS, codeLenLengths, 19, getCodeLenEntry)) {
+                return DECOMPRESS;
+            }
+
+            // the lengths of both codes are read as one list, repeats may cross from one into the other
+            u8 lengths[286 + 30];
+            u32 index = 0;
+            while (index < litLenCount + distCount) {
+                // 7 bits of code and 7 extra bits at most
+                if (bitCount < 14) { refill(); }
+                const Entry entry = decode(codeLenTable, CODELEN_TABLE_BITS);
+                if (entry.kind == 0) {
+                    return DECOMPRESS;
+                }
+                if (entry.value < 16) {
+                    lengths[index++] = static_cast<u8>(entry.value);
+                    continue;
+                }
+                u8 repeated = 0;
+                u32 repeatCount;
+                if (entry.value == 16) {
+                    if (index == 0) {
+                        return DECOMPRESS;
+                    }
+                    repeated = lengths[index - 1];
+                    repeatCount = 3 + readBits(2);
+                } else if (entry.value == 17) {
+                    repeatCount = 3 + readBits(3);
+                } else {
+                    repeatCount = 11 + readBits(7);
+                }
+                if (index + repeatCount > litLenCount + distCount) {
+                    return DECOMPRESS;
+                }
+                std::memset(lengths + index, repeated, repeatCount);
+                index += repeatCount;
+            }
+
+            if (!buildTable(litLenTable, LITLEN_TABLE_BITS, lengths, litLenCount, getLitLenEntry)
+                || !buildTable(distTable, DIST_TABLE_BITS, lengths + litLenCount, distCount, getDistEntry)) {
+                return DECOMPRESS;
+            }
+
+        } else {
+            return DECOMPRESS;
+        }
+
+        while (true) {
+            if (bitCount < MAX_SYMBOL_BITS) { refill(); }
+            const Entry entry = decode(litLen, LITLEN_TABLE_BITS);
+
+            if (entry.kind == KIND_LITERAL) {
+                if (out == outEnd) {
+                    return DECOMPRESS;
+                }
+                *out++ = static_cast<u8>(entry.value);
+                continue;
+            }
+            if (entry.kind == KIND_END) {
+                break;
+            }
+            if (entry.kind == 0) {
+                return DECOMPRESS;
+            }
+
+            c_u32 length = entry.value + readBits(entry.kind & 0x0F);
+            const Entry distEntry = decode(dist, DIST_TABLE_BITS);
+            if (distEntry.kind == 0) {
+                return DECOMPRESS;
+            }
+            c_u32 distance = distEntry.value + readBits(distEntry.kind & 0x0F);
+            if (distance > out - theOut || length > outEnd - out) {
+                return DECOMPRESS;
+            }
+
+            // there is room to write past the match, which the next symbols write over
+            if (outEnd - out >= length + 16) {
+                copyMatch(out, distance, length);
+            } else {
+                c_u8* src = out - distance;
+                for (u32 index = 0; index < length; index++) {
+                    out[index] = src[index];
+                }
+            }
+            out += length;
+        }
+
+        if (overrun > bitCount >> 3) {
+            return DECOMPRESS;
+        }
+    }
+
+    theOutSize = static_cast<u32>(out - theOut);
+    return SUCCESS;
+}
+
+
+int fastZlibInflate(u8* theOut, u32& theOutSize, c_u8* theIn, c_u32 theInSize) {
+    c_u32 capacity = theOutSize;
+    theOutSize = 0;
+    // a 2 byte header and a 4 byte adler32
+    if (theInSize < 6) {
+        return DECOMPRESS;
+    }
+    c_u32 cmf = theIn[0];
+    c_u32 flg = theIn[1];
+    if ((cmf * 256 + flg) % 31 != 0     // header checksum
+        || (cmf & 0x0F) != 8            // deflate
+        || cmf >> 4 > 7                 // window size
+        || (flg & 0x20) != 0) {         // preset dictionary
+        return DECOMPRESS;
+    }
+
+    c_u8* trailer = theIn + theInSize - 4;
+    c_u32 expected = static_cast<u32>(trailer[0]) << 24 | trailer[1] << 16 | trailer[2] << 8 | trailer[3];
+
+    u32 size = capacity;
+    if (c_int status = fastInflate(theOut, size, theIn + 2, theInSize - 6); status != SUCCESS) {
+        return status;
+    }
+    if (adler32(1, theOut, size) != expected) {
+        return DECOMPRESS;
+    }
+    theOutSize = size;
+    return SUCCESS;
+}
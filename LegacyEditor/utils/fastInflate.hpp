@@ -0,0 +1,25 @@
+#pragma once
+
+#include "lce/processor.hpp"
+
+
+/**
+ * Inflates a raw deflate stream, as PS3 chunks and listings are stored.
+ * \n\n
+ * Codes are looked up in two level tables with a 64-bit bit buffer that is refilled
+ * eight bytes at a time, and matches are copied 16 bytes at a time, so it runs several
+ * times faster than tinf while giving the same output.
+ * @param theOutSize the size of "theOut"; set to how many bytes were inflated, or 0 on an error
+ * @return SUCCESS, or DECOMPRESS if the stream is invalid or does not fit in "theOut"
+ */
+MU ND int fastInflate(u8* theOut, u32& theOutSize, c_u8* theIn, u32 theInSize);
+
+
+/**
+ * Inflates a zlib stream (a 2 byte header, raw deflate, then an adler32 of the output),
+ * as every other console stores its chunks and listings.
+ * @param theOutSize the size of "theOut"; set to how many bytes were inflated, or 0 on an error
+ * @return SUCCESS, or DECOMPRESS if the stream is invalid, its checksum does not match,
+ *         or it does not fit in "theOut"
+ */
+MU ND int fastZlibInflate(u8* theOut, u32& theOutSize, c_u8* theIn, u32 theInSize);
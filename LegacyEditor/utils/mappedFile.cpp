@@ -0,0 +1,120 @@
+#include "mappedFile.hpp"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "LegacyEditor/utils/error_status.hpp"
+#include "LegacyEditor/utils/timer.hpp"
+
+
+#ifdef _WIN32
+
+
+int MappedFile::open(const fs::path& theFilePath) {
+    const StageTimer timer(STAGE::FILE_IO);
+    close();
+
+    HANDLE file = CreateFileW(theFilePath.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return FILE_ERROR;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0 || fileSize.QuadPart > UINT32_MAX) {
+        CloseHandle(file);
+        return FILE_ERROR;
+    }
+
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+        CloseHandle(file);
+        return FILE_ERROR;
+    }
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+    if (view == nullptr) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return FILE_ERROR;
+    }
+
+    myFileHandle = file;
+    myMappingHandle = mapping;
+    myData = static_cast<u8*>(view);
+    mySize = static_cast<u32>(fileSize.QuadPart);
+    return SUCCESS;
+}
+
+
+void MappedFile::close() {
+    if (myData != nullptr) {
+        UnmapViewOfFile(myData);
+    }
+    if (myMappingHandle != nullptr) {
+        CloseHandle(myMappingHandle);
+    }
+    if (myFileHandle != nullptr) {
+        CloseHandle(myFileHandle);
+    }
+    myFileHandle = nullptr;
+    myMappingHandle = nullptr;
+    myData = nullptr;
+    mySize = 0;
+}
+
+
+#else
+
+
+int MappedFile::open(const fs::path& theFilePath) {
+    const StageTimer timer(STAGE::FILE_IO);
+    close();
+
+    c_int file = ::open(theFilePath.string().c_str(), O_RDONLY);
+    if (file == -1) {
+        return FILE_ERROR;
+    }
+
+    struct stat fileStat{};
+    if (fstat(file, &fileStat) != 0 || fileStat.st_size == 0 || fileStat.st_size > UINT32_MAX) {
+        ::close(file);
+        return FILE_ERROR;
+    }
+
+    void* view = mmap(nullptr, fileStat.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+    // the mapping keeps its own reference to the file
+    ::close(file);
+    if (view == MAP_FAILED) {
+        return FILE_ERROR;
+    }
+    madvise(view, fileStat.st_size, MADV_SEQUENTIAL);
+
+    myData = static_cast<u8*>(view);
+    mySize = static_cast<u32>(fileStat.st_size);
+    return SUCCESS;
+}
+
+
+void MappedFile::close() {
+    if (myData != nullptr) {
+        munmap(myData, mySize);
+    }
+    myData = nullptr;
+    mySize = 0;
+}
+
+
+#endif
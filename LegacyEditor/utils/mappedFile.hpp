@@ -0,0 +1,37 @@
+#pragma once
+
+#include "include/ghc/fs_std.hpp"
+
+#include "lce/processor.hpp"
+
+
+/**
+ * A file mapped into memory as a private, copy-on-write view.
+ * \n\n
+ * The view is writable and parsers do modify the bytes in place, but the writes never reach
+ * the file on disk; only the pages that are written to get copied.
+ * Anything pointing into the mapping is only valid until "close" is called.
+ */
+class MappedFile {
+    u8* myData = nullptr;
+    u32 mySize = 0;
+#ifdef _WIN32
+    void* myFileHandle = nullptr;
+    void* myMappingHandle = nullptr;
+#endif
+
+public:
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /// maps the whole file, closing any file that was already mapped.
+    ND int open(const fs::path& theFilePath);
+    void close();
+
+    ND bool isOpen() const { return myData != nullptr; }
+    ND u8* start() const { return myData; }
+    ND u32 getSize() const { return mySize; }
+};
@@ -1,5 +1,6 @@
 #include "timer.hpp"
 
+#include <atomic>
 #include <chrono>
 
 
@@ -27,4 +28,106 @@ Timer::Timer() {
     static constexpr int NANO_TO_SEC = 1000000000;
     const uint64_t end = getNanoSeconds();
     return static_cast<float>(end - time) / static_cast<float>(NANO_TO_SEC);
-}
\ No newline at end of file
+}
+
+// #####################################################
+// #               Stage Timer
+// #####################################################
+
+
+static constexpr int STAGE_COUNT = static_cast<int>(STAGE::COUNT);
+
+static std::atomic<bool> stagesEnabled = false;
+static std::atomic<uint64_t> stageNanos[STAGE_COUNT] = {};
+static std::atomic<uint64_t> stageCounts[STAGE_COUNT] = {};
+
+/// the innermost timer running on this thread
+static thread_local StageTimer* currentStage = nullptr;
+
+
+static uint64_t getSteadyNanoSeconds() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+StageTimer::StageTimer(const STAGE theStage) : myStage(theStage) {
+    myIsActive = stagesEnabled.load(std::memory_order_relaxed);
+    if (!myIsActive) {
+        return;
+    }
+    myStart = getSteadyNanoSeconds();
+    myParent = currentStage;
+    if (myParent != nullptr) {
+        myParent->pause(myStart);
+    }
+    currentStage = this;
+}
+
+
+StageTimer::~StageTimer() {
+    if (!myIsActive) {
+        return;
+    }
+    const uint64_t now = getSteadyNanoSeconds();
+    pause(now);
+    const int index = static_cast<int>(myStage);
+    stageNanos[index].fetch_add(myElapsed, std::memory_order_relaxed);
+    stageCounts[index].fetch_add(1, std::memory_order_relaxed);
+
+    currentStage = myParent;
+    if (myParent != nullptr) {
+        myParent->resume(now);
+    }
+}
+
+
+void StageTimer::pause(const uint64_t theNow) {
+    myElapsed += theNow - myStart;
+}
+
+
+void StageTimer::resume(const uint64_t theNow) {
+    myStart = theNow;
+}
+
+
+void StageTimer::setEnabled(const bool theIsEnabled) {
+    stagesEnabled.store(theIsEnabled, std::memory_order_relaxed);
+}
+
+
+bool StageTimer::isEnabled() {
+    return stagesEnabled.load(std::memory_order_relaxed);
+}
+
+
+void StageTimer::reset() {
+    for (int i = 0; i < STAGE_COUNT; i++) {
+        stageNanos[i].store(0, std::memory_order_relaxed);
+        stageCounts[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+
+double StageTimer::getSeconds(const STAGE theStage) {
+    return static_cast<double>(stageNanos[static_cast<int>(theStage)].load()) / 1e9;
+}
+
+
+uint64_t StageTimer::getCount(const STAGE theStage) {
+    return stageCounts[static_cast<int>(theStage)].load();
+}
+
+
+const char* StageTimer::getName(const STAGE theStage) {
+    switch (theStage) {
+        case STAGE::INFLATE: return "inflate";
+        case STAGE::RLE: return "rle";
+        case STAGE::CHUNK_PARSE: return "chunk_parse";
+        case STAGE::CHUNK_WRITE: return "chunk_write";
+        case STAGE::DEFLATE: return "deflate";
+        case STAGE::FILE_IO: return "file_io";
+        case STAGE::COUNT:
+        default: return "unknown";
+    }
+}
@@ -13,4 +13,51 @@ class [[maybe_unused]] Timer {
 public:
     Timer();
     [[maybe_unused]] [[nodiscard]] float getSeconds() const;
-};
\ No newline at end of file
+};
+
+
+/// The hot paths of loading and converting a save, see StageTimer.
+enum class STAGE : uint8_t {
+    INFLATE,
+    RLE,
+    CHUNK_PARSE,
+    CHUNK_WRITE,
+    DEFLATE,
+    FILE_IO,
+    COUNT
+};
+
+
+/**
+ * Adds the time spent in its scope to a STAGE, summed over all threads.
+ * \n\n
+ * Timers nest: an outer timer is paused while an inner one runs, so each
+ * nanosecond is charged to exactly one stage. Disabled by default, in which
+ * case a timer only costs a load of a flag.
+ */
+class StageTimer {
+    StageTimer* myParent = nullptr;
+    uint64_t myStart = 0;
+    uint64_t myElapsed = 0;
+    STAGE myStage;
+    bool myIsActive;
+
+    void pause(uint64_t theNow);
+    void resume(uint64_t theNow);
+
+public:
+    explicit StageTimer(STAGE theStage);
+    ~StageTimer();
+
+    StageTimer(const StageTimer&) = delete;
+    StageTimer& operator=(const StageTimer&) = delete;
+
+    static void setEnabled(bool theIsEnabled);
+    [[nodiscard]] static bool isEnabled();
+    /// Not thread safe, call it while no timer is running.
+    static void reset();
+
+    [[nodiscard]] static double getSeconds(STAGE theStage);
+    [[nodiscard]] static uint64_t getCount(STAGE theStage);
+    [[nodiscard]] static const char* getName(STAGE theStage);
+};
@@ -0,0 +1,190 @@
+#include "writeStream.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "LegacyEditor/utils/RLE/rle_scan.hpp"
+#include "LegacyEditor/utils/error_status.hpp"
+#include "LegacyEditor/utils/timer.hpp"
+
+
+// #####################################################
+// #               File
+// #####################################################
+
+
+int FileWriteStream::open(const fs::path& theFilePath) {
+    const StageTimer timer(STAGE::FILE_IO);
+    close();
+    myFile = fopen(theFilePath.string().c_str(), "wb");
+    if (myFile == nullptr) {
+        return FILE_ERROR;
+    }
+    mySize = 0;
+    myCrc = crc32(0, nullptr, 0);
+    return SUCCESS;
+}
+
+
+void FileWriteStream::close() {
+    if (myFile != nullptr) {
+        fclose(myFile);
+        myFile = nullptr;
+    }
+}
+
+
+int FileWriteStream::write(c_u8* theData, c_u32 theSize) {
+    const StageTimer timer(STAGE::FILE_IO);
+    if (myFile == nullptr || fwrite(theData, 1, theSize, myFile) != theSize) {
+        return FILE_ERROR;
+    }
+    myCrc = crc32(myCrc, theData, theSize);
+    mySize += theSize;
+    return SUCCESS;
+}
+
+
+int FileWriteStream::finish() {
+    const StageTimer timer(STAGE::FILE_IO);
+    if (myFile == nullptr) {
+        return FILE_ERROR;
+    }
+    c_int status = fclose(myFile);
+    myFile = nullptr;
+    return status == 0 ? SUCCESS : FILE_ERROR;
+}
+
+
+// #####################################################
+// #               Zlib
+// #####################################################
+
+
+ZlibWriteStream::ZlibWriteStream(WriteStream& theOut, c_int theLevel)
+    : myOut(theOut), myBuffer(BUFFER_SIZE) {
+    myIsInitialized = deflateInit(&myStream, theLevel) == Z_OK;
+}
+
+
+ZlibWriteStream::~ZlibWriteStream() {
+    if (myIsInitialized) {
+        deflateEnd(&myStream);
+    }
+}
+
+
+/// Runs deflate until it has taken all the input, passing the output on as the buffer fills.
+int ZlibWriteStream::deflateInto(c_int theFlush) {
+    int status;
+    do {
+        myStream.next_out = myBuffer.data();
+        myStream.avail_out = BUFFER_SIZE;
+        status = deflate(&myStream, theFlush);
+        if (status == Z_STREAM_ERROR) {
+            return COMPRESS;
+        }
+        if (c_u32 produced = BUFFER_SIZE - myStream.avail_out; produced != 0) {
+            if (c_int writeStatus = myOut.write(myBuffer.data(), produced); writeStatus != SUCCESS) {
+                return writeStatus;
+            }
+        }
+    } while (myStream.avail_out == 0);
+
+    if (theFlush == Z_FINISH && status != Z_STREAM_END) {
+        return COMPRESS;
+    }
+    return SUCCESS;
+}
+
+
+int ZlibWriteStream::write(c_u8* theData, c_u32 theSize) {
+    const StageTimer timer(STAGE::DEFLATE);
+    if (!myIsInitialized) {
+        return COMPRESS;
+    }
+    myStream.next_in = const_cast<u8*>(theData);
+    myStream.avail_in = theSize;
+    return deflateInto(Z_NO_FLUSH);
+}
+
+
+int ZlibWriteStream::finish() {
+    const StageTimer timer(STAGE::DEFLATE);
+    if (!myIsInitialized) {
+        return COMPRESS;
+    }
+    myStream.next_in = nullptr;
+    myStream.avail_in = 0;
+    return deflateInto(Z_FINISH);
+}
+
+
+// #####################################################
+// #               Vita RLE
+// #####################################################
+
+
+int RLEVitaWriteStream::flushBuffer() {
+    c_int status = myOut.write(myBuffer.data(), myBufferSize);
+    myBufferSize = 0;
+    return status;
+}
+
+
+/// Writes the run of zeros that just ended, split into runs of at most 255.
+int RLEVitaWriteStream::writeZeros() {
+    while (myZeroCount != 0) {
+        if (myBufferSize + 2 > BUFFER_SIZE) {
+            if (c_int status = flushBuffer(); status != SUCCESS) {
+                return status;
+            }
+        }
+        c_u32 count = std::min(myZeroCount, 255U);
+        myBuffer[myBufferSize++] = 0;
+        myBuffer[myBufferSize++] = count;
+        myZeroCount -= count;
+    }
+    return SUCCESS;
+}
+
+
+int RLEVitaWriteStream::write(c_u8* theData, c_u32 theSize) {
+    const StageTimer timer(STAGE::RLE);
+    u32 index = 0;
+    while (index < theSize) {
+        c_u32 zeros = RLE_countRun(theData + index, theSize - index, 0);
+        myZeroCount += zeros;
+        index += zeros;
+        if (index == theSize) {
+            break; // the run may go on in the next write
+        }
+        if (c_int status = writeZeros(); status != SUCCESS) {
+            return status;
+        }
+
+        u32 literals = RLE_countUntil(theData + index, theSize - index, 0);
+        while (literals != 0) {
+            if (myBufferSize == BUFFER_SIZE) {
+                if (c_int status = flushBuffer(); status != SUCCESS) {
+                    return status;
+                }
+            }
+            c_u32 count = std::min(literals, BUFFER_SIZE - myBufferSize);
+            std::memcpy(myBuffer.data() + myBufferSize, theData + index, count);
+            myBufferSize += count;
+            index += count;
+            literals -= count;
+        }
+    }
+    return SUCCESS;
+}
+
+
+int RLEVitaWriteStream::finish() {
+    const StageTimer timer(STAGE::RLE);
+    if (c_int status = writeZeros(); status != SUCCESS) {
+        return status;
+    }
+    return flushBuffer();
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdio>
+
+#include "include/ghc/fs_std.hpp"
+#include "include/zlib-1.2.12/zlib.h"
+
+#include "lce/processor.hpp"
+
+
+/**
+ * Sequential output that a save is written into piece by piece,
+ * so it never has to be built (or compressed) in memory as a whole.
+ * \n\n
+ * Streams are chained: an encoder passes what it produces on to the stream it wraps.
+ */
+class WriteStream {
+public:
+    /// Size of the buffer that the encoders collect their output in.
+    static constexpr u32 BUFFER_SIZE = 256 * 1024;
+
+    virtual ~WriteStream() = default;
+
+    ND virtual int write(c_u8* theData, u32 theSize) = 0;
+
+    /// Writes out anything still held by this stream; the stream it wraps is left open.
+    ND virtual int finish() = 0;
+};
+
+
+/// Writes straight to a file, keeping the size and the crc32 of everything written.
+class FileWriteStream final : public WriteStream {
+    FILE* myFile = nullptr;
+    u32 mySize = 0;
+    u32 myCrc = 0;
+
+public:
+    FileWriteStream() = default;
+    ~FileWriteStream() override { close(); }
+
+    FileWriteStream(const FileWriteStream&) = delete;
+    FileWriteStream& operator=(const FileWriteStream&) = delete;
+
+    ND int open(const fs::path& theFilePath);
+    void close();
+
+    ND int write(c_u8* theData, u32 theSize) override;
+    /// Flushes and closes the file.
+    ND int finish() override;
+
+    ND u32 getSize() const { return mySize; }
+    ND u32 getCrc() const { return myCrc; }
+};
+
+
+/// Deflates into a zlib stream, the same as "compress" would for the whole input.
+class ZlibWriteStream final : public WriteStream {
+    WriteStream& myOut;
+    z_stream myStream{};
+    u8_vec myBuffer;
+    bool myIsInitialized = false;
+
+    int deflateInto(int theFlush);
+
+public:
+    explicit ZlibWriteStream(WriteStream& theOut, int theLevel = Z_DEFAULT_COMPRESSION);
+    ~ZlibWriteStream() override;
+
+    ZlibWriteStream(const ZlibWriteStream&) = delete;
+    ZlibWriteStream& operator=(const ZlibWriteStream&) = delete;
+
+    ND int write(c_u8* theData, u32 theSize) override;
+    ND int finish() override;
+};
+
+
+/**
+ * Encodes with the vita's zero RLE (see RLEVITA_COMPRESS); a run of zeros
+ * may span several writes and is encoded the same as if it had not.
+ */
+class RLEVitaWriteStream final : public WriteStream {
+    WriteStream& myOut;
+    u8_vec myBuffer;
+    u32 myBufferSize = 0;
+    u32 myZeroCount = 0;
+
+    int flushBuffer();
+    int writeZeros();
+
+public:
+    explicit RLEVitaWriteStream(WriteStream& theOut) : myOut(theOut), myBuffer(BUFFER_SIZE) {}
+
+    ND int write(c_u8* theData, u32 theSize) override;
+    ND int finish() override;
+};
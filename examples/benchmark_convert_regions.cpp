@@ -0,0 +1,108 @@
+#include <thread>
+
+#include "include/ghc/fs_std.hpp"
+
+#include "lce/processor.hpp"
+
+#include "LegacyEditor/code/include.hpp"
+#include "LegacyEditor/utils/timer.hpp"
+
+
+/// FNV-1a over every region file, used to check that each thread count writes the same bytes.
+static u64 hashRegions(const editor::FileListing& theListing) {
+    u64 hash = 14695981039346656037ULL;
+    for (const editor::FileList* fileList : theListing.ptrs.dimFileLists) {
+        for (const editor::LCEFile* file : *fileList) {
+            for (u32 i = 0; i < file->data.size; i++) {
+                hash = (hash ^ file->data.data[i]) * 1099511628211ULL;
+            }
+            hash = (hash ^ file->data.size) * 1099511628211ULL;
+        }
+    }
+    return hash;
+}
+
+
+static u64 getRegionBytes(const editor::FileListing& theListing, size_t& theFileCount) {
+    u64 total = 0;
+    theFileCount = 0;
+    for (const editor::FileList* fileList : theListing.ptrs.dimFileLists) {
+        for (const editor::LCEFile* file : *fileList) {
+            total += file->data.size;
+            theFileCount++;
+        }
+    }
+    return total;
+}
+
+
+/**
+ * Times FileListing::convertRegions on each save for several thread counts.
+ * \n
+ * usage: benchmark_convert_regions [save files...]
+ * \n
+ * With no arguments, the sample saves under "tests/" are used.
+ */
+int main(int argc, char *argv[]) {
+    // the sample saves are zlib; a console with another codec keeps them from being passed through
+    constexpr auto consoleOut = lce::CONSOLE::RPCS3;
+    constexpr int REPEAT_COUNT = 3;
+
+    std::vector<fs::path> saves;
+    for (int i = 1; i < argc; i++) {
+        saves.emplace_back(argv[i]);
+    }
+    if (saves.empty()) {
+        saves.emplace_back(R"(tests/PS4/folder/00000008/savedata0/GAMEDATA)");
+        saves.emplace_back(R"(tests/PS4/superflatTest/00000002/savedata0/GAMEDATA)");
+        saves.emplace_back(R"(tests/VITA/PCSE00491/PCSE00491-240725153321/GAMEDATA.bin)");
+    }
+
+    std::vector<u32> threadCounts = {1, 2, 4, 8};
+    c_u32 hardwareThreads = std::max(1U, std::thread::hardware_concurrency());
+    if (hardwareThreads > threadCounts.back()) {
+        threadCounts.push_back(hardwareThreads);
+    }
+
+    printf("save,threads,region_files,region_mb,seconds,mb_per_sec,files_per_sec,identical\n");
+    for (const fs::path& save : saves) {
+        u64 serialHash = 0;
+
+        for (c_u32 threadCount : threadCounts) {
+            float bestSeconds = 0.0F;
+            u64 regionBytes = 0;
+            size_t fileCount = 0;
+            bool isIdentical = true;
+
+            for (int repeat = 0; repeat < REPEAT_COUNT; repeat++) {
+                editor::FileListing fileListing;
+                if (int status = fileListing.read(save); status != 0) {
+                    return printf_err(status, "failed to load file '%s'\n", save.string().c_str());
+                }
+                regionBytes = getRegionBytes(fileListing, fileCount);
+
+                const Timer timer;
+                fileListing.convertRegions(consoleOut, threadCount);
+                c_auto seconds = timer.getSeconds();
+                if (repeat == 0 || seconds < bestSeconds) {
+                    bestSeconds = seconds;
+                }
+
+                c_u64 hash = hashRegions(fileListing);
+                if (threadCount == threadCounts.front() && repeat == 0) {
+                    serialHash = hash;
+                }
+                isIdentical &= hash == serialHash;
+            }
+
+            const double megabytes = static_cast<double>(regionBytes) / (1024.0 * 1024.0);
+            const double seconds = bestSeconds > 0.0F ? bestSeconds : 1e-9;
+            printf("%s,%u,%zu,%.3f,%.4f,%.2f,%.2f,%s\n",
+                   save.filename().string().c_str(), threadCount, fileCount, megabytes, seconds,
+                   megabytes / seconds, static_cast<double>(fileCount) / seconds,
+                   isIdentical ? "yes" : "NO");
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,434 @@
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#define PSAPI_VERSION 2
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include "include/ghc/fs_std.hpp"
+
+#include "lce/processor.hpp"
+
+#include "LegacyEditor/code/include.hpp"
+#include "LegacyEditor/utils/timer.hpp"
+
+
+#ifndef LCEDIT_TESTS_DIR
+#define LCEDIT_TESTS_DIR "tests"
+#endif
+
+
+/// consoles that FileListing::write can produce a save for
+static constexpr lce::CONSOLE CONSOLES_OUT[] = {
+        lce::CONSOLE::WIIU,
+        lce::CONSOLE::VITA,
+        lce::CONSOLE::RPCS3,
+};
+
+/// chunk rows: the name of the pipeline, and the parts of each chunk that it reads
+static constexpr std::pair<const char*, u8> CHUNK_PIPELINES[] = {
+        {"chunks", editor::chunk::READ_ALL},
+        {"surface", editor::chunk::READ_HEIGHTMAP | editor::chunk::READ_BIOMES},
+};
+
+static constexpr STAGE STAGES[] = {
+        STAGE::INFLATE, STAGE::RLE, STAGE::CHUNK_PARSE,
+        STAGE::CHUNK_WRITE, STAGE::DEFLATE, STAGE::FILE_IO,
+};
+
+
+// #####################################################
+// #               Memory
+// #####################################################
+
+
+/// Lets the next getPeakRSS only see what happens from now on; only linux supports this.
+static void resetPeakRSS() {
+#ifdef __GLIBC__
+    // hand freed memory back first, or it still counts towards the next peak
+    malloc_trim(0);
+#endif
+#ifdef __linux__
+    if (FILE* f = fopen("/proc/self/clear_refs", "w"); f != nullptr) {
+        fputs("5", f);
+        fclose(f);
+    }
+#endif
+}
+
+
+/// The most memory the process has held since the last resetPeakRSS, in megabytes.
+static double getPeakRSS() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters{};
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)) == 0) {
+        return 0.0;
+    }
+    return static_cast<double>(counters.PeakWorkingSetSize) / (1024.0 * 1024.0);
+#else
+#ifdef __linux__
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.rfind("VmHWM:", 0) == 0) {
+            return std::stod(line.substr(6)) / 1024.0;
+        }
+    }
+#endif
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return static_cast<double>(usage.ru_maxrss) / (1024.0 * 1024.0);
+#else
+    return static_cast<double>(usage.ru_maxrss) / 1024.0;
+#endif
+#endif
+}
+
+
+// #####################################################
+// #               Saves
+// #####################################################
+
+
+/// Every save under "theDir" that FileListing::read can be pointed at.
+static std::vector<fs::path> findSaves(const fs::path& theDir) {
+    std::vector<fs::path> saves;
+    if (!fs::exists(theDir)) {
+        return saves;
+    }
+    for (const auto& entry : fs::recursive_directory_iterator(theDir)) {
+        if (!entry.is_regular_file()) {
+            continue;
+        }
+        const fs::path& path = entry.path();
+        const std::string name = path.filename().string();
+        if (name == "GAMEDATA" || name == "GAMEDATA.bin" || name == "SAVEGAME.dat") {
+            saves.push_back(path);
+        } else if (path.extension() == ".ext") {
+            // wiiu saves are named after their date, with a ".ext" file next to them
+            fs::path save = path;
+            save.replace_extension();
+            if (fs::exists(save)) {
+                saves.push_back(save);
+            }
+        }
+    }
+    std::sort(saves.begin(), saves.end());
+    return saves;
+}
+
+
+/// The size of every file in the listing, which is what the pipeline has to move.
+static u64 getListingBytes(const editor::FileListing& theListing) {
+    u64 total = 0;
+    for (const editor::LCEFile& file : theListing.myAllFiles) {
+        total += file.data.size;
+    }
+    return total;
+}
+
+
+/**
+ * Reads the "theReadMask" parts of every chunk of every region, and writes back the V12 ones
+ * if all of them were read; the other writers are not finished.
+ */
+static u64 readChunks(const editor::FileListing& theListing, c_u8 theReadMask) {
+    static constexpr i16 V_12 = 0x000C;
+
+    u64 chunkCount = 0;
+    for (const editor::FileList* fileList : theListing.ptrs.dimFileLists) {
+        for (const editor::LCEFile* file : *fileList) {
+            editor::RegionManager region;
+            if (region.read(file) != SUCCESS) {
+                continue;
+            }
+            for (editor::ChunkManager& chunk : region.chunks) {
+                if (chunk.size == 0) {
+                    continue;
+                }
+                chunk.readChunk(region.myConsole, theReadMask);
+                if (theReadMask == editor::chunk::READ_ALL && chunk.chunkData->lastVersion == V_12) {
+                    // an unedited chunk is not encoded again, so mark it to time the writer
+                    chunk.chunkData->isDirty = true;
+                    chunk.writeChunk(region.myConsole);
+                }
+                chunkCount++;
+            }
+        }
+    }
+    return chunkCount;
+}
+
+
+static u64 countChunks(const editor::FileListing& theListing) {
+    u64 chunkCount = 0;
+    for (const editor::FileList* fileList : theListing.ptrs.dimFileLists) {
+        for (const editor::LCEFile* file : *fileList) {
+            editor::RegionManager region;
+            if (region.read(file) != SUCCESS) {
+                continue;
+            }
+            for (const editor::ChunkManager& chunk : region.chunks) {
+                chunkCount += chunk.size != 0;
+            }
+        }
+    }
+    return chunkCount;
+}
+
+
+// #####################################################
+// #               Results
+// #####################################################
+
+
+struct Result {
+    std::string save;
+    std::string consoleIn;
+    std::string pipeline;
+    std::string consoleOut;
+    int status = SUCCESS;
+    u64 inputBytes = 0;
+    u64 listingBytes = 0;
+    u64 chunkCount = 0;
+    double readSeconds = 0.0;
+    double convertSeconds = 0.0;
+    double writeSeconds = 0.0;
+    double peakRSS = 0.0;
+    double stageSeconds[std::size(STAGES)] = {};
+
+    ND double getTotalSeconds() const {
+        return readSeconds + convertSeconds + writeSeconds;
+    }
+
+    void collectStages() {
+        for (size_t i = 0; i < std::size(STAGES); i++) {
+            stageSeconds[i] = StageTimer::getSeconds(STAGES[i]);
+        }
+    }
+};
+
+
+static void printHeader(FILE* theOut) {
+    fprintf(theOut, "save,console_in,pipeline,console_out,status,input_mb,listing_mb,chunks,"
+                    "read_s,convert_s,write_s,total_s,mb_per_sec,chunks_per_sec,peak_rss_mb");
+    for (const STAGE stage : STAGES) {
+        fprintf(theOut, ",%s_s", StageTimer::getName(stage));
+    }
+    fprintf(theOut, "\n");
+}
+
+
+static void printResult(FILE* theOut, const Result& theResult) {
+    static constexpr double MEGABYTE = 1024.0 * 1024.0;
+    const double listingMB = static_cast<double>(theResult.listingBytes) / MEGABYTE;
+    const double seconds = std::max(theResult.getTotalSeconds(), 1e-9);
+
+    fprintf(theOut, "%s,%s,%s,%s,%d,%.3f,%.3f,%llu,%.4f,%.4f,%.4f,%.4f,%.2f,%.2f,%.1f",
+            theResult.save.c_str(), theResult.consoleIn.c_str(),
+            theResult.pipeline.c_str(), theResult.consoleOut.c_str(), theResult.status,
+            static_cast<double>(theResult.inputBytes) / MEGABYTE, listingMB,
+            static_cast<unsigned long long>(theResult.chunkCount),
+            theResult.readSeconds, theResult.convertSeconds, theResult.writeSeconds, seconds,
+            listingMB / seconds, static_cast<double>(theResult.chunkCount) / seconds,
+            theResult.peakRSS);
+    for (const double stageSeconds : theResult.stageSeconds) {
+        fprintf(theOut, ",%.4f", stageSeconds);
+    }
+    fprintf(theOut, "\n");
+}
+
+
+/// Keeps whichever of the repeats was fastest overall.
+static void keepBest(Result& theBest, const Result& theResult, const bool theIsFirst) {
+    if (theIsFirst || theResult.getTotalSeconds() < theBest.getTotalSeconds()) {
+        theBest = theResult;
+    }
+}
+
+
+// #####################################################
+// #               Pipelines
+// #####################################################
+
+
+/// read -> readChunk (/ writeChunk) on every chunk, "convert" is the time spent on the chunks.
+static Result runChunks(const fs::path& theSave, const char* thePipeline, c_u8 theReadMask) {
+    Result result;
+    result.pipeline = thePipeline;
+    result.consoleOut = "-";
+
+    StageTimer::reset();
+    resetPeakRSS();
+
+    editor::FileListing listing;
+    const Timer readTimer;
+    result.status = listing.read(theSave);
+    result.readSeconds = readTimer.getSeconds();
+    if (result.status != SUCCESS) {
+        return result;
+    }
+    result.consoleIn = lce::consoleToStr(listing.myReadSettings.getConsole());
+    result.listingBytes = getListingBytes(listing);
+
+    const Timer chunkTimer;
+    result.chunkCount = readChunks(listing, theReadMask);
+    result.convertSeconds = chunkTimer.getSeconds();
+
+    result.peakRSS = getPeakRSS();
+    result.collectStages();
+    return result;
+}
+
+
+/// read -> convertRegions -> write. write converts as well, but by then every region is already in "theConsoleOut".
+static Result runConvert(const fs::path& theSave, const lce::CONSOLE theConsoleOut,
+                         const fs::path& theOutDir, c_u32 theThreadCount, c_u64 theChunkCount) {
+    Result result;
+    result.pipeline = "convert";
+    result.consoleOut = lce::consoleToStr(theConsoleOut);
+    result.chunkCount = theChunkCount;
+
+    fs::remove_all(theOutDir);
+    fs::create_directories(theOutDir);
+    StageTimer::reset();
+    resetPeakRSS();
+
+    editor::FileListing listing;
+    const Timer readTimer;
+    result.status = listing.read(theSave);
+    result.readSeconds = readTimer.getSeconds();
+    if (result.status != SUCCESS) {
+        return result;
+    }
+    result.consoleIn = lce::consoleToStr(listing.myReadSettings.getConsole());
+    result.listingBytes = getListingBytes(listing);
+
+    const Timer convertTimer;
+    listing.convertRegions(theConsoleOut, theThreadCount);
+    result.convertSeconds = convertTimer.getSeconds();
+
+    editor::WriteSettings settings(theConsoleOut, theOutDir);
+    settings.myProductCodes.setPS3(editor::ePS3ProductCode::NPUB31419);
+    settings.myProductCodes.setPS4(editor::ePS4ProductCode::CUSA00744);
+    settings.myProductCodes.setVITA(editor::eVITAProductCode::PCSE00491);
+    settings.setThreadCount(theThreadCount);
+    const Timer writeTimer;
+    result.status = listing.write(settings);
+    result.writeSeconds = writeTimer.getSeconds();
+
+    result.peakRSS = getPeakRSS();
+    result.collectStages();
+    return result;
+}
+
+
+/**
+ * Times every stage of loading and converting the sample saves, so that
+ * a regression in any of the hot paths shows up as a number.
+ * \n
+ * usage: benchmark_pipeline [-o results.csv] [-t threads] [-r repeats] [save files...]
+ * \n
+ * With no saves given, every save found under "tests/" is used.
+ * Run it from the build folder, writing a save needs the assets copied there. Each save gets a
+ * "chunks" row (every chunk is read and written back), a "surface" row (only the height
+ * maps and biomes are read) and a "convert" row per console in CONSOLES_OUT.
+ * Rows are CSV, the fastest of the repeats is kept.
+ * \n\n
+ * The stage columns are summed over all threads, so they can add up to more than
+ * total_s when converting with several threads; file reads are memory mapped, so
+ * most of their cost is paid inside the first stage that touches the data.
+ * peak_rss_mb is per row on linux, and the peak of the whole run elsewhere.
+ */
+int main(int argc, char *argv[]) {
+    fs::path csvPath = "benchmark_pipeline.csv";
+    u32 threadCount = std::max(1U, std::thread::hardware_concurrency());
+    int repeatCount = 3;
+
+    std::vector<fs::path> saves;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            csvPath = argv[++i];
+        } else if (std::strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            threadCount = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            repeatCount = std::max(1, std::atoi(argv[++i]));
+        } else {
+            saves.emplace_back(argv[i]);
+        }
+    }
+    if (saves.empty()) {
+        saves = findSaves(LCEDIT_TESTS_DIR);
+    }
+    if (saves.empty()) {
+        return printf_err(FILE_ERROR, "no saves to benchmark, pass them as arguments\n");
+    }
+
+    // library output goes to stdout, so the results are written to their own file
+    FILE* csv = fopen(csvPath.string().c_str(), "w");
+    if (csv == nullptr) {
+        return printf_err(FILE_ERROR, "failed to open \"%s\"\n", csvPath.string().c_str());
+    }
+    printHeader(csv);
+
+    const fs::path outDir = fs::temp_directory_path() / "LegacyEditor_benchmark";
+    StageTimer::setEnabled(true);
+
+    for (const fs::path& save : saves) {
+        const std::string saveName = save.generic_string();
+        c_u64 inputBytes = fs::file_size(save);
+
+        u64 chunkCount = 0;
+        {
+            editor::FileListing listing;
+            if (listing.read(save) == SUCCESS) {
+                chunkCount = countChunks(listing);
+            }
+        }
+
+        Result best;
+        for (const auto& [pipeline, readMask] : CHUNK_PIPELINES) {
+            for (int repeat = 0; repeat < repeatCount; repeat++) {
+                keepBest(best, runChunks(save, pipeline, readMask), repeat == 0);
+            }
+            best.save = saveName;
+            best.inputBytes = inputBytes;
+            printResult(csv, best);
+            fflush(csv);
+        }
+
+        for (const lce::CONSOLE consoleOut : CONSOLES_OUT) {
+            for (int repeat = 0; repeat < repeatCount; repeat++) {
+                keepBest(best, runConvert(save, consoleOut, outDir, threadCount, chunkCount), repeat == 0);
+            }
+            best.save = saveName;
+            best.inputBytes = inputBytes;
+            printResult(csv, best);
+            fflush(csv);
+        }
+    }
+
+    fs::remove_all(outDir);
+    fclose(csv);
+
+    std::ifstream results(csvPath.string());
+    printf("\n%s", std::string(std::istreambuf_iterator<char>(results), {}).c_str());
+    return 0;
+}
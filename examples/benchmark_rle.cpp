@@ -0,0 +1,310 @@
+#include <cstring>
+#include <functional>
+
+#include "include/ghc/fs_std.hpp"
+
+#include "lce/processor.hpp"
+
+#include "LegacyEditor/code/ConsoleParser/headerUnion.hpp"
+#include "LegacyEditor/code/include.hpp"
+#include "LegacyEditor/utils/RLE/rle.hpp"
+#include "LegacyEditor/utils/RLE/rle_nsxps4.hpp"
+#include "LegacyEditor/utils/RLE/rle_scan.hpp"
+#include "LegacyEditor/utils/RLE/rle_vita.hpp"
+#include "LegacyEditor/utils/mappedFile.hpp"
+#include "LegacyEditor/utils/timer.hpp"
+
+
+/// The byte at a time versions the SIMD ones replaced, kept to compare against.
+namespace reference {
+
+    static void RLE_decompress(u8* dataIn, c_u32 sizeIn, u8* dataOut, u32& sizeOut) {
+        DataManager managerIn(dataIn, sizeIn);
+        DataManager managerOut(dataOut, sizeOut);
+        while (managerIn.getPosition() < sizeIn) {
+            if (c_u8 byte1 = managerIn.readInt8(); byte1 != 255) {
+                managerOut.writeInt8(byte1);
+            } else {
+                c_u8 byte2 = managerIn.readInt8();
+                u8 value = 255;
+                if (byte2 >= 3) {
+                    value = managerIn.readInt8();
+                }
+                for (int j = 0; j <= static_cast<int>(byte2); j++) {
+                    managerOut.writeInt8(value);
+                }
+            }
+        }
+        sizeOut = managerOut.getPosition();
+    }
+
+    static void RLE_compress(c_u8* dataIn, c_u32 sizeIn, u8* dataOut, u32& sizeOut) {
+        u32 dataIndex = 0;
+        sizeOut = 0;
+        while (dataIndex < sizeIn) {
+            c_u8 value = dataIn[dataIndex];
+            u32 count = 1;
+            while (dataIndex + count < sizeIn && dataIn[dataIndex + count] == value && count < 256) {
+                count++;
+            }
+            if (value == 255 || count >= 4) {
+                dataOut[sizeOut++] = 255;
+                dataOut[sizeOut++] = count - 1;
+                if (count >= 4) {
+                    dataOut[sizeOut++] = value;
+                }
+            } else {
+                for (u32 i = 0; i < count; ++i) {
+                    dataOut[sizeOut++] = value;
+                }
+            }
+            dataIndex += count;
+        }
+    }
+
+    static u32 RLEVITA_DECOMPRESS(u8* dataIn, c_u32 sizeIn, u8* dataOut, c_u32 sizeOut) {
+        DataManager managerIn(dataIn, sizeIn);
+        DataManager managerOut(dataOut, sizeOut);
+        while (managerIn.getPosition() < sizeIn) {
+            if (c_u8 value = managerIn.readInt8(); value != 0x00) {
+                managerOut.writeInt8(value);
+            } else {
+                c_int numZeros = managerIn.readInt8();
+                memset(managerOut.ptr, 0, numZeros);
+                managerOut.incrementPointer(numZeros);
+            }
+        }
+        return managerOut.getPosition();
+    }
+
+    static u32 RLEVITA_COMPRESS(u8* dataIn, c_u32 sizeIn, u8* dataOut, c_u32 sizeOut) {
+        DataManager managerIn(dataIn, sizeIn);
+        DataManager managerOut(dataOut, sizeOut);
+        u8 zeroCount = 0;
+        for (u32 i = 0; i < sizeIn; ++i) {
+            if (c_u8 value = managerIn.readInt8(); value != 0) {
+                if (zeroCount > 0) {
+                    managerOut.writeInt8(0);
+                    managerOut.writeInt8(zeroCount);
+                    zeroCount = 0;
+                }
+                managerOut.writeInt8(value);
+            } else {
+                zeroCount++;
+                if (zeroCount == 255 || i == sizeIn - 1) {
+                    managerOut.writeInt8(0);
+                    managerOut.writeInt8(zeroCount);
+                    zeroCount = 0;
+                }
+            }
+        }
+        return managerOut.getPosition();
+    }
+
+    static u32 RLE_NSX_OR_PS4_DECOMPRESS(u8* dataIn, c_u32 sizeIn, u8* dataOut, c_u32 sizeOut) {
+        DataManager managerIn(dataIn, sizeIn);
+        DataManager managerOut(dataOut, sizeOut);
+        while (managerIn.getPosition() < sizeIn) {
+            if (c_u8 value = managerIn.readInt8(); value != 0x00) {
+                managerOut.writeInt8(value);
+            } else {
+                int numZeros = managerIn.readInt8();
+                if (numZeros == 0) {
+                    c_int numZeros1 = managerIn.readInt8();
+                    c_int numZeros2 = managerIn.readInt8();
+                    numZeros = (numZeros1 << 8 | numZeros2) + 256;
+                }
+                memset(managerOut.ptr, 0, numZeros);
+                managerOut.incrementPointer(numZeros);
+            }
+        }
+        return managerOut.getPosition();
+    }
+
+}
+
+
+/// A set of buffers that are encoded / decoded one after another.
+struct Sample {
+    std::vector<u8_vec> raw;
+    std::vector<u8_vec> encoded;
+    u64 rawBytes = 0;
+};
+
+
+/// Every chunk of every region, both RLE'd (as stored under zlib) and fully decoded.
+static void collectChunks(const fs::path& theSave, Sample& theChunks) {
+    editor::FileListing fileListing;
+    if (fileListing.read(theSave) != 0) {
+        printf("failed to load file '%s'\n", theSave.string().c_str());
+        return;
+    }
+
+    for (const editor::FileList* fileList : fileListing.ptrs.dimFileLists) {
+        for (const editor::LCEFile* file : *fileList) {
+            editor::RegionManager region;
+            if (region.read(file) != SUCCESS) {
+                continue;
+            }
+            for (editor::ChunkManager& chunk : region.chunks) {
+                if (chunk.size == 0 || chunk.fileData.getRLEFlag() == 0) {
+                    continue;
+                }
+                chunk.ensureDecompress(file->console, true);
+                u8_vec raw(chunk.fileData.getRLESize());
+                u32 rawSize = raw.size();
+                reference::RLE_decompress(chunk.data, chunk.size, raw.data(), rawSize);
+                raw.resize(rawSize);
+
+                theChunks.encoded.emplace_back(chunk.data, chunk.data + chunk.size);
+                theChunks.rawBytes += raw.size();
+                theChunks.raw.push_back(std::move(raw));
+            }
+        }
+    }
+}
+
+
+/// The zero RLE'd listing of a Vita save, and the listing itself.
+static void collectVitaListing(const fs::path& theSave, Sample& theListing) {
+    MappedFile file;
+    if (file.open(theSave) != SUCCESS || file.getSize() < 12) {
+        printf("failed to load file '%s'\n", theSave.string().c_str());
+        return;
+    }
+    editor::HeaderUnion headerUnion{};
+    std::memcpy(&headerUnion, file.start(), 12);
+
+    u8_vec raw(headerUnion.getDestSize());
+    raw.resize(reference::RLEVITA_DECOMPRESS(file.start() + 8, file.getSize() - 8, raw.data(), raw.size()));
+    theListing.encoded.emplace_back(file.start() + 8, file.start() + file.getSize());
+    theListing.rawBytes += raw.size();
+    theListing.raw.push_back(std::move(raw));
+}
+
+
+using Codec = std::function<u32(u8* dataIn, u32 sizeIn, u8* dataOut, u32 sizeOut)>;
+
+
+/// Runs "theCodec" over every input, keeping the best of a few runs; returns the seconds taken.
+static double timeCodec(const std::vector<u8_vec>& theInputs, const std::vector<u32>& theCapacities,
+                        const Codec& theCodec, std::vector<u8_vec>& theOutputs) {
+    static constexpr int REPEAT_COUNT = 5;
+
+    theOutputs.resize(theInputs.size());
+    double bestSeconds = 0.0;
+    for (int repeat = 0; repeat < REPEAT_COUNT; repeat++) {
+        const Timer timer;
+        for (size_t i = 0; i < theInputs.size(); i++) {
+            u8_vec& output = theOutputs[i];
+            output.resize(theCapacities[i]);
+            auto* input = const_cast<u8*>(theInputs[i].data());
+            output.resize(theCodec(input, theInputs[i].size(), output.data(), output.size()));
+        }
+        c_auto seconds = static_cast<double>(timer.getSeconds());
+        if (repeat == 0 || seconds < bestSeconds) {
+            bestSeconds = seconds;
+        }
+    }
+    return bestSeconds > 0.0 ? bestSeconds : 1e-9;
+}
+
+
+static void runCodec(const char* theName, const char* theOperation, const Sample& theSample, c_bool isDecode,
+                     const Codec& theReference, const Codec& theSimd) {
+    if (theSample.raw.empty()) {
+        return;
+    }
+    const std::vector<u8_vec>& inputs = isDecode ? theSample.encoded : theSample.raw;
+    // decoders get exactly the decoded size, encoders their worst case
+    std::vector<u32> capacities;
+    for (const u8_vec& raw : theSample.raw) {
+        capacities.push_back(isDecode ? raw.size() : raw.size() * 2 + 4);
+    }
+    const double megabytes = static_cast<double>(theSample.rawBytes) / (1024.0 * 1024.0);
+
+    // the old compressors are the reference for the new ones; where there is no
+    // usable reference, the output is checked by decoding it again instead
+    std::vector<u8_vec> expected;
+    if (theReference) {
+        c_auto seconds = timeCodec(inputs, capacities, theReference, expected);
+        printf("%s,%s,reference,scalar,%.3f,%.4f,%.2f,yes\n",
+               theName, theOperation, megabytes, seconds, megabytes / seconds);
+    } else {
+        expected = isDecode ? theSample.raw : theSample.encoded;
+    }
+
+    for (const RLE_SIMD level : {RLE_SIMD::SCALAR, RLE_SIMD::SSE2, RLE_SIMD::AVX2}) {
+        RLE_setSimd(level);
+        if (RLE_getSimd() != level) {
+            continue;
+        }
+        std::vector<u8_vec> outputs;
+        c_auto seconds = timeCodec(inputs, capacities, theSimd, outputs);
+        printf("%s,%s,simd,%s,%.3f,%.4f,%.2f,%s\n",
+               theName, theOperation, RLE_getSimdName(level), megabytes, seconds, megabytes / seconds,
+               outputs == expected ? "yes" : "NO");
+    }
+}
+
+
+/**
+ * Compares the RLE codecs against the byte at a time versions they replaced.
+ * \n
+ * usage: benchmark_rle [save files...]
+ * \n
+ * Chunks are taken from every save; Vita saves also give their whole listing.
+ * With no arguments, the sample saves under "tests/" are used.
+ */
+int main(int argc, char *argv[]) {
+    std::vector<fs::path> saves;
+    for (int i = 1; i < argc; i++) {
+        saves.emplace_back(argv[i]);
+    }
+    if (saves.empty()) {
+        saves.emplace_back(R"(tests/PS4/folder/00000008/savedata0/GAMEDATA)");
+        saves.emplace_back(R"(tests/PS4/superflatTest/00000002/savedata0/GAMEDATA)");
+        saves.emplace_back(R"(tests/VITA/PCSE00491/PCSE00491-240725153321/GAMEDATA.bin)");
+    }
+
+    Sample chunks;
+    Sample vitaListing;
+    for (const fs::path& save : saves) {
+        collectChunks(save, chunks);
+        if (save.extension() == ".bin") {
+            collectVitaListing(save, vitaListing);
+        }
+    }
+
+    // there are no NSX / PS4 RLE'd files among the samples, so chunks are encoded for it
+    Sample nsxChunks;
+    nsxChunks.raw = chunks.raw;
+    nsxChunks.rawBytes = chunks.rawBytes;
+    for (const u8_vec& raw : nsxChunks.raw) {
+        u8_vec encoded(raw.size() * 2 + 4);
+        encoded.resize(RLE_NSXPS4_COMPRESS(raw.data(), raw.size(), encoded.data(), encoded.size()));
+        nsxChunks.encoded.push_back(std::move(encoded));
+    }
+
+    const Codec chunkDecodeRef = [](u8* in, c_u32 inSize, u8* out, u32 outSize) {
+        reference::RLE_decompress(in, inSize, out, outSize); return outSize; };
+    const Codec chunkDecode = [](u8* in, c_u32 inSize, u8* out, u32 outSize) {
+        RLE_decompress(in, inSize, out, outSize); return outSize; };
+    const Codec chunkEncodeRef = [](u8* in, c_u32 inSize, u8* out, u32 outSize) {
+        reference::RLE_compress(in, inSize, out, outSize); return outSize; };
+    const Codec chunkEncode = [](u8* in, c_u32 inSize, u8* out, u32 outSize) {
+        RLE_compress(in, inSize, out, outSize); return outSize; };
+
+    printf("codec,operation,impl,simd,raw_mb,seconds,mb_per_sec,identical\n");
+    runCodec("chunk", "decompress", chunks, true, chunkDecodeRef, chunkDecode);
+    runCodec("chunk", "compress", chunks, false, chunkEncodeRef, chunkEncode);
+    runCodec("vita", "decompress", vitaListing, true, reference::RLEVITA_DECOMPRESS, RLEVITA_DECOMPRESS);
+    runCodec("vita", "compress", vitaListing, false, reference::RLEVITA_COMPRESS, RLEVITA_COMPRESS);
+    runCodec("nsxps4", "decompress", nsxChunks, true, reference::RLE_NSX_OR_PS4_DECOMPRESS, RLE_NSX_OR_PS4_DECOMPRESS);
+    // the old compressor never finished, so there is nothing to time it against
+    runCodec("nsxps4", "compress", nsxChunks, false, nullptr,
+             [](u8* in, c_u32 inSize, u8* out, c_u32 outSize) {
+                 return RLE_NSXPS4_COMPRESS(in, inSize, out, outSize); });
+
+    return 0;
+}
@@ -0,0 +1,133 @@
+#include <map>
+#include <string>
+
+#include "include/ghc/fs_std.hpp"
+
+#include "lce/processor.hpp"
+
+#include "LegacyEditor/code/include.hpp"
+#include "LegacyEditor/utils/NBTReader.hpp"
+#include "LegacyEditor/utils/timer.hpp"
+
+
+using TileEntityCounts = std::map<std::string, u32>;
+
+
+/// Counts the "id" of every tile entity in a chunk, and steps over everything else.
+class TileEntityCounter final : public NBTVisitor {
+    TileEntityCounts& myCounts;
+    bool myInTileEntities = false;
+    bool myIsId = false;
+
+public:
+    explicit TileEntityCounter(TileEntityCounts& theCounts) : myCounts(theCounts) {}
+
+    NBTVisit visitTag(const NBTType theType, const std::string_view theName) override {
+        if (myInTileEntities) {
+            myIsId = theType == TAG_STRING && theName == "id";
+            return myIsId ? NBTVisit::CONTINUE : NBTVisit::SKIP;
+        }
+        // the root has no name, old NBT chunks keep their tags in "Level"
+        if ((theType == TAG_COMPOUND && (theName.empty() || theName == "Level"))
+            || (theType == TAG_LIST && theName == "TileEntities")) {
+            return NBTVisit::CONTINUE;
+        }
+        return NBTVisit::SKIP;
+    }
+
+    NBTVisit visitString(const std::string_view theValue) override {
+        if (myIsId) {
+            myCounts[std::string(theValue)]++;
+        }
+        return NBTVisit::CONTINUE;
+    }
+
+    // every other list is skipped, so these are only called for "TileEntities"
+    NBTVisit beginList(MU NBTType theElementType, MU u32 theCount) override {
+        myInTileEntities = true;
+        return NBTVisit::CONTINUE;
+    }
+
+    NBTVisit endList() override {
+        myInTileEntities = false;
+        return NBTVisit::CONTINUE;
+    }
+};
+
+
+/// Counts them by reading every chunk's NBT into a tree, to compare against.
+static void countWithTree(editor::ChunkManager& theChunk, const lce::CONSOLE theConsole, TileEntityCounts& theCounts) {
+    theChunk.readChunk(theConsole, editor::chunk::READ_NBT);
+    const NBTBase* nbt = theChunk.chunkData->viewNBTData();
+    if (nbt == nullptr || nbt->type != TAG_COMPOUND) {
+        return;
+    }
+    const NBTTagList* tileEntities = nbt->toType<NBTTagCompound>()->getListTag("TileEntities");
+    if (tileEntities == nullptr) {
+        return;
+    }
+    for (int index = 0; index < tileEntities->tagCount(); index++) {
+        if (NBTTagCompound* tileEntity = tileEntities->getCompoundTagAt(index); tileEntity != nullptr) {
+            theCounts[tileEntity->getString("id")]++;
+        }
+    }
+}
+
+
+/**
+ * Counts the tile entities of every chunk of a save by their id, once with NBTReader
+ * and once by reading the NBT of each chunk into a tree, and compares the two.
+ * \n
+ * usage: find_tile_entities <save file>
+ */
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        printf("usage: find_tile_entities <save file>\n");
+        return -1;
+    }
+    const fs::path saveIn = argv[1];
+
+    editor::FileListing fileListing;
+    if (c_int status = fileListing.read(saveIn); status != SUCCESS) {
+        return printf_err(status, "failed to load file '%s'\n", saveIn.string().c_str());
+    }
+    const lce::CONSOLE console = fileListing.myReadSettings.getConsole();
+
+    TileEntityCounts visited;
+    TileEntityCounts tree;
+    double visitSeconds = 0;
+    double treeSeconds = 0;
+    u32 chunkCount = 0;
+
+    for (const editor::FileList* fileList : fileListing.ptrs.dimFileLists) {
+        for (editor::LCEFile* file : *fileList) {
+            editor::RegionManager region;
+            region.read(file);
+            for (editor::ChunkManager& chunk : region.chunks) {
+                if (chunk.size == 0) {
+                    continue;
+                }
+                chunk.ensureDecompress(console);
+                chunkCount++;
+
+                const Timer visitTimer;
+                TileEntityCounter counter(visited);
+                if (chunk.visitNBT(console, counter) != SUCCESS) {
+                    printf("chunk %u has corrupt NBT\n", chunkCount);
+                }
+                visitSeconds += visitTimer.getSeconds();
+
+                const Timer treeTimer;
+                countWithTree(chunk, console, tree);
+                treeSeconds += treeTimer.getSeconds();
+            }
+        }
+    }
+
+    for (const auto& [id, count] : visited) {
+        printf("%6u %s\n", count, id.c_str());
+    }
+    printf("%u chunks, NBTReader %.4fs, tree %.4fs, %s\n", chunkCount, visitSeconds, treeSeconds,
+           visited == tree ? "same counts" : "DIFFERENT counts");
+    return visited == tree ? 0 : -1;
+}
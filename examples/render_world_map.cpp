@@ -0,0 +1,44 @@
+#include <thread>
+
+#include "include/ghc/fs_std.hpp"
+
+#include "lce/processor.hpp"
+
+#include "LegacyEditor/code/include.hpp"
+#include "LegacyEditor/utils/timer.hpp"
+
+
+/**
+ * Renders a top down map of every dimension of a save into "<out folder>/<dimension>/<zoom>/<x>_<z>.png".
+ * Running it again on the same folder only renders the regions that changed.
+ * \n
+ * usage: render_world_map <save file> [out folder] [threads]
+ */
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        printf("usage: render_world_map <save file> [out folder] [threads]\n");
+        return -1;
+    }
+    const fs::path saveIn = argv[1];
+    const fs::path outDir = argc > 2 ? fs::path(argv[2]) : fs::path("world_map");
+    c_u32 threadCount = argc > 3 ? static_cast<u32>(std::stoul(argv[3]))
+                                 : std::max(1U, std::thread::hardware_concurrency());
+
+    editor::FileListing fileListing;
+    int status = fileListing.read(saveIn);
+    if (status != SUCCESS) {
+        return printf_err(status, "failed to load file '%s'\n", saveIn.string().c_str());
+    }
+
+    const Timer timer;
+    editor::map::WorldMapStats stats;
+    status = editor::map::renderWorldMap(fileListing, outDir, threadCount, &stats);
+    if (status != SUCCESS) {
+        return printf_err(status, "failed to render '%s'\n", saveIn.string().c_str());
+    }
+
+    printf("rendered %u regions, %u unchanged, %u tiles written in %.3fs\n",
+           stats.renderedRegions, stats.skippedRegions, stats.writtenTiles, timer.getSeconds());
+    printf("Finished!\nFolder Out: %s\n", outDir.string().c_str());
+    return 0;
+}
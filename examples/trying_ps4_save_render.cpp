@@ -109,6 +109,7 @@ int main() {
 
 
             chunk.chunkData->lastVersion -= 1;
+            chunk.chunkData->isDirty = true;
             chunk.writeChunk(lce::CONSOLE::WIIU); // fileListing.console);
             chunk.ensureCompressed(lce::CONSOLE::WIIU); // fileListing.console);
         }